@@ -1,4 +1,6 @@
+#include "smf_t.h"
 #include <filesystem>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -11,6 +13,5 @@ struct opts_t {
 opts_t get_options(int, char**);
 
 int event_sizes_benchmark(int, int, const std::filesystem::path&);
-int avg_and_max_event_sizes(const std::vector<std::filesystem::path>&,
-				const std::filesystem::path&, const int);
+void avg_and_max_event_sizes(const jmid::smf_t&, std::ostream&);
 
@@ -0,0 +1,188 @@
+#include "make_mtrk_event.h"
+#include "mtrk_event_t.h"
+#include "midi_vlq.h"
+#include "midi_delta_time.h"
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <iterator>
+
+//
+// Compares make_mtrk_event3() called w/ const unsigned char* (the pointer
+// fast path) to the generic template called w/ 
+// std::vector<unsigned char>::const_iterator, on a buffer of N random, valid
+// events.  The mix of events is roughly that of a typical smf:  mostly 
+// channel events (about half of which are in running status) w/ a few 
+// meta and sysex events.  
+//
+struct opts_t {
+	int64_t N;
+	int64_t N_rpts;
+};
+opts_t get_options(int, char**);
+
+int main (int argc, char *argv[]) {
+	auto opts = get_options(argc,argv);
+	std::cout << "Running make_mtrk_event3() benchmark with:\n"
+		<< "\tN == " << opts.N << " random events.\n"
+		<< "\tN_rpts == " << opts.N_rpts << " repititions of each routine\n"
+		<< std::endl;
+
+	std::cout << "Generating random events..." << std::endl;
+	std::random_device rdev;
+	std::default_random_engine re(rdev());
+	std::uniform_int_distribution<int> rd_byte(0,0x7F);
+	std::uniform_int_distribution<int> rd_pct(0,99);
+	std::geometric_distribution<int> rd_dt(0.02);
+	std::vector<unsigned char> data;
+	// Meta and sysex events cancel running status
+	bool prev_is_ch = false;
+	for (int64_t i=0; i<opts.N; ++i) {
+		jmid::write_delta_time(rd_dt(re),std::back_inserter(data));
+		auto sel = rd_pct(re);
+		if (sel < 90) {
+			if ((sel < 45) || !prev_is_ch) {  // Else in running status
+				data.push_back(0x90u);
+			}
+			data.push_back(rd_byte(re));
+			data.push_back(rd_byte(re));
+			prev_is_ch = true;
+		} else if (sel < 97) {
+			data.push_back(0xFFu);
+			data.push_back(0x01u);
+			auto len = rd_byte(re)%16;
+			jmid::write_vlq(static_cast<std::uint32_t>(len),std::back_inserter(data));
+			for (int j=0; j<len; ++j) {
+				data.push_back(rd_byte(re));
+			}
+			prev_is_ch = false;
+		} else {
+			data.push_back(0xF0u);
+			auto len = rd_byte(re);
+			jmid::write_vlq(static_cast<std::uint32_t>(len),std::back_inserter(data));
+			for (int j=0; j<len; ++j) {
+				data.push_back(rd_byte(re));
+			}
+			prev_is_ch = false;
+		}
+	}
+
+	std::array<int,2> test_func_idx {0,1};
+	std::vector<int> test_order;
+	for (int i=0; i<opts.N_rpts; ++i) {
+		std::shuffle(test_func_idx.begin(),test_func_idx.end(),re);
+		for (const auto& idx : test_func_idx) {
+			test_order.push_back(idx);
+		}
+	}
+
+	std::cout << "Starting runs..." << std::endl;
+	jmid::mtrk_event_t ev;
+	jmid::mtrk_event_error_t err;
+	uint64_t result_sum = 0;
+	int64_t n_ev_ptr = 0;  int64_t n_ev_it = 0;
+	int64_t tot_us_ptr = 0;  int64_t tot_us_it = 0;
+	for (const auto& idx : test_order) {
+		if (idx==0) {
+			std::cout << "\tStarting make_mtrk_event3(const unsigned char*):  ";
+			auto tstart = std::chrono::high_resolution_clock::now();
+			const unsigned char *it = data.data();
+			const unsigned char *end = data.data()+data.size();
+			unsigned char rs = 0x00u;
+			while (it != end) {
+				it = jmid::make_mtrk_event3(it,end,rs,&ev,&err);
+				if (err.code != jmid::mtrk_event_error_t::errc::no_error) {
+					break;
+				}
+				rs = ev.running_status();
+				result_sum += ev.data_size();
+				++n_ev_ptr;
+			}
+			auto tend = std::chrono::high_resolution_clock::now();
+			auto tdelta = std::chrono::duration_cast<std::chrono::microseconds>(tend-tstart);
+			std::cout << "Took " << tdelta.count()/1000 << " milliseconds." << std::endl;
+			tot_us_ptr += tdelta.count();
+		}
+		if (idx==1) {
+			std::cout << "\tStarting make_mtrk_event3(std::vector<unsigned char>::const_iterator):  ";
+			auto tstart = std::chrono::high_resolution_clock::now();
+			auto it = data.cbegin();
+			auto end = data.cend();
+			unsigned char rs = 0x00u;
+			while (it != end) {
+				it = jmid::make_mtrk_event3(it,end,rs,&ev,&err);
+				if (err.code != jmid::mtrk_event_error_t::errc::no_error) {
+					break;
+				}
+				rs = ev.running_status();
+				result_sum += ev.data_size();
+				++n_ev_it;
+			}
+			auto tend = std::chrono::high_resolution_clock::now();
+			auto tdelta = std::chrono::duration_cast<std::chrono::microseconds>(tend-tstart);
+			std::cout << "Took " << tdelta.count()/1000 << " milliseconds." << std::endl;
+			tot_us_it += tdelta.count();
+		}
+	}
+	std::cout << "------------------------------------\n";
+
+	auto evps = [](int64_t nev, int64_t us)->double {
+		return us > 0 ? (1000000.0*nev)/us : 0.0;
+	};
+	std::cout << "make_mtrk_event3(const unsigned char*):  " 
+		<< tot_us_ptr/1000 << " ms total; " 
+		<< evps(n_ev_ptr,tot_us_ptr) << " events/sec\n";
+	std::cout << "make_mtrk_event3(std::vector<unsigned char>::const_iterator):  " 
+		<< tot_us_it/1000 << " ms total; " 
+		<< evps(n_ev_it,tot_us_it) << " events/sec\n";
+
+	std::cout << "result_sum (ignore this) == " << result_sum << std::endl;
+
+	return 0;
+}
+
+
+opts_t get_options(int argc, char **argv) {
+	struct opts_type {
+		std::regex rx;
+		int64_t val;
+		int64_t def_val;
+	};
+	std::array<opts_type,2> opts {{
+		// The number of random events to generate
+		{std::regex("-N=(\\d+)"),-1,1'000'000},
+		// How many times each procedure should be run through the set of
+		// events.  
+		{std::regex("-Nrpts=(\\d+)"),-1,10}
+	}};
+
+	for (int i=0; i<argc; ++i) {
+		for (std::size_t j=0; j<opts.size(); ++j) {
+			std::cmatch curr_match;
+			std::regex_match(argv[i],curr_match,opts[j].rx);
+			if (curr_match.empty()) { continue; }
+			opts[j].val = std::stol(curr_match[1].str());
+			// Each argv[i] should match only one of the options in opts:
+			break;
+		}
+	}
+
+	opts_t result;
+	result.N = opts[0].val;
+	if (opts[0].val < 0) {
+		result.N = opts[0].def_val;
+	}
+	result.N_rpts = opts[1].val;
+	if (opts[1].val < 0) {
+		result.N_rpts = opts[1].def_val;
+	}
+	return result;
+}
+
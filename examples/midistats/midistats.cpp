@@ -1,10 +1,31 @@
 #include "midi_time.h"
-#include "smf_t.h"
+#include "midi_vlq.h"
+#include "smf_view_t.h"
+#include "batch_read.h"
 #include <iostream>
 #include <filesystem>
 #include <string>
 #include <algorithm>
 #include <vector>
+#include <cstdint>
+
+struct tdiv_counts_t {
+	jmid::time_division_t tdiv;
+	int count {0};
+};
+struct tempo_counts_t {
+	std::uint32_t tempo;  // us/q nt
+	int count {0};
+};
+// Each batch_read() worker accumulates its own counts; these are combined
+// once all the files have been read.  
+struct census_t {
+	std::vector<tdiv_counts_t> tdiv_counts;
+	std::vector<tempo_counts_t> tempo_counts;
+	jmid::smf_view_t smf;
+};
+void add_tdiv(std::vector<tdiv_counts_t>&, jmid::time_division_t, int);
+void add_tempo(std::vector<tempo_counts_t>&, std::uint32_t, int);
 
 int main(int argc, char *argv[]) {
 	if (argc < 2) {
@@ -17,35 +38,57 @@ int main(int argc, char *argv[]) {
 		return 1;
 	}
 
-	struct tdiv_counts_t {
-		jmid::time_division_t tdiv;
-		int count {0};
-	};
-	std::vector<tdiv_counts_t> tdiv_counts;
+	std::vector<std::filesystem::path> files;
 	auto rdi = std::filesystem::recursive_directory_iterator(p);
 	for (const auto& dir_ent : rdi) {
 		auto curr_path = dir_ent.path();
 		if (!jmid::has_midifile_extension(curr_path)) {
 			continue;
 		}
-		
+		files.push_back(curr_path);
+	}
+
+	// Each file is scanned once; map it & read it through an smf_view_t
+	// rather than materializing an smf_t.  
+	jmid::batch_read_opts_t opts;
+	opts.method = jmid::batch_read_method::mmap;
+	opts.make_smf = false;
+	std::vector<census_t> census(jmid::batch_read_nthreads(opts));
+	auto cb = [&census](const jmid::batch_read_item_t& item)->void {
+		if (item.error.code != jmid::smf_error_t::errc::no_error) {
+			return;
+		}
+		auto& curr_census = census[item.worker];
+		auto& smf = curr_census.smf;
 		jmid::smf_error_t smf_error;
-		jmid::maybe_smf_t smf = jmid::read_smf(curr_path,&smf_error,
-			std::filesystem::file_size(curr_path));
-		if (!smf) {
-			continue;
+		jmid::make_smf_view(item.data_beg,item.data_end,&smf,&smf_error);
+		if (smf_error.code != jmid::smf_error_t::errc::no_error) {
+			return;
 		}
 
-		auto curr_tdiv = smf.smf.division();
-		auto tdiv_eq = [&curr_tdiv](const tdiv_counts_t& tdivc)->bool {
-			return tdivc.tdiv==curr_tdiv;
-		};
-		auto it = std::find_if(tdiv_counts.begin(),tdiv_counts.end(),
-			tdiv_eq);
-		if (it!=tdiv_counts.end()) {
-			it->count += 1;
-		} else {
-			tdiv_counts.push_back({curr_tdiv,1});
+		for (const auto& trk : smf) {
+			for (const auto& ev : trk) {
+				if ((ev.status_byte()!=0xFFu) || (ev.get_meta().type!=0x51u)
+						|| (ev.get_meta().length!=3)) {
+					continue;
+				}
+				auto curr_tempo = jmid::read_be<std::uint32_t>(
+					ev.payload_begin(),ev.end());
+				add_tempo(curr_census.tempo_counts,curr_tempo,1);
+			}
+		}
+		add_tdiv(curr_census.tdiv_counts,smf.division(),1);
+	};
+	jmid::batch_read(files,cb,opts);
+
+	std::vector<tdiv_counts_t> tdiv_counts;
+	std::vector<tempo_counts_t> tempo_counts;
+	for (const auto& c : census) {
+		for (const auto& tdivc : c.tdiv_counts) {
+			add_tdiv(tdiv_counts,tdivc.tdiv,tdivc.count);
+		}
+		for (const auto& tc : c.tempo_counts) {
+			add_tempo(tempo_counts,tc.tempo,tc.count);
 		}
 	}
 
@@ -66,5 +109,40 @@ int main(int argc, char *argv[]) {
 		std::cout << std::endl;
 	}
 
+	std::sort(tempo_counts.begin(),tempo_counts.end(),
+		[](const tempo_counts_t& lhs, const tempo_counts_t& rhs)->bool {
+			return lhs.count > rhs.count;
+		});
+	for (const auto& tc : tempo_counts) {
+		std::cout << "tempo\t" << tc.tempo << " us/q\t" 
+			<< tc.count << std::endl;
+	}
+
 	return 0;
 }
+
+void add_tdiv(std::vector<tdiv_counts_t>& tdiv_counts, 
+				jmid::time_division_t tdiv, int n) {
+	auto tdiv_eq = [&tdiv](const tdiv_counts_t& tdivc)->bool {
+		return tdivc.tdiv==tdiv;
+	};
+	auto it = std::find_if(tdiv_counts.begin(),tdiv_counts.end(),tdiv_eq);
+	if (it!=tdiv_counts.end()) {
+		it->count += n;
+	} else {
+		tdiv_counts.push_back({tdiv,n});
+	}
+}
+
+void add_tempo(std::vector<tempo_counts_t>& tempo_counts, 
+				std::uint32_t tempo, int n) {
+	auto tempo_eq = [&tempo](const tempo_counts_t& tc)->bool {
+		return tc.tempo==tempo;
+	};
+	auto it = std::find_if(tempo_counts.begin(),tempo_counts.end(),tempo_eq);
+	if (it!=tempo_counts.end()) {
+		it->count += n;
+	} else {
+		tempo_counts.push_back({tempo,n});
+	}
+}
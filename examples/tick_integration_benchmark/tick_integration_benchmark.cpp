@@ -0,0 +1,264 @@
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "make_mtrk_event.h"
+#include "midi_vlq.h"
+#include "midi_delta_time.h"
+#include "midi_status_byte.h"
+#include "smf_t.h"
+#include "batch_read.h"
+#include "util.h"
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <iterator>
+
+//
+// Integrates the delta times of every event in a corpus of MTrks (the
+// "tick integration" that underlies tkonset computation, duration,
+// linked-pair searches, etc) two ways:
+// 1)  "decode":  The way mtrk_event_t worked before the delta time and
+//     status byte were cached in the object:  each call decodes the
+//     delta-time vlq from the front of the event data, then skips past it
+//     to read the status byte.
+// 2)  "cached":  Calls mtrk_event_t::delta_time() and status_byte(), which
+//     read the values cached in the object.
+// Both routines sum the tick onsets of the note-on events so that the work
+// can not be optimized away, and the two sums are checked for equality.
+//
+// If -path= is given, the corpus is every MTrk of every midi file in the
+// directory (searched recursively); otherwise it is -Ntrks random tracks
+// of -N events each.  The random tracks are mostly channel events w/ a
+// few meta and sysex events, some of which are too large for the small-
+// object buffer.
+//
+struct opts_t {
+	int64_t N;
+	int64_t Ntrks;
+	int64_t N_rpts;
+	std::filesystem::path path;
+};
+opts_t get_options(int, char**);
+std::vector<jmid::mtrk_t> random_corpus(int64_t, int64_t);
+std::vector<jmid::mtrk_t> read_corpus(const std::filesystem::path&);
+int64_t integrate_decode(const std::vector<jmid::mtrk_t>&);
+int64_t integrate_cached(const std::vector<jmid::mtrk_t>&);
+
+int main(int argc, char *argv[]) {
+	auto opts = get_options(argc,argv);
+	std::cout << "Running the tick_integration_benchmark with:\n";
+	if (!opts.path.empty()) {
+		std::cout << "\tpath == " << opts.path << "\n";
+	} else {
+		std::cout << "\tNtrks == " << opts.Ntrks << " random tracks of\n"
+			<< "\tN == " << opts.N << " random events.\n";
+	}
+	std::cout << "\tN_rpts == " << opts.N_rpts << " repititions of each routine\n"
+		<< std::endl;
+
+	std::vector<jmid::mtrk_t> corpus;
+	if (!opts.path.empty()) {
+		std::cout << "Reading files..." << std::endl;
+		corpus = read_corpus(opts.path);
+	} else {
+		std::cout << "Generating random tracks..." << std::endl;
+		corpus = random_corpus(opts.Ntrks,opts.N);
+	}
+	int64_t n_events = 0;
+	for (const auto& trk : corpus) {
+		n_events += trk.size();
+	}
+	std::cout << corpus.size() << " tracks; " << n_events << " events.\n";
+
+	std::random_device rdev;
+	std::default_random_engine re(rdev());
+	std::array<int,2> test_func_idx {0,1};
+	std::vector<int> test_order;
+	for (int i=0; i<opts.N_rpts; ++i) {
+		std::shuffle(test_func_idx.begin(),test_func_idx.end(),re);
+		for (const auto& idx : test_func_idx) {
+			test_order.push_back(idx);
+		}
+	}
+
+	std::cout << "Starting runs..." << std::endl;
+	int64_t sum_decode = 0;  int64_t sum_cached = 0;
+	int64_t tot_us_decode = 0;  int64_t tot_us_cached = 0;
+	for (const auto& idx : test_order) {
+		auto tstart = std::chrono::high_resolution_clock::now();
+		if (idx==0) {
+			std::cout << "\tStarting decode:  ";
+			sum_decode = integrate_decode(corpus);
+		} else if (idx==1) {
+			std::cout << "\tStarting cached:  ";
+			sum_cached = integrate_cached(corpus);
+		}
+		auto tend = std::chrono::high_resolution_clock::now();
+		auto tdelta = std::chrono::duration_cast<std::chrono::microseconds>(tend-tstart);
+		std::cout << "Took " << tdelta.count()/1000 << " milliseconds." << std::endl;
+		if (idx==0) {
+			tot_us_decode += tdelta.count();
+		} else {
+			tot_us_cached += tdelta.count();
+		}
+	}
+	std::cout << "------------------------------------\n";
+
+	auto evps = [](int64_t nev, int64_t us)->double {
+		return us > 0 ? (1000000.0*nev)/us : 0.0;
+	};
+	std::cout << "decode:  " << tot_us_decode/1000 << " ms total; "
+		<< evps(n_events*opts.N_rpts,tot_us_decode) << " events/sec\n";
+	std::cout << "cached:  " << tot_us_cached/1000 << " ms total; "
+		<< evps(n_events*opts.N_rpts,tot_us_cached) << " events/sec\n";
+	if (sum_decode != sum_cached) {
+		std::cout << "ERROR:  sum_decode == " << sum_decode
+			<< " != sum_cached == " << sum_cached << std::endl;
+		return 1;
+	}
+	std::cout << "result_sum (ignore this) == " << sum_cached << std::endl;
+
+	return 0;
+}
+
+
+int64_t integrate_decode(const std::vector<jmid::mtrk_t>& corpus) {
+	int64_t result = 0;
+	for (const auto& trk : corpus) {
+		int64_t tk = 0;
+		for (const auto& ev : trk) {
+			const unsigned char *beg = ev.data();
+			const unsigned char *end = ev.data()+ev.size();
+			tk += jmid::read_delta_time(beg,end).val;
+			auto s = *jmid::advance_to_dt_end(beg,end);
+			if ((s&0xF0u) == 0x90u) {
+				result += tk;
+			}
+		}
+	}
+	return result;
+}
+
+int64_t integrate_cached(const std::vector<jmid::mtrk_t>& corpus) {
+	int64_t result = 0;
+	for (const auto& trk : corpus) {
+		int64_t tk = 0;
+		for (const auto& ev : trk) {
+			tk += ev.delta_time();
+			if ((ev.status_byte()&0xF0u) == 0x90u) {
+				result += tk;
+			}
+		}
+	}
+	return result;
+}
+
+std::vector<jmid::mtrk_t> random_corpus(int64_t Ntrks, int64_t N) {
+	std::random_device rdev;
+	std::default_random_engine re(rdev());
+	std::uniform_int_distribution<int> rd_byte(0,0x7F);
+	std::uniform_int_distribution<int> rd_pct(0,99);
+	// Mostly 1-byte delta times, w/ a tail of 2- and 3-byte fields
+	std::geometric_distribution<int> rd_dt(0.01);
+
+	std::vector<jmid::mtrk_t> result;
+	std::vector<unsigned char> data;
+	jmid::mtrk_event_t ev;
+	for (int64_t t=0; t<Ntrks; ++t) {
+		jmid::mtrk_t trk;
+		for (int64_t i=0; i<N; ++i) {
+			data.clear();
+			jmid::write_delta_time(rd_dt(re),std::back_inserter(data));
+			auto sel = rd_pct(re);
+			if (sel < 90) {
+				data.push_back(0x90u);
+				data.push_back(rd_byte(re));
+				data.push_back(rd_byte(re));
+			} else {
+				data.push_back(0xFFu);
+				data.push_back(0x01u);
+				auto len = rd_byte(re)%48;
+				jmid::write_vlq(static_cast<std::uint32_t>(len),std::back_inserter(data));
+				for (int j=0; j<len; ++j) {
+					data.push_back(rd_byte(re));
+				}
+			}
+			const unsigned char *beg = data.data();
+			const unsigned char *end = data.data()+data.size();
+			jmid::make_mtrk_event3(beg,end,0x00u,&ev,nullptr);
+			trk.push_back(ev);
+		}
+		result.push_back(std::move(trk));
+	}
+	return result;
+}
+
+std::vector<jmid::mtrk_t> read_corpus(const std::filesystem::path& basedir) {
+	std::vector<std::filesystem::path> files;
+	for (const auto& dir_ent : std::filesystem::recursive_directory_iterator(basedir)) {
+		if (jmid::has_midifile_extension(dir_ent.path())) {
+			files.push_back(dir_ent.path());
+		}
+	}
+
+	std::vector<jmid::mtrk_t> result;
+	std::mutex mtx;
+	auto cb = [&result,&mtx](const jmid::batch_read_item_t& item)->void {
+		if (item.error.code != jmid::smf_error_t::errc::no_error) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(mtx);
+		for (const auto& trk : *(item.smf)) {
+			result.push_back(trk);
+		}
+	};
+	jmid::batch_read(files,cb);
+	return result;
+}
+
+opts_t get_options(int argc, char **argv) {
+	struct opts_type {
+		std::regex rx;
+		int64_t val;
+		int64_t def_val;
+	};
+	std::array<opts_type,3> opts {{
+		// The number of random events per track
+		{std::regex("-N=(\\d+)"),-1,10'000},
+		// The number of random tracks
+		{std::regex("-Ntrks=(\\d+)"),-1,200},
+		// How many times each procedure should be run through the corpus
+		{std::regex("-Nrpts=(\\d+)"),-1,10}
+	}};
+
+	opts_t result;
+	std::regex rx_path("-path=(.+)");
+	for (int i=0; i<argc; ++i) {
+		std::cmatch curr_match;
+		std::regex_match(argv[i],curr_match,rx_path);
+		if (!curr_match.empty()) {
+			result.path = curr_match[1].str();
+			continue;
+		}
+		for (std::size_t j=0; j<opts.size(); ++j) {
+			std::regex_match(argv[i],curr_match,opts[j].rx);
+			if (curr_match.empty()) { continue; }
+			opts[j].val = std::stol(curr_match[1].str());
+			// Each argv[i] should match only one of the options in opts:
+			break;
+		}
+	}
+
+	result.N = opts[0].val < 0 ? opts[0].def_val : opts[0].val;
+	result.Ntrks = opts[1].val < 0 ? opts[1].def_val : opts[1].val;
+	result.N_rpts = opts[2].val < 0 ? opts[2].def_val : opts[2].val;
+	return result;
+}
+
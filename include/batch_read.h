@@ -0,0 +1,84 @@
+#pragma once
+#include "smf_t.h"
+#include <filesystem>
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <cstddef>  // std::size_t
+
+
+namespace jmid {
+
+//
+// batch_read(const std::vector<std::filesystem::path>& paths,
+//				const batch_read_callback_t& cb, batch_read_opts_t opts)
+//
+// Reads and parses each file in paths on a pool of opts.nthreads worker
+// threads (the calling thread blocks until all files have been processed).
+// For each file, cb is called from the worker thread that read the file,
+// including for files that could not be read or parsed.  Since cb is called
+// concurrently from several threads, it must synchronize access to any
+// shared state; batch_read_item_t::worker is an index in [0,nthreads) that
+// can be used to give each worker its own output object w/o locking.
+//
+// Files are scheduled largest-first:  the paths are sorted by file size
+// and dealt out to per-worker queues so that each worker starts on one of
+// the largest files.  A worker takes files from the front of its own queue
+// (largest remaining) and, when that is empty, steals from the back of
+// another worker's queue (smallest remaining).  Thus no worker sits idle
+// while another has a backlog, and a few very large files are started
+// early rather than left to the end.
+//
+// Each worker reuses its file buffer, file mapping, and smf_t from one
+// file to the next, so after the first few files, reading generally does
+// not allocate beyond what the smf_t itself needs.  The smf_t and data
+// pointers passed to cb are only valid for the duration of the call.
+//
+// Returns the smf_error_t for each file in the same order as paths.  Files
+// that can not be opened or read in full yield 
+// smf_error_t::errc::file_read_error.  If reading or parsing a file, or 
+// the callback, throws, the exception is caught in the worker thread and 
+// the file yields smf_error_t::errc::other; the remaining files are still
+// processed.  
+//
+enum class batch_read_method : std::uint8_t {
+	bulk_ifstream,  // std::ifstream::read() of the whole file into a buffer
+	istreambuf_iterator,  // make_smf2() w/ std::istreambuf_iterator<char>
+	csio,  // read_binary_csio() into a buffer
+	mmap  // read_only_mapped_file_t
+};
+struct batch_read_opts_t {
+	// <= 0 => std::thread::hardware_concurrency()
+	int nthreads {0};
+	batch_read_method method {batch_read_method::mmap};
+	// If false, the file is read (or mapped) but not parsed; the callback
+	// receives the raw file data (ex, to construct an smf_view_t) and
+	// batch_read_item_t::smf is nullptr.  In this case, the only error
+	// reported is file_read_error, and the istreambuf_iterator method can
+	// not be used (batch_read_item_t::data_beg==data_end==nullptr).
+	bool make_smf {true};
+	// If non-null, installed w/ an intern_scope_t on each worker thread, so
+	// that equal big meta and sysex events share a buffer across the whole
+	// batch; otherwise, the store in effect on the calling thread (if any)
+	// is installed.  The store must outlive any event the callback keeps.  
+	internal::byte_intern_t *intern_store {nullptr};
+};
+struct batch_read_item_t {
+	std::size_t idx;  // Index of the file in the input vector of paths
+	const std::filesystem::path& path;
+	const smf_t *smf;  // nullptr if !batch_read_opts_t::make_smf
+	const smf_error_t& error;
+	// The file data; nullptr for batch_read_method::istreambuf_iterator
+	const unsigned char *data_beg;
+	const unsigned char *data_end;
+	int worker;  // [0,nthreads)
+};
+using batch_read_callback_t = std::function<void(const batch_read_item_t&)>;
+
+// Number of worker threads batch_read() will use for the given options
+int batch_read_nthreads(const batch_read_opts_t&);
+std::vector<smf_error_t> batch_read(const std::vector<std::filesystem::path>&,
+				const batch_read_callback_t&, batch_read_opts_t={});
+
+}  // namespace jmid
+
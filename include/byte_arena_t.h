@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>  // std::unique_ptr
+#include <string_view>
+#include <unordered_set>
+#include <mutex>
+
+namespace jmid {
+
+namespace internal {
+
+//
+// Class byte_arena_t
+//
+// Monotonic allocator for arrays of unsigned char.  Memory is obtained 
+// from the system in blocks of block_size bytes (requests larger than
+// block_size/4 get a block of their own) and handed out sequentially; 
+// individual allocations are never freed.  All memory is returned to the
+// system at once when the arena is destroyed.  release() makes all the 
+// memory handed out so far available again, retaining the first block so
+// that an arena can be reused w/o allocating.  
+//
+// The pointers returned by allocate() remain valid until release() is 
+// called or the arena is destroyed; the arena itself may be moved w/o 
+// invalidating them.  
+//
+class byte_arena_t {
+public:
+	static constexpr std::int32_t block_size_default = 0x10000;  // 64 kB
+
+	byte_arena_t() noexcept;
+	explicit byte_arena_t(std::int32_t) noexcept;
+	byte_arena_t(const byte_arena_t&) = delete;
+	byte_arena_t& operator=(const byte_arena_t&) = delete;
+	byte_arena_t(byte_arena_t&&) noexcept = default;
+	byte_arena_t& operator=(byte_arena_t&&) noexcept = default;
+	~byte_arena_t() noexcept = default;
+
+	// unsigned char *allocate(std::int32_t n);
+	// Returns a ptr to an uninitialized array of n bytes.  n must be > 0.  
+	unsigned char *allocate(std::int32_t);
+	void release() noexcept;
+
+	// Number of bytes handed out by allocate() since construction or the
+	// last call to release()
+	std::int64_t nbytes_allocated() const noexcept;
+	// Number of bytes obtained from the system
+	std::int64_t nbytes_reserved() const noexcept;
+	std::int32_t nblocks() const noexcept;
+private:
+	struct block_t {
+		std::unique_ptr<unsigned char[]> p;
+		std::int32_t sz;
+	};
+	std::vector<block_t> blocks_ {};
+	std::int32_t block_size_ {block_size_default};
+	unsigned char *curr_ {nullptr};  // Next free byte in the current block
+	std::int32_t n_avail_ {0};  // Free bytes in the current block
+	std::int64_t nbytes_allocated_ {0};
+};
+
+//
+// Class arena_scope_t
+//
+// The allocator hook for small_bytevec_t.  While an arena_scope_t is 
+// alive, the buffers of 'big' small_bytevec_t objects allocated on the 
+// same thread are drawn from the arena passed to the ctor rather than 
+// w/ new [].  A small_bytevec_t whose buffer is owned by an arena never
+// delete []s it; the arena must therefore outlive the object (or the 
+// object must be reallocated or destroyed before the arena is released).  
+// A nullptr arena restores ordinary heap allocation.  Scopes nest; the
+// dtor restores the arena (or nullptr) in effect before construction.  
+//
+class arena_scope_t {
+public:
+	explicit arena_scope_t(byte_arena_t*) noexcept;
+	arena_scope_t(const arena_scope_t&) = delete;
+	arena_scope_t& operator=(const arena_scope_t&) = delete;
+	~arena_scope_t() noexcept;
+private:
+	byte_arena_t *prev_;
+};
+// The arena set by the innermost arena_scope_t on the calling thread, or 
+// nullptr.  
+byte_arena_t *current_arena() noexcept;
+
+//
+// Class byte_intern_t
+//
+// Store of immutable byte sequences for deduplicating the buffers of big
+// small_bytevec_t objects (see intern_scope_t).  intern() returns a ptr to
+// the stored copy of [beg,end), copying the sequence into the store only 
+// if an equal sequence is not already present; lookup is by hash of the 
+// bytes.  The stored sequences are held in a byte_arena_t and are never
+// freed or modified until the store is destroyed; the store must 
+// therefore outlive every object referring to one of its sequences.  
+// intern() and the getters can be called concurrently from any number of
+// threads.  
+//
+class byte_intern_t {
+public:
+	byte_intern_t();
+	byte_intern_t(const byte_intern_t&) = delete;
+	byte_intern_t& operator=(const byte_intern_t&) = delete;
+	~byte_intern_t() noexcept = default;
+
+	// const unsigned char *intern(const unsigned char *beg, 
+	//								const unsigned char *end);
+	// [beg,end) must not be empty.  
+	const unsigned char *intern(const unsigned char*, const unsigned char*);
+
+	// Number of distinct sequences in the store, and their total size
+	std::int64_t size() const;
+	std::int64_t nbytes() const;
+	// Number of calls to intern() that found an equal sequence already in 
+	// the store, and the total size of the sequences passed to those calls
+	// (ie, the number of bytes not allocated as a result of interning).  
+	std::int64_t nhits() const;
+	std::int64_t nbytes_saved() const;
+private:
+	mutable std::mutex mtx_ {};
+	byte_arena_t arena_ {};
+	std::unordered_set<std::string_view> seqs_ {};
+	std::int64_t nbytes_ {0};
+	std::int64_t nhits_ {0};
+	std::int64_t nbytes_saved_ {0};
+};
+
+//
+// Class intern_scope_t
+//
+// The interning hook for mtrk_event_t.  While an intern_scope_t is alive,
+// meta and sysex events constructed on the same thread that are too large
+// for the small-object buffer share their buffer w/ every equal event 
+// constructed in the scope, through the byte_intern_t passed to the ctor;
+// see small_bytevec_t::intern().  As for arena_scope_t, a nullptr store 
+// disables interning, and scopes nest.  
+//
+class intern_scope_t {
+public:
+	explicit intern_scope_t(byte_intern_t*) noexcept;
+	intern_scope_t(const intern_scope_t&) = delete;
+	intern_scope_t& operator=(const intern_scope_t&) = delete;
+	~intern_scope_t() noexcept;
+private:
+	byte_intern_t *prev_;
+};
+// The store set by the innermost intern_scope_t on the calling thread, or
+// nullptr.  
+byte_intern_t *current_intern_store() noexcept;
+
+}  // namespace internal
+}  // namespace jmid
+
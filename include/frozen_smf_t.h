@@ -0,0 +1,174 @@
+#pragma once
+#include "smf_t.h"
+#include "smf_view_t.h"  // mtrk_view_t, mtrk_event_view_t
+#include "mthd_t.h"
+#include "midi_time.h"  // time_division_t
+#include <cstdint>
+#include <array>
+#include <memory>  // std::unique_ptr
+
+
+namespace jmid {
+
+//
+// frozen_smf_t
+//
+// An immutable, flat representation of an smf.  An smf_t is a vector of
+// mtrk_t, each a vector of mtrk_event_t, plus a vector of vectors for the
+// uchks and a vector recording the chunk order; reading a file w/ many
+// large (sysex) events makes many independent allocations.  A frozen_smf_t
+// holds everything in a single buffer (the "blob"), allocated once,
+// containing:
+// -> A fixed-size header w/ the counts and section offsets
+// -> A table of the MTrk chunks:  Each entry is a byte range of the smf
+//    data and an index range into the event table.
+// -> A table of the uchks:  Each entry is a byte range of the uchk data.
+// -> The event table:  One compact event_t record per event, for all the
+//    tracks in order.
+// -> The chunk order (as smf_t::chunkorder_; 0=>MTrk, 1=>uchk)
+// -> The smf data:  The MThd and MTrk chunks exactly as written by
+//    write_smf(); [smf_begin(),smf_end()) is a valid midi file.
+// -> The uchk data:  The data sections of the uchks, concatenated.
+// All the offsets in the blob are relative to the start of the blob (or
+// of a section), and all integers are in native byte order, so the blob
+// can be written out w/ [blob_begin(),blob_end()) and read back in w/
+// make_frozen_smf() on a machine of the same endianness.
+//
+// Since there is no mutable state, all methods can be called concurrently
+// from any number of threads; share an object by const reference or
+// through a std::shared_ptr<const frozen_smf_t>.  Copying an object makes
+// one allocation and copies the blob w/ std::memcpy().
+//
+class frozen_smf_t {
+public:
+	using size_type = std::int64_t;
+	//
+	// event_t
+	// Index record for an event.  p1 and p2 follow the conventions of
+	// mtrk_columns_t:  For channel events, the data bytes (p2==0 for events
+	// w/ only one data byte); for meta events, p1 is the meta type byte and
+	// p2==0; for sysex events, p1==p2==0.
+	//
+	struct event_t {
+		std::int32_t tkonset;
+		// Offset into [smf_begin(),smf_end()) of the first byte of the
+		// delta time
+		std::int32_t offset;
+		std::int32_t nbytes;  // Including the delta time
+		unsigned char status;  // Never running status
+		unsigned char dt_nbytes;
+		unsigned char p1;
+		unsigned char p2;
+	};
+	static_assert(sizeof(event_t)==16);
+
+	// Constructs an object w/ nchunks()==0 and blob_nbytes()==0;
+	// smf_begin()==smf_end().
+	frozen_smf_t() noexcept;
+	// Makes exactly one allocation.  The offsets in the blob are int32_t;
+	// calls std::abort() if the blob would be >= 2 GiB.  
+	explicit frozen_smf_t(const smf_t&);
+	frozen_smf_t(const frozen_smf_t&);
+	frozen_smf_t(frozen_smf_t&&) noexcept;
+	frozen_smf_t& operator=(const frozen_smf_t&);
+	frozen_smf_t& operator=(frozen_smf_t&&) noexcept;
+	~frozen_smf_t() noexcept;
+
+	size_type size() const noexcept;  // Number of mtrk chunks
+	size_type nchunks() const noexcept;  // Number of MThd + MTrk + Unkn chunks
+	size_type ntrks() const noexcept;  // Number of MTrk chunks
+	size_type nuchks() const noexcept;  // Number of Unkn chunks
+	size_type nevents() const noexcept;  // Summed over all MTrks
+
+	jmid::mthd_t mthd() const;
+	std::int32_t format() const;  // mthd alias
+	jmid::time_division_t division() const;  // mthd alias
+
+	// The event records for MTrk i.  For event e of MTrk i, the delta time
+	// is e.tkonset-(e-1)->tkonset (e.tkonset for the first event).
+	const event_t *event_begin(size_type) const noexcept;
+	const event_t *event_end(size_type) const noexcept;
+	// The event bytes [event_data(e),event_data(e)+e.nbytes), delta time
+	// included
+	const unsigned char *event_data(const event_t&) const noexcept;
+	mtrk_event_view_t event_view(const event_t&) const noexcept;
+	mtrk_event_t event(const event_t&) const;
+	// MTrk i, header included
+	const unsigned char *mtrk_begin(size_type) const noexcept;
+	const unsigned char *mtrk_end(size_type) const noexcept;
+	// A view of the data section of MTrk i
+	mtrk_view_t mtrk_view(size_type) const noexcept;
+	// The data section of uchk i
+	const unsigned char *uchk_begin(size_type) const noexcept;
+	const unsigned char *uchk_end(size_type) const noexcept;
+
+	// The MThd and MTrk chunks; identical to the output of write_smf() for
+	// the smf_t from which the object was built.
+	const unsigned char *smf_begin() const noexcept;
+	const unsigned char *smf_end() const noexcept;
+	size_type smf_nbytes() const noexcept;
+
+	const unsigned char *blob_begin() const noexcept;
+	const unsigned char *blob_end() const noexcept;
+	size_type blob_nbytes() const noexcept;
+
+	// Rebuilds the smf_t, w/ the chunks in their original order
+	smf_t to_smf() const;
+private:
+	struct header_t {
+		std::array<unsigned char,4> magic;
+		std::uint32_t version;
+		std::int64_t nbytes;  // Of the entire blob
+		std::int32_t ntrks;
+		std::int32_t nuchks;
+		std::int32_t nevents;
+		std::int32_t trks_offset;
+		std::int32_t uchks_offset;
+		std::int32_t events_offset;
+		std::int32_t chunkorder_offset;
+		std::int32_t smf_offset;
+		std::int32_t smf_nbytes;
+		std::int32_t uchk_data_offset;
+		std::int32_t uchk_data_nbytes;
+		std::int32_t pad;
+	};
+	struct trk_t {
+		std::int32_t offset;  // Into the smf data; the chunk header
+		std::int32_t nbytes;  // Header included
+		std::int32_t ev_beg;  // Index into the event table
+		std::int32_t nevents;
+	};
+	struct uchk_t {
+		std::int32_t offset;  // Into the uchk data
+		std::int32_t nbytes;
+	};
+	static constexpr std::array<unsigned char,4> magic {'J','F','S','M'};
+	static constexpr std::uint32_t version = 1;
+
+	std::unique_ptr<unsigned char[]> blob_ {};
+
+	const header_t *header() const noexcept;
+	const trk_t *trks() const noexcept;
+	const uchk_t *uchks() const noexcept;
+	const event_t *events() const noexcept;
+	const unsigned char *chunkorder() const noexcept;
+
+	friend bool make_frozen_smf(const unsigned char*, const unsigned char*,
+								frozen_smf_t*);
+};
+
+//
+// bool make_frozen_smf(const unsigned char *beg, const unsigned char *end,
+//						frozen_smf_t *result);
+//
+// Overwrites *result w/ a copy of the blob [beg,end), as obtained from
+// frozen_smf_t::blob_begin(), blob_end().  Checks the header (magic
+// number, version, sizes) and that every table entry refers to a range
+// inside the blob; the events themselves are not revalidated.  Returns
+// false, leaving *result unchanged, if any of the checks fail.
+//
+bool make_frozen_smf(const unsigned char*, const unsigned char*,
+						frozen_smf_t*);
+
+}  // namespace jmid
+
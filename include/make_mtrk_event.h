@@ -3,6 +3,7 @@
 #include "midi_delta_time.h"
 #include "midi_vlq.h"
 #include <cstdint>
+#include <cstddef>  // std::ptrdiff_t
 
 namespace jmid {
 
@@ -112,6 +113,7 @@ InIt make_mtrk_event3(InIt it, InIt end, unsigned char rs,
 			set_error(mtrk_event_error_t::errc::sysex_or_meta_calcd_length_exceeds_input,s,rs);
 			return it;
 		}
+		result->intern_if_scoped();  // Only once the payload is complete
 	} else if (jmid::is_sysex_status_byte(s)) {
 		// s == 0xF7 || 0xF0
 		jmid::sysex_header_data sx;
@@ -138,6 +140,7 @@ InIt make_mtrk_event3(InIt it, InIt end, unsigned char rs,
 			set_error(mtrk_event_error_t::errc::sysex_or_meta_calcd_length_exceeds_input,s,rs);
 			return it;
 		}
+		result->intern_if_scoped();  // Only once the payload is complete
 	} else if (jmid::is_unrecognized_status_byte(s) 
 				|| !jmid::is_status_byte(s)) {
 		set_error(mtrk_event_error_t::errc::invalid_status_byte,s,rs);
@@ -148,6 +151,27 @@ InIt make_mtrk_event3(InIt it, InIt end, unsigned char rs,
 };
 
 
+//
+// Overloads of make_mtrk_event3() for contiguous input.  
+//
+// These are selected in preference to the template for const unsigned char*
+// and const char* ranges, and produce results identical to the template in
+// all cases:  the same mtrk_event_t, error code, and returned iterator.  
+// Where at least fast_path_min_nbytes bytes are available, the delta time,
+// status byte, and meta/sysex header are decoded w/o per-byte checks 
+// against end and w/ branch-reduced vlq decoding, and the payload is 
+// memcpy()'d into the event.  Near the end of the input, and for any 
+// event that would be reported as an error, these functions delegate to
+// the template.  
+//
+inline constexpr std::ptrdiff_t fast_path_min_nbytes = 10;  // dt+0xFF+type+len
+const unsigned char *make_mtrk_event3(const unsigned char*, 
+					const unsigned char*, unsigned char, 
+					mtrk_event_t*, mtrk_event_error_t*);
+const char *make_mtrk_event3(const char*, const char*, unsigned char, 
+					mtrk_event_t*, mtrk_event_error_t*);
+
+
 template <typename InIt>
 mtrk_event_t make_mtrk_event3(InIt it, InIt end, unsigned char rs, 
 					mtrk_event_error_t *err) {
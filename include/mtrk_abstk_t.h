@@ -0,0 +1,111 @@
+#pragma once
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "midi_delta_time.h"
+#include "midi_vlq.h"  // write_32bit_be()
+#include <cstdint>
+#include <map>
+#include <array>
+#include <algorithm>  // std::copy()
+
+
+namespace jmid {
+
+//
+// mtrk_abstk_t
+//
+// An MTrk event sequence stored by absolute onset tick, for editing.
+// mtrk_t stores each event w/ its delta time, so finding the event at a
+// given tick, or inserting or erasing an event w/o shifting the events
+// downstream, is a linear walk from the start of the track; a sequence of
+// edits at random positions is quadratic in the length of the track.
+// Here the events are held in a std::multimap keyed on the onset tick:
+// -> at_tkonset(), insert(), erase(), and set_tkonset() are O(log(n))
+// -> Events w/ the same onset tick are kept in the order in which they
+//    were inserted; an event inserted at tick tk goes after all the events
+//    already at tk.
+// -> The onset ticks of the other events are never changed by an edit
+//    (there is no analog of the "tkshift" behavior of mtrk_t::insert()/
+//    erase()).
+// Delta times are only computed when the track is serialized (write_mtrk())
+// or converted back to an mtrk_t (to_mtrk()).  The stored events always
+// have delta_time()==0; the onset tick is the key of the element.
+//
+// As w/ mtrk_t, the container does not enforce the MTrk invariants:  The
+// caller is responsible for keeping the EOT event last.
+//
+class mtrk_abstk_t {
+public:
+	using map_type = std::multimap<std::int32_t,mtrk_event_t>;
+	using size_type = std::int32_t;
+	// *it is a std::pair<const std::int32_t,mtrk_event_t>:
+	// {onset tick, event}
+	using const_iterator = map_type::const_iterator;
+
+	mtrk_abstk_t() noexcept;
+	explicit mtrk_abstk_t(const mtrk_t&);
+
+	size_type size() const noexcept;
+	bool empty() const noexcept;
+	// Onset tick of the last event; same as mtrk_t::nticks() for the
+	// equivalent mtrk_t.  O(1).
+	std::int32_t nticks() const noexcept;
+	// Same as mtrk_t::nbytes(), data_nbytes() for the equivalent mtrk_t.
+	// O(n), since the size of each delta-time field depends on the onset
+	// tick of the preceding event.
+	size_type nbytes() const;
+	size_type data_nbytes() const;
+
+	const_iterator begin() const noexcept;
+	const_iterator end() const noexcept;
+	// The first event w/ onset tick >= the number provided; end() if there
+	// is no such event.
+	const_iterator at_tkonset(std::int32_t) const;
+
+	// Insert the event w/ onset tick == arg1 + arg2.delta_time() (the same
+	// interpretation as mtrk_t::insert(std::int32_t, mtrk_event_t)).
+	// Returns an iterator to the new event.  For this and set_tkonset(),
+	// a negative onset tick is clamped to 0.
+	const_iterator insert(std::int32_t, mtrk_event_t);
+	// Returns an iterator to the event following the erased event
+	const_iterator erase(const_iterator);
+	// Moves the event to the new onset tick (after any events already at
+	// that tick) and returns an iterator to it.
+	const_iterator set_tkonset(const_iterator, std::int32_t);
+	// Replaces the event pointed to by arg1 w/ arg2; the onset tick is
+	// unchanged and the delta time of arg2 is ignored.
+	const_iterator replace(const_iterator, mtrk_event_t);
+	void clear() noexcept;
+
+	mtrk_t to_mtrk() const;
+private:
+	map_type evnts_ {};
+};
+
+//
+// OIt write_mtrk(const mtrk_abstk_t& mtrk, OIt it);
+// unsigned char *write_mtrk(const mtrk_abstk_t& mtrk, unsigned char *dest);
+//
+// Writes the MTrk chunk (header and events) to it; the output is the same
+// as write_mtrk(mtrk.to_mtrk(),it).  The overload for unsigned char*
+// writes to a contiguous buffer w/ room for at least mtrk.nbytes() bytes
+// and computes the length field after writing the events, so the events
+// are only traversed once.
+//
+template<typename OIt>
+OIt write_mtrk(const mtrk_abstk_t& mtrk, OIt it) {
+	std::array<char,4> h {'M','T','r','k'};
+	it = std::copy(h.begin(),h.end(),it);
+	it = jmid::write_32bit_be(static_cast<uint32_t>(mtrk.data_nbytes()), it);
+	std::int32_t tk = 0;
+	for (const auto& e : mtrk) {
+		it = jmid::write_delta_time(e.first-tk,it);
+		tk = e.first;
+		it = std::copy(e.second.event_begin(),e.second.end(),it);
+	}
+	return it;
+};
+unsigned char *write_mtrk(const mtrk_abstk_t&, unsigned char*);
+
+}  // namespace jmid
+
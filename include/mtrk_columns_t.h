@@ -0,0 +1,92 @@
+#pragma once
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "midi_time.h"  // time_division_t
+#include <cstdint>
+#include <vector>
+
+
+namespace jmid {
+
+//
+// mtrk_columns_t
+//
+// A "struct of arrays" representation of an MTrk event sequence, built 
+// from an mtrk_t (and convertible back to one), for analysis code that 
+// scans a whole track.  Rather than one mtrk_event_t per event, the track
+// is held as a set of contiguous columns each w/ size() elements:  
+// -> tkonset:  The onset tick of the event (the cumulative sum of the 
+//    delta times up to and including the event)
+// -> status:  The status byte (never running status; for a channel event
+//    in running status in the source MTrk, the status byte in effect)
+// -> p1, p2:  For channel events, the data bytes (p2==0 for events w/ 
+//    only one data byte).  For meta events, p1 is the meta type byte and
+//    p2==0.  For sysex events, p1==p2==0.  
+// -> payload_offset:  The payload of event i (the bytes following the 
+//    vlq length field of a meta or sysex event; empty for channel events) 
+//    is [payload_offset[i],payload_offset[i+1]) in a single shared array
+//    of bytes.  payload_offset has size()+1 elements.  
+// The delta time of event i is tkonset[i]-tkonset[i-1] (tkonset[i] for 
+// i==0), and the event can be recovered exactly w/ event(i).  Since the
+// delta time and status byte are decoded once when the columns are built,
+// queries such as "all note-ons of channel 3 between ticks a and b" are 
+// simple loops over arrays of int32_t and unsigned char.  
+//
+// Unlike an mtrk_t, the columns are not intended to be edited in place;
+// build a new object (or push_back() events onto a cleared one).  
+//
+class mtrk_columns_t {
+public:
+	using size_type = std::int32_t;
+
+	mtrk_columns_t() noexcept;
+	explicit mtrk_columns_t(const mtrk_t&);
+	
+	size_type size() const noexcept;
+	// Onset tick of the last event; same as mtrk_t::nticks()
+	std::int32_t nticks() const noexcept;
+	// Total number of payload bytes (meta and sysex events)
+	std::int32_t payload_nbytes() const noexcept;
+
+	// Appends the event w/ onset tick nticks()+ev.delta_time().  ev must
+	// not be empty.  
+	void push_back(const mtrk_event_t&);
+	void clear() noexcept;
+	void reserve(size_type, std::int32_t);
+
+	// Columns
+	const std::vector<std::int32_t>& tkonset() const noexcept;
+	const std::vector<unsigned char>& status() const noexcept;
+	const std::vector<unsigned char>& p1() const noexcept;
+	const std::vector<unsigned char>& p2() const noexcept;
+	const std::vector<std::int32_t>& payload_offset() const noexcept;
+	const std::vector<unsigned char>& payload() const noexcept;
+
+	// Per-event accessors
+	std::int32_t delta_time(size_type) const noexcept;
+	const unsigned char *payload_begin(size_type) const noexcept;
+	const unsigned char *payload_end(size_type) const noexcept;
+	// Rebuilds the event at the given index
+	mtrk_event_t event(size_type) const;
+	// Index of the first event w/ tkonset >= the value provided; size() if
+	// there is no such event.  O(log(size())).  
+	size_type at_tkonset(std::int32_t) const noexcept;
+
+	// Rebuilds the full event sequence; the result compares equal 
+	// event-by-event w/ the mtrk_t from which the object was built.  
+	mtrk_t to_mtrk() const;
+private:
+	std::vector<std::int32_t> tkonset_ {};
+	std::vector<unsigned char> status_ {};
+	std::vector<unsigned char> p1_ {};
+	std::vector<unsigned char> p2_ {};
+	std::vector<std::int32_t> payload_offset_ {0};
+	std::vector<unsigned char> payload_ {};
+};
+
+// Same as duration(const mtrk_t&, ...)
+double duration(const mtrk_columns_t&, const jmid::time_division_t&, 
+				std::int32_t=500000);
+
+}  // namespace jmid
+
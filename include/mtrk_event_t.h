@@ -137,6 +137,7 @@ public:
 			*dest++ = *beg++;
 			++i;
 		}
+		this->update_cache();
 		return {beg,i};
 	};
 	template<typename InIt>
@@ -156,9 +157,33 @@ public:
 			*dest++ = *beg++;
 			++i;
 		}
+		this->update_cache();
 		return {beg,i};
 	};
+	// Overloads for contiguous input; the payload is copied w/ memcpy().
+	// Identical in effect to the template versions above.  
+	replace_unsafe_result<const unsigned char*> replace_unsafe(std::int32_t,
+				jmid::meta_header_data, const unsigned char*, const unsigned char*);
+	replace_unsafe_result<const unsigned char*> replace_unsafe(std::int32_t,
+				jmid::sysex_header_data, const unsigned char*, const unsigned char*);
 	void replace_unsafe(std::int32_t, jmid::ch_event_data_t);
+	// void intern_if_scoped();
+	// If an intern_scope_t is active on the calling thread, the buffer of a
+	// big event is replaced by the shared copy in the store (see 
+	// small_bytevec_t::intern()).  The ctors call this for each meta and
+	// sysex event; replace_unsafe() does not, since the payload may be 
+	// incomplete, so a caller of replace_unsafe() calls it once the 
+	// number of bytes written has been checked (as make_mtrk_event3() 
+	// does).  
+	void intern_if_scoped();
+	// void detach_arena();
+	// If the buffer of a big event is owned by an arena (see 
+	// mtrk_t::set_arena_enabled()), copies the event data into a buffer of 
+	// its own (see small_bytevec_t::detach_arena()).  Otherwise does 
+	// nothing.  Moves transfer an arena-owned buffer as-is; the mtrk_t 
+	// modifiers and algorithms that move events out of a track call this
+	// so that the events do not outlive the arena.  
+	void detach_arena();
 	
 
 	void clear() noexcept;
@@ -166,6 +191,8 @@ public:
 	constexpr size_type max_size() const noexcept;
 	size_type capacity() const noexcept;
 	size_type reserve(size_type);
+	// Frees unused capacity; see small_bytevec_t::shrink_to_fit()
+	void shrink_to_fit();
 	bool is_empty() const;
 
 	// Data accessors
@@ -211,7 +238,34 @@ public:
 	std::string debug_print() const;
 private:
 	jmid::internal::small_bytevec_t d_;
-	
+
+	// The delta time, status byte, and the offsets of the event and the 
+	// payload are cached in the metadata of d_ (see small_bytevec_t) so 
+	// that delta_time(), status_byte(), event_begin(), payload_range(), 
+	// etc, do not have to decode the leading vlq fields on each call.  
+	// If d_ is small, the data are inline and only the size of the 
+	// delta-time field - 1 is stored (small_meta()).  If d_ is big, the 
+	// 7-byte pad holds:
+	// [0,4):  The delta time (std::int32_t, native byte order)
+	// [4]:  The status byte
+	// [5]:  The size of the delta-time field
+	// [6]:  The offset of the payload from the start of the event (see
+	//       payload_range())
+	// update_cache() must be called after every modification of d_ other
+	// than a move.  
+	// The hot accessors (delta_time(), status_byte()) read the flags byte 
+	// and the cache directly from the object representation of d_ (see
+	// raw_begin()) rather than calling is_small(), small_meta(), 
+	// pad_or_data_range(), etc, each of which is an out-of-line call.  In 
+	// both small_t and big_t, the flags byte is at offset 0, followed by 
+	// the small data or the big pad.  
+	void update_cache() noexcept;
+	// Interning (see intern_if_scoped()):  Since small_bytevec_t copies a 
+	// shared buffer before any write, the mutators need do nothing 
+	// special; the non-const accessors read through a const d_ so as not 
+	// to trigger the copy.  
+	const unsigned char *raw_begin() const noexcept;
+	std::int32_t dt_nbytes() const noexcept;
 	mtrk_event_iterator_range_t payload_range_impl() const noexcept;
 
 	friend bool operator==(const mtrk_event_t&, const mtrk_event_t&) noexcept;
@@ -0,0 +1,122 @@
+#pragma once
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "midi_delta_time.h"
+#include "midi_status_byte.h"
+#include "midi_vlq.h"  // write_32bit_be()
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <algorithm>  // std::copy()
+
+
+namespace jmid {
+
+//
+// packed_ch_event_t
+//
+// An MTrk event in 8 bytes.  For a channel event, status, p1, p2 are the
+// status byte (never running status) and the data bytes (p2==0 for events
+// w/ only one data byte).  For any other event (meta, sysex), status is
+// the status byte of the event (0xFFu, 0xF0u, or 0xF7u) and {p1,p2,p3} is
+// the 24-bit (big-endian) index of the event in the side table of the
+// owning mtrk_packed_t.
+//
+struct packed_ch_event_t {
+	std::int32_t delta_time;
+	unsigned char status;
+	unsigned char p1;
+	unsigned char p2;
+	unsigned char p3;
+};
+static_assert(sizeof(packed_ch_event_t)==8);
+
+//
+// mtrk_packed_t
+//
+// A compact, append-only MTrk event sequence for holding large corpora in
+// memory.  Channel events, which are nearly all of the events in a
+// typical file, are stored in a packed_ch_event_t (8 bytes) rather than an
+// mtrk_event_t (24 bytes); meta and sysex events are kept as
+// mtrk_event_t in a side table and referred to by index from their slot
+// in the event sequence.  The events in the side table have a delta time
+// of 0; the delta time of every event is held in its slot.
+//
+// As w/ mtrk_columns_t, the object is not intended to be edited in place;
+// convert back to an mtrk_t w/ to_mtrk(), or write it out w/ write_mtrk().
+//
+class mtrk_packed_t {
+public:
+	using size_type = std::int32_t;
+	// Max number of meta and sysex events; the index is 24 bits
+	static constexpr size_type side_size_max = 0x00FFFFFF;
+
+	mtrk_packed_t() noexcept;
+	explicit mtrk_packed_t(const mtrk_t&);
+
+	size_type size() const noexcept;
+	// Number of meta and sysex events
+	size_type side_size() const noexcept;
+	// Onset tick of the last event; same as mtrk_t::nticks().  O(1).
+	std::int32_t nticks() const noexcept;
+	// Same as mtrk_t::nbytes(), data_nbytes() for the equivalent mtrk_t.
+	// O(n).
+	size_type nbytes() const;
+	size_type data_nbytes() const;
+
+	// Appends the event; ev must not be empty.  Calls std::abort() if ev is
+	// not a channel event and side_size()==side_size_max.
+	void push_back(const mtrk_event_t&);
+	void clear() noexcept;
+	// Reserves space for the given number of events, and of meta and sysex
+	// events
+	void reserve(size_type, size_type);
+
+	const packed_ch_event_t *begin() const noexcept;
+	const packed_ch_event_t *end() const noexcept;
+	const packed_ch_event_t& operator[](size_type) const noexcept;
+	bool is_channel(const packed_ch_event_t&) const noexcept;
+	// The meta or sysex event (w/ delta time 0) referred to by the slot;
+	// the slot must not be a channel event.
+	const mtrk_event_t& side_event(const packed_ch_event_t&) const noexcept;
+	// Rebuilds the event
+	mtrk_event_t event(const packed_ch_event_t&) const;
+
+	// Rebuilds the full event sequence; the result compares equal
+	// event-by-event w/ the sequence of events pushed back.
+	mtrk_t to_mtrk() const;
+private:
+	std::vector<packed_ch_event_t> evnts_ {};
+	std::vector<mtrk_event_t> side_ {};
+	std::int32_t nticks_ {0};
+};
+
+//
+// OIt write_mtrk(const mtrk_packed_t& mtrk, OIt it);
+//
+// Writes the MTrk chunk (header and events) to it; the output is the same
+// as write_mtrk(mtrk.to_mtrk(),it).
+//
+template<typename OIt>
+OIt write_mtrk(const mtrk_packed_t& mtrk, OIt it) {
+	std::array<char,4> h {'M','T','r','k'};
+	it = std::copy(h.begin(),h.end(),it);
+	it = jmid::write_32bit_be(static_cast<uint32_t>(mtrk.data_nbytes()), it);
+	for (const auto& e : mtrk) {
+		it = jmid::write_delta_time(e.delta_time,it);
+		if (mtrk.is_channel(e)) {
+			*it++ = e.status;
+			*it++ = e.p1;
+			if (jmid::channel_status_byte_n_data_bytes(e.status)==2) {
+				*it++ = e.p2;
+			}
+		} else {
+			const auto& ev = mtrk.side_event(e);
+			it = std::copy(ev.event_begin(),ev.end(),it);
+		}
+	}
+	return it;
+};
+
+}  // namespace jmid
+
@@ -5,6 +5,7 @@
 #include "mtrk_event_methods.h"  // is_eot()
 #include "generic_iterator.h"
 #include "make_mtrk_event.h"
+#include "byte_arena_t.h"
 #include <string>
 #include <cstdint>
 #include <vector>
@@ -12,6 +13,11 @@
 #include <type_traits>  // std::is_same<>
 #include <algorithm>  // std::rotate()
 #include <iterator>  // std::back_inserter
+#include <memory>  // std::unique_ptr
+#include <utility>  // std::move()
+#include <limits>  // std::numeric_limits in validate()
+#include <thread>  // merge_parallel()
+#include <exception>  // std::exception_ptr in merge_parallel()
 
 
 namespace jmid {
@@ -29,6 +35,34 @@ struct event_tk_t {
 	int32_t tk;
 };
 
+//
+// mtrk_diagnostic_t
+// A problem found by mtrk_t::validate() at event idx of the sequence.  
+// cumtk is the cumulative delta-time prior to that event (as for 
+// at_cumtk()); the onset tick is cumtk + the event's delta time.  For the note-related codes, ch and note 
+// identify the note; otherwise they are 0.  The text is produced only on
+// request, by explain().  
+//
+struct mtrk_diagnostic_t {
+	enum class errc : std::uint8_t {
+		// Warnings
+		multiple_note_on,  // A note-on for a note already sounding
+		orphan_note_off,  // A note-off for a note not sounding
+		// Errors
+		invalid_status_byte,
+		eot_not_last,  // An EOT event other than the last event
+		seqn_after_start,  // A sequence-number event after t=0 or after a ch event
+		no_terminal_eot,  // idx==size(); the last event is not an EOT
+		orphan_note_on,  // A note-on never matched by an off
+		other
+	};
+	mtrk_diagnostic_t::errc code;
+	std::int32_t idx;
+	std::int32_t cumtk;
+	unsigned char ch;
+	unsigned char note;
+};
+
 //
 // mtrk_t
 // Container adapter around std::vector<mtrk_event_t>
@@ -87,12 +121,35 @@ public:
 	size_type capacity() const;
 	// The size in bytes occupied by the container written out (serialized)
 	// as an MTrk chunk, including the 8-bytes occupied by the header.  
-	// This is an O(n) operation
 	size_type nbytes() const;
 	// Same as .nbytes(), but excluding the chunk header
 	size_type data_nbytes() const;
 	// Cumulative number of midi ticks occupied by the entire sequence
 	int32_t nticks() const;
+	// The container keeps running totals of the event sizes and delta 
+	// times, which are updated by the modifiers below (push_back(), 
+	// insert(), erase(), set_delta_time(), ...).  Since an event can be 
+	// modified in place through the reference or iterator returned by a
+	// non-const member, each of these accounts for the handle it returns:
+	// -> push_back() and emplace_back() return a reference to the event 
+	//    appended; the container remembers it, and a change to its size or
+	//    delta time is applied to the totals by the next call to a 
+	//    non-const member.  
+	// -> Every other member returning a mutable reference or iterator 
+	//    (begin(), end(), operator[], back(), front(), at_cumtk(), 
+	//    at_tkonset(), insert(), insert_no_tkshift(), erase(iterator), 
+	//    erase_no_tkshift(), set_delta_time()) marks the totals stale.  
+	// While the totals are stale, the const overloads of nbytes(),
+	// data_nbytes(), and nticks() sum over the events (O(n)) w/o writing
+	// to the container, so a const mtrk_t can be queried from several 
+	// threads; the non-const overloads recompute the totals, after which 
+	// all are O(1) until the next call to a member that marks them stale.
+	// As w/ the references and iterators into a std::vector, a handle 
+	// must not be used to modify an event after a later call to a 
+	// non-const member; obtain a new one or use set_delta_time().  
+	size_type nbytes();
+	size_type data_nbytes();
+	int32_t nticks();
 
 	iterator begin();
 	iterator end();
@@ -117,14 +174,25 @@ public:
 	event_tk_t<iterator> at_tkonset(int32_t);
 	event_tk_t<const_iterator> at_tkonset(int32_t) const;
 
-	// Returns a ref to the event just added
+	// Returns a ref to the event just added.  The rvalue overloads of 
+	// push_back() and insert() move the event into the container, so 
+	// the data of a big event (sysex, text, ...) is not copied.  
 	mtrk_event_t& push_back(const mtrk_event_t&);
+	mtrk_event_t& push_back(mtrk_event_t&&);
+	// Construct the event in place; the arguments are those of the 
+	// corresponding mtrk_event_t ctor.  Returns a ref to the new event.  
+	mtrk_event_t& emplace_back(std::int32_t, ch_event_data_t);
+	mtrk_event_t& emplace_back(std::int32_t, meta_header, 
+								const unsigned char*, const unsigned char*);
+	mtrk_event_t& emplace_back(std::int32_t, sysex_header, 
+								const unsigned char*, const unsigned char*);
 	void pop_back();
 	// Inserts arg2 _before_ arg1 and returns an iterator to the newly
 	// inserted event.  Note that if the new event has a nonzero delta_time
 	// insertion will timeshift all downstream events by that number of 
 	// ticks.  
 	iterator insert(iterator, const mtrk_event_t&);
+	iterator insert(iterator, mtrk_event_t&&);
 	// Insert the provided event into the sequence such that its onset tick
 	// is == the cumtk at arg1 + arg2.delta_time() and such that the onset 
 	// tick of all downstream events is unchanged.  The delta time of the
@@ -147,6 +215,10 @@ public:
 	// time > 0, it is added to the event immediately following the deleted
 	// event.  
 	iterator erase_no_tkshift(iterator);
+	// Sets the delta time of the event pointed to by the iterator; 
+	// equivalent to it->set_delta_time(dt), but keeps nbytes(), nticks() 
+	// and the tick index (see set_tk_index_enabled()) current.  Returns it.  
+	iterator set_delta_time(iterator, std::int32_t);
 
 	// Note that calling clear will cause !this.validate(), since there is
 	// no longer an EOT meta event at the end of the sequence.  
@@ -154,18 +226,148 @@ public:
 	void resize(size_type);
 	void reserve(size_type);
 
+	// Event arena
+	// If enabled, the buffers of the events too large for the small-object
+	// storage of mtrk_event_t (text and lyric metas, sysex, ...) read into 
+	// the track by make_mtrk_event_seq() (and thus by make_smf2(), 
+	// read_smf(), ...) are allocated from a monotonic arena owned by the 
+	// container rather than one at a time w/ new [].  Destroying or 
+	// clear()ing the track releases all of them at once; reading a new 
+	// track into the container reuses the arena memory.  The big events
+	// added by push_back(), emplace_back() and insert() are also allocated
+	// from the arena.  
+	// The arena moves w/ the container, but is not copied:  A copy of an
+	// mtrk_t holds ordinary events, and copy-assignment does not change
+	// whether the lhs uses an arena.  Moving an event transfers its buffer
+	// as-is, so an event whose buffer is in the arena depends on the 
+	// lifetime of the track.  push_back(), insert(), split_move_if(), the 
+	// merge_move() overloads and get_events_dt_ordered(smf_t&&) give each 
+	// event they move out of a track a copy of its data (see 
+	// mtrk_event_t::detach_arena()); an event moved out by other means 
+	// (std::move(trk[i]), std::swap(), ...) must not outlive the track 
+	// unless the caller calls detach_arena() on it.  
+	// set_arena_enabled(false) reallocates any events in the arena w/ 
+	// new [] before freeing the arena.  
+	void set_arena_enabled(bool);
+	bool arena_enabled() const;
+	// nullptr if !arena_enabled()
+	const internal::byte_arena_t *arena() const;
+
+	// Tick index
+	// If enabled, the container keeps a table of the cumulative tick 
+	// (cumtk) of each event, and at_cumtk(), at_tkonset(), 
+	// get_simultaneous_events(const mtrk_t&, const_iterator), and the 
+	// lookup in insert(std::int32_t, mtrk_event_t) are binary searches 
+	// (O(log(n))) rather than walks from the start of the track.  The 
+	// table is kept current by the modifiers.  It is invalidated by a call
+	// to begin(), end(), operator[], back() or front(), since a delta time
+	// can then be changed anywhere in the track through the reference or 
+	// iterator returned (it->set_delta_time(), trk[i] = ev, ...).  The 
+	// non-const at_cumtk() and at_tkonset() do not invalidate it:  The 
+	// container remembers the event pointed at by the iterator returned, 
+	// and a change to the delta time of that event is applied to the 
+	// table (O(n-idx)) by the next non-const lookup or modifier.  The 
+	// delta time of any other event must be changed w/ set_delta_time().
+	// While the table is stale (!tk_index_current()), the const lookups 
+	// walk the events as if the index were disabled; it is rebuilt (O(n))
+	// by set_tk_index_enabled(true), and by the next non-const at_cumtk(),
+	// at_tkonset(), or insert(std::int32_t, mtrk_event_t).  The const 
+	// lookups never modify the table, so a const mtrk_t can be searched 
+	// from several threads.  The table occupies 4*(size()+1) bytes.  
+	// As w/ the arena, the setting moves w/ the container but is not 
+	// copied.  
+	void set_tk_index_enabled(bool);
+	bool tk_index_enabled() const;
+	// True if the index is enabled and the const lookups can use it
+	bool tk_index_current() const;
+
 	// TODO:  This substantially duplicates the functionality of 
 	// make_mtrk(const unsigned char*, uint32_t);
 	// Could have make_mtrk() just call push_back() "blindly" on the
 	// sequence then call validate() on the object.  
+	//
+	// validate_t validate(std::int32_t max_diagnostics) const;
+	// Checks the sequence in a single pass, recording a compact
+	// mtrk_diagnostic_t for each problem found.  Sounding notes are 
+	// tracked in a 16x128 table of counters; as in 
+	// get_linked_onoff_pairs(), the first off for a given (ch,note) closes 
+	// the first on.  Stops at the first error, or as soon as 
+	// max_diagnostics diagnostics have been recorded (in which case 
+	// .truncated==true).  Orphan note-on events are reported after the 
+	// scan, at most one per on event.  
+	// Operator bool() is true if the scan completed and found no errors;
+	// warnings do not make a sequence invalid.  error() and warning() 
+	// format the diagnostics of each kind w/ explain().  
+	//
 	struct validate_t {
-		std::string error {};
-		std::string warning {};
+		std::vector<mtrk_diagnostic_t> diagnostics {};
+		bool truncated {false};
+		std::string error() const;
+		std::string warning() const;
 		operator bool() const;
 	};
-	validate_t validate() const;
+	validate_t validate(std::int32_t=std::numeric_limits<std::int32_t>::max()) const;
 private:
+	// Declared before evnts_, so that the events are destroyed first
+	std::unique_ptr<internal::byte_arena_t> arena_ {};
 	std::vector<mtrk_event_t> evnts_;
+	// Totals of evnts_[i].size() and evnts_[i].delta_time(); only valid 
+	// if !stale_.  Only the non-const members write these.  
+	std::int64_t data_nbytes_ {0};
+	std::int64_t nticks_ {0};
+	bool stale_ {false};
+	// Each does nothing if stale_
+	void add_to_totals(const mtrk_event_t&);
+	void sub_from_totals(const mtrk_event_t&);
+	// Recomputes the totals (O(n)) if stale_, then clears stale_
+	void update_totals();
+	// Updates the totals and the tick index for the event just appended by
+	// push_back() or emplace_back(), and watches it.  
+	mtrk_event_t& appended();
+	// iter_at(idx) for a member that returns a mutable iterator to the 
+	// event at idx:  Marks the totals stale and watches idx.  
+	iterator handout(size_type idx);
+	// If tk_index_current(), tkidx_[i] is the cumtk of event i and 
+	// tkidx_.size()==size()+1 (tkidx_.back()==nticks()); every modifier 
+	// keeps it so.  If !tkidx_enabled_, tkidx_ is empty.  tkidx_stale_ is
+	// set by the non-const accessors.  
+	bool tkidx_enabled_ {false};
+	bool tkidx_stale_ {false};
+	std::vector<std::int32_t> tkidx_ {};
+	// The event referred to by the handle returned by the last non-const
+	// lookup or modifier, and its delta time and size at the time, or -1.
+	// Neither the totals nor tkidx_ reflect a change to the event until 
+	// apply_watch() is called; every non-const member other than the 
+	// accessors calls it before using or patching either.  
+	size_type watch_ {-1};
+	std::int32_t watch_dt_ {0};
+	std::int32_t watch_size_ {0};
+	// Sets watch_ (-1 if idx >= size())
+	void watch(size_type idx);
+	// evnts_[watch_].delta_time()-watch_dt_ and evnts_[watch_].size()-
+	// watch_size_, or 0 if watch_==-1
+	std::int32_t watched_dt_change() const;
+	std::int32_t watched_size_change() const;
+	// Applies the watched changes to the totals if !stale_ and to tkidx_ 
+	// if current, then clears watch_
+	void apply_watch();
+	// apply_watch(), then rebuild_tk_index() if tkidx_stale_
+	void update_tk_index();
+	// rebuild_tk_index() clears tkidx_stale_, and does nothing else if 
+	// !tkidx_enabled_; it is O(n).  The caller must have called 
+	// apply_watch() or cleared watch_.  The others do nothing if 
+	// !tk_index_current(), and patch tkidx_ for an event inserted at, or 
+	// erased from, idx (O(n-idx)).  
+	void rebuild_tk_index();
+	void tk_index_inserted(size_type idx);
+	void tk_index_erased(size_type idx, std::int32_t dt);
+	// Adds dtk to tkidx_[idx], tkidx_[idx+1], ...
+	void tk_index_shift(size_type idx, std::int32_t dtk);
+	// Same as begin()+idx
+	iterator iter_at(size_type);
+
+	friend mtrk_t::const_iterator get_simultaneous_events(const mtrk_t&,
+									mtrk_t::const_iterator);
 
 	template <typename InIt>
 	friend InIt make_mtrk(InIt, InIt, maybe_mtrk_t*, mtrk_error_t*,
@@ -237,6 +439,12 @@ struct mtrk_error_t {
 // if ec == mtrk_error_t::errc::no_error, returns an empty string
 std::string print(mtrk_error_t::errc);
 std::string explain(const mtrk_error_t&);
+// std::string print(mtrk_diagnostic_t::errc ec);
+std::string print(mtrk_diagnostic_t::errc);
+std::string explain(const mtrk_diagnostic_t&);
+// Errors make a sequence invalid (see mtrk_t::validate()); the other 
+// codes are warnings.  
+bool is_error(mtrk_diagnostic_t::errc);
 struct maybe_mtrk_t {
 	mtrk_t mtrk;
 	std::ptrdiff_t nbytes_read;
@@ -245,11 +453,50 @@ struct maybe_mtrk_t {
 };
 
 
+//
+// std::int32_t count_mtrk_events(const unsigned char *beg, 
+//						const unsigned char *end, unsigned char rs);
+//
+// Fast pre-scan returning the number of events on [beg,end), up to and 
+// including the first EOT event.  Events are not validated, only skipped
+// over:  The delta time is skipped w/ advance_to_dt_end(), the length of
+// a channel event is obtained from the status byte (taking into account
+// running status), and for meta and sysex events, from the vlq length 
+// field.  The scan stops at the first byte that can not be interpreted as
+// a status or running-status byte.  Thus, for a valid sequence, the result
+// is exactly the number of events make_mtrk_event_seq() will read; for an
+// invalid sequence, it is an upper bound.  
+//
+// std::int32_t estimate_n_mtrk_events(std::int32_t nbytes);
+//
+// Estimates the number of events in an MTrk w/ a data section of nbytes
+// bytes w/o examining the data.  Intended for reserving space where the
+// input can not be pre-scanned (ex, for input iterators).  Most events in
+// real files are 3-4 byte channel events (3 bytes in running status); 
+// larger events are comparatively rare, so nbytes/3 is a generous upper
+// bound for the common case.  Since nbytes usually comes from an 
+// unverified chunk header, the result is capped at 
+// estimate_n_mtrk_events_max so that a corrupt length field can not 
+// trigger a huge allocation; beyond this, the container grows as usual.  
+//
+std::int32_t count_mtrk_events(const unsigned char*, const unsigned char*,
+								unsigned char);
+inline constexpr std::int32_t estimate_n_mtrk_events_max = 0x10000;
+std::int32_t estimate_n_mtrk_events(std::int32_t);
+
 //
 // Overwrites the mtrk_event_t's in result beginning at result[0] and 
-// proceeding until it==end or and eot event is encountered.  result is
-// resized such that result.size() == the number of events that were
-// overwritten.  
+// proceeding until it==end or and eot event is encountered.  Events 
+// already present in result are reused; if the input contains more events
+// than result.size(), new events are appended.  result is resized such 
+// that result.size() == the number of events read.  
+//
+// Where InIt is a pointer (ie, the input is contiguous), the number of
+// events is first counted w/ count_mtrk_events() and space for exactly 
+// that many events is reserved, so a fresh result is allocated exactly 
+// once.  Otherwise, space is not reserved beyond what the caller has 
+// already reserved (see estimate_n_mtrk_events()).  
+//
 template <typename InIt>
 InIt make_mtrk_event_seq(InIt it, InIt end, unsigned char rs, 
 						mtrk_t *result, mtrk_error_t *err) {
@@ -260,16 +507,31 @@ InIt make_mtrk_event_seq(InIt it, InIt end, unsigned char rs,
 		}
 	};
 	set_error(mtrk_error_t::errc::no_error,rs);
+	// The arena memory held by events about to be overwritten is 
+	// reclaimed all at once rather than left in the arena.  
+	if (result->arena_) {
+		result->evnts_.clear();
+		result->arena_->release();
+	}
+	internal::arena_scope_t arena_scope(result->arena_.get());
+
+	if constexpr (std::is_pointer<InIt>::value) {
+		static_assert(sizeof(*it)==1);
+		auto n = jmid::count_mtrk_events(
+			reinterpret_cast<const unsigned char*>(it),
+			reinterpret_cast<const unsigned char*>(end),rs);
+		result->evnts_.reserve(n);
+	}
 
 	bool found_eot = false;
-	jmid::mtrk_event_t *p_curr_event = result->evnts_.data();
-	// NB:  p_curr_event may not be dereferenceable if size()==0.  
+	std::size_t n_read = 0;
+	std::int64_t data_nbytes = 0;
+	std::int64_t nticks = 0;
 	while ((it!=end) && (!found_eot)) {
-		if (p_curr_event == (result->evnts_.data() + result->evnts_.size())) {
-			auto init_sz = result->evnts_.size();
-			result->evnts_.resize(2*init_sz);  // TODO:  Magic number 2
-			p_curr_event = result->evnts_.data() + init_sz;
+		if (n_read == result->evnts_.size()) {
+			result->evnts_.emplace_back();
 		}
+		auto p_curr_event = result->evnts_.data() + n_read;
 
 		jmid::mtrk_event_error_t curr_mtrk_event_error;
 		it = jmid::make_mtrk_event3(it,end,rs,p_curr_event,&curr_mtrk_event_error);
@@ -277,17 +539,27 @@ InIt make_mtrk_event_seq(InIt it, InIt end, unsigned char rs,
 			// I could check curr_event.size() != 0, but this is more expensive 
 			// than testing curr_mtrk_event_error
 			set_error(mtrk_error_t::errc::invalid_event,rs);
-			result->evnts_.resize(p_curr_event - result->evnts_.data());
+			result->evnts_.resize(n_read);
+			result->data_nbytes_ = data_nbytes;
+			result->nticks_ = nticks;
+			result->stale_ = false;
+			result->watch_ = -1;
+			result->rebuild_tk_index();
 			return it;
 		}
 		
-		if (!found_eot) {
-			found_eot = jmid::is_eot(*p_curr_event);
-		}
+		found_eot = jmid::is_eot(*p_curr_event);
 		rs = p_curr_event->running_status();
-		++p_curr_event;
+		data_nbytes += p_curr_event->size();
+		nticks += p_curr_event->delta_time();
+		++n_read;
 	}
-	result->evnts_.resize(p_curr_event - result->evnts_.data());
+	result->evnts_.resize(n_read);
+	result->data_nbytes_ = data_nbytes;
+	result->nticks_ = nticks;
+	result->stale_ = false;
+	result->watch_ = -1;
+	result->rebuild_tk_index();
 
 	if (!found_eot) {
 		set_error(mtrk_error_t::errc::no_eot_event,rs);
@@ -298,6 +570,15 @@ InIt make_mtrk_event_seq(InIt it, InIt end, unsigned char rs,
 };
 
 
+//
+// OIt write_mtrk(const mtrk_t& mtrk, OIt it);
+// unsigned char *write_mtrk(const mtrk_t& mtrk, unsigned char *dest);
+//
+// Writes the MTrk chunk (header and events) to it.  The overload for 
+// unsigned char* writes to a contiguous buffer w/ room for at least 
+// mtrk.nbytes() bytes, copying the storage of each event w/ a single 
+// std::memcpy() rather than byte-by-byte.  The output is identical.  
+//
 template<typename OIt>
 OIt write_mtrk(const mtrk_t& mtrk, OIt it) {
 	std::array<char,4> h {'M','T','r','k'};
@@ -310,6 +591,7 @@ OIt write_mtrk(const mtrk_t& mtrk, OIt it) {
 	}
 	return it;
 };
+unsigned char *write_mtrk(const mtrk_t&, unsigned char*);
 
 
 //
@@ -322,6 +604,9 @@ OIt write_mtrk(const mtrk_t& mtrk, OIt it) {
 // tk onset < the tk onset of the off-event matching beg.  
 mtrk_t::const_iterator get_simultaneous_events(mtrk_t::const_iterator, mtrk_t::const_iterator);
 mtrk_t::iterator get_simultaneous_events(mtrk_t::iterator, mtrk_t::iterator);
+// Same as get_simultaneous_events(beg,mtrk.end()), but a binary search if 
+// mtrk.tk_index_enabled() (see mtrk_t).  beg must be an iterator into mtrk.  
+mtrk_t::const_iterator get_simultaneous_events(const mtrk_t&, mtrk_t::const_iterator);
 
 //
 // find_linked_off(mtrk_const_iterator_t beg, mtrk_const_iterator_t end,
@@ -346,6 +631,13 @@ event_tk_t<mtrk_t::const_iterator> find_linked_off(mtrk_t::const_iterator,
 // get_linked_onoff_pairs()
 // Find all the linked note-on/off event pairs on [beg,end)
 //
+// A note-off event (incl. a note-on w/ velocity 0) is linked to the 
+// earliest unlinked note-on event on the same channel w/ the same note 
+// number; if several note-ons for the same note are sounding, the first
+// off matches the first on, the second off the second on, etc (as in 
+// mtrk_t::validate()).  The results are in order of the on events.  The 
+// events are scanned once; the cost is O(n) in the number of events.  
+//
 // For each linked pair {on,off}, the field cumtk (on.cumtk, off.cumtk) is 
 // the cumulative number of ticks immediately prior to the event pointed 
 // at by the iterator in field ev (on.ev, off.ev).  For a 
@@ -356,7 +648,8 @@ event_tk_t<mtrk_t::const_iterator> find_linked_off(mtrk_t::const_iterator,
 // int32_t duration = (p.on.cumtk+p.on.ev->delta_time()) 
 //                     - (p.off.cumtk+p.off.ev->delta_time());
 //
-// Orphan note-on events are not included in the results.  
+// Orphan note-on events are not included in the results; to obtain the 
+// orphan on and off events, call get_linked_onoff_pairs_and_orphans().  
 //
 struct linked_onoff_pair_t {
 	event_tk_t<mtrk_t::const_iterator> on;
@@ -364,6 +657,21 @@ struct linked_onoff_pair_t {
 };
 std::vector<linked_onoff_pair_t>
 	get_linked_onoff_pairs(mtrk_t::const_iterator,mtrk_t::const_iterator);
+//
+// get_linked_onoff_pairs_and_orphans()
+// As get_linked_onoff_pairs(); in addition, the note-on events left
+// w/o an off event at end, and the note-off events w/o a sounding on 
+// event, are returned in orphan_on and orphan_off (each in the order in 
+// which they occur in [beg,end)).  The field tk has the same meaning as
+// for the events of a linked_onoff_pair_t.  
+//
+struct linked_and_orphans_t {
+	std::vector<linked_onoff_pair_t> linked {};
+	std::vector<event_tk_t<mtrk_t::const_iterator>> orphan_on {};
+	std::vector<event_tk_t<mtrk_t::const_iterator>> orphan_off {};
+};
+linked_and_orphans_t get_linked_onoff_pairs_and_orphans(
+					mtrk_t::const_iterator,mtrk_t::const_iterator);
 
 //
 // Print a table of linked note-on/off event pairs in the input mtrk_t.  
@@ -390,8 +698,8 @@ OIt split_copy_if(InIt beg, InIt end, OIt dest, UPred pred) {
 		if (pred(*curr)) {
 			auto curr_cpy = *curr;
 			curr_cpy.set_delta_time(curr_cpy.delta_time() + (cumtk_src-cumtk_dest));
-			*dest++ = curr_cpy;
 			cumtk_dest += curr_cpy.delta_time();
+			*dest++ = std::move(curr_cpy);
 		}
 		cumtk_src += curr->delta_time();
 	}
@@ -405,6 +713,35 @@ mtrk_t split_copy_if(const mtrk_t& mtrk, UPred pred) {
 	return result;
 };
 
+//
+// OIt split_move_if(FwIt beg, FwIt end, OIt dest, UPred pred)
+//
+// Same as split_copy_if(), but the events matching pred are moved, rather 
+// than copied, into dest; the data of big events (sysex, text, ...) is 
+// not reallocated.  The moved-from events on [beg,end) are left empty
+// (mtrk_event_t::is_empty()); the delta times of the events not matching
+// pred are unchanged.  Intended for pipelines where the source range is 
+// about to be discarded.  The data of events in the arena of an mtrk_t
+// w/ arena_enabled() is copied rather than moved (see mtrk_t).  
+//
+template<typename FwIt, typename OIt, typename UPred>
+OIt split_move_if(FwIt beg, FwIt end, OIt dest, UPred pred) {
+	std::int32_t cumtk_src = 0;
+	std::int32_t cumtk_dest = 0;
+	for (auto curr=beg; curr!=end; ++curr) {
+		auto curr_dt = curr->delta_time();
+		if (pred(*curr)) {
+			auto curr_ev = std::move(*curr);
+			curr_ev.detach_arena();
+			curr_ev.set_delta_time(curr_dt + (cumtk_src-cumtk_dest));
+			cumtk_dest += curr_ev.delta_time();
+			*dest++ = std::move(curr_ev);
+		}
+		cumtk_src += curr_dt;
+	}
+	return dest;
+};
+
 //
 // FwIt split_if(FwIt beg, FwIt end, UPred pred)
 //
@@ -464,8 +801,11 @@ mtrk_t split_if(mtrk_t& mtrk, UPred pred) {
 // stream.  If an event block in range 1 has the same onset tk as an event 
 // range in range 2, the block in range 1 is merged first.  
 //
-template<typename InIt, typename OIt>
-OIt merge(InIt beg1, InIt end1, InIt beg2, InIt end2, OIt dest) {
+namespace internal {
+// If move_events, the events are moved (rather than copied) from the input
+// ranges.  
+template<bool move_events, typename InIt, typename OIt>
+OIt merge_impl(InIt beg1, InIt end1, InIt beg2, InIt end2, OIt dest) {
 	std::int32_t ontk_1 = 0;
 	if (beg1 != end1) {
 		ontk_1 = beg1->delta_time();
@@ -512,9 +852,17 @@ OIt merge(InIt beg1, InIt end1, InIt beg2, InIt end2, OIt dest) {
 			}
 		}
 		while (curr_beg!=curr_end) {
-			auto curr_ev_cpy = *curr_beg;
-			curr_ev_cpy.set_delta_time(ontk_curr - cumtk_dest);
-			*dest = curr_ev_cpy;
+			auto curr_ev = [&]() {
+				if constexpr (move_events) {
+					auto ev = std::move(*curr_beg);
+					ev.detach_arena();
+					return ev;
+				} else {
+					return *curr_beg;
+				}
+			}();
+			curr_ev.set_delta_time(ontk_curr - cumtk_dest);
+			*dest = std::move(curr_ev);
 			cumtk_dest += (ontk_curr - cumtk_dest);
 			++dest;
 			++curr_beg;
@@ -522,6 +870,198 @@ OIt merge(InIt beg1, InIt end1, InIt beg2, InIt end2, OIt dest) {
 	}
 	return dest;
 };
+}  // namespace internal
+template<typename InIt, typename OIt>
+OIt merge(InIt beg1, InIt end1, InIt beg2, InIt end2, OIt dest) {
+	return internal::merge_impl<false>(beg1,end1,beg2,end2,dest);
+};
+
+//
+// OIt merge_move(FwIt beg1, FwIt end1, FwIt beg2, FwIt end2, OIt dest)
+//
+// Same as merge(), but the events are moved, rather than copied, from the 
+// input ranges into dest.  All the events on [beg1,end1) and [beg2,end2) 
+// are left empty (mtrk_event_t::is_empty()).  As for split_move_if(), 
+// the data of events in an mtrk_t w/ arena_enabled() is copied.  
+//
+template<typename FwIt, typename OIt>
+OIt merge_move(FwIt beg1, FwIt end1, FwIt beg2, FwIt end2, OIt dest) {
+	return internal::merge_impl<true>(beg1,end1,beg2,end2,dest);
+};
+
+//
+// OIt merge(RIt beg, RIt end, OIt dest)
+// OIt merge_move(RIt beg, RIt end, OIt dest)
+//
+// N-ary versions of merge() and merge_move():  Each element of [beg,end)
+// is an mtrk_t (ex, [beg,end) is a range of a std::vector<mtrk_t>, or of 
+// an smf_t), and the events of all of them are merged into dest.  The
+// result is the same as that of merging the tracks one at a time, in 
+// order, w/ the 2-range merge():  Events are merged in blocks of the same
+// onset tk, and for blocks w/ the same onset tk, the block from the track
+// nearest beg is merged first.  
+//
+// Rather than N-1 passes over a growing intermediate sequence (O(N*n)
+// for n events in total), the tracks are merged in a single pass w/ a 
+// binary min-heap holding the position of the next block in each track, 
+// so that the cost is O(n*log(N)).  
+//
+namespace internal {
+template<bool move_events, typename RIt, typename OIt>
+OIt merge_n_impl(RIt beg, RIt end, OIt dest) {
+	auto get_begin = [](auto& trk) {
+		if constexpr (move_events) {
+			return trk.begin();
+		} else {
+			return std::as_const(trk).begin();
+		}
+	};
+	auto get_end = [](auto& trk) {
+		if constexpr (move_events) {
+			return trk.end();
+		} else {
+			return std::as_const(trk).end();
+		}
+	};
+	using It = decltype(get_begin(*beg));
+	struct pos_t {
+		It curr;
+		It end;
+		std::int32_t ontk;  // Of *curr
+		std::int32_t trackn;
+	};
+	auto gt = [](const pos_t& lhs, const pos_t& rhs)->bool {
+		if (lhs.ontk == rhs.ontk) {
+			return lhs.trackn > rhs.trackn;
+		}
+		return lhs.ontk > rhs.ontk;
+	};
+	std::vector<pos_t> heap;
+	std::int32_t trackn = 0;
+	for (auto it=beg; it!=end; ++it) {
+		auto curr = get_begin(*it);
+		auto curr_end = get_end(*it);
+		if (curr != curr_end) {
+			heap.push_back({curr,curr_end,curr->delta_time(),trackn});
+		}
+		++trackn;
+	}
+	std::make_heap(heap.begin(),heap.end(),gt);
+
+	std::int32_t cumtk_dest = 0;
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(),heap.end(),gt);
+		auto& p = heap.back();
+		auto blk_end = get_simultaneous_events(p.curr,p.end);
+		for (; p.curr!=blk_end; ++p.curr) {
+			auto curr_ev = [&]() {
+				if constexpr (move_events) {
+					auto ev = std::move(*(p.curr));
+					ev.detach_arena();
+					return ev;
+				} else {
+					return *(p.curr);
+				}
+			}();
+			curr_ev.set_delta_time(p.ontk - cumtk_dest);
+			*dest = std::move(curr_ev);
+			cumtk_dest = p.ontk;
+			++dest;
+		}
+		if (p.curr == p.end) {
+			heap.pop_back();
+		} else {
+			p.ontk += p.curr->delta_time();
+			std::push_heap(heap.begin(),heap.end(),gt);
+		}
+	}
+	return dest;
+};
+}  // namespace internal
+template<typename RIt, typename OIt>
+OIt merge(RIt beg, RIt end, OIt dest) {
+	return internal::merge_n_impl<false>(beg,end,dest);
+};
+template<typename RIt, typename OIt>
+OIt merge_move(RIt beg, RIt end, OIt dest) {
+	return internal::merge_n_impl<true>(beg,end,dest);
+};
+
+//
+// OIt merge_parallel(RaIt beg, RaIt end, OIt dest, int nthreads=0)
+//
+// Produces the same result as merge(beg,end,dest), but on up to nthreads
+// threads (the calling thread is one of them).  If nthreads <= 0, uses 
+// std::thread::hardware_concurrency().  The tracks are divided into 
+// nthreads contiguous groups of (nearly) equal number, each group is 
+// merged w/ merge() into its own mtrk_t concurrently, and the group 
+// results are then merged w/ merge_move() into dest on the calling thread.
+// Since the groups are contiguous and in order, ties between blocks are 
+// broken exactly as in merge().  Each thread is given at least two 
+// tracks; for fewer than 4 tracks, this is merge(beg,end,dest).  
+//
+// The tracks on [beg,end) are only read, but each is read by a single 
+// thread, and no other thread may modify them during the call.  The 
+// intern store in effect on the calling thread (see intern_scope_t) is 
+// installed on each worker.  An exception thrown on a worker is rethrown
+// on the calling thread once all the workers have been joined; nothing 
+// is written to dest in that case.  
+//
+template<typename RaIt, typename OIt>
+OIt merge_parallel(RaIt beg, RaIt end, OIt dest, int nthreads=0) {
+	auto ntrks = static_cast<int>(end-beg);
+	if (nthreads <= 0) {
+		nthreads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	nthreads = std::max(1,std::min(nthreads,ntrks/2));
+	if (nthreads == 1) {
+		return internal::merge_n_impl<false>(beg,end,dest);
+	}
+
+	std::vector<mtrk_t> grps(nthreads);
+	std::vector<std::exception_ptr> excs(nthreads);
+	auto store = internal::current_intern_store();
+	auto worker = [&](int i)->void {
+		internal::intern_scope_t intern_scope(store);
+		try {
+			auto grp_beg = beg + (ntrks*i)/nthreads;
+			auto grp_end = beg + (ntrks*(i+1))/nthreads;
+			mtrk_t::size_type n = 0;
+			for (auto it=grp_beg; it!=grp_end; ++it) {
+				n += std::as_const(*it).size();
+			}
+			grps[i].reserve(n);
+			internal::merge_n_impl<false>(grp_beg,grp_end,
+				std::back_inserter(grps[i]));
+		} catch (...) {
+			excs[i] = std::current_exception();
+		}
+	};
+	std::vector<std::thread> threads;
+	threads.reserve(nthreads-1);
+	try {
+		for (int i=1; i<nthreads; ++i) {
+			threads.emplace_back(worker,i);
+		}
+	} catch (...) {
+		// A std::thread destroyed while joinable calls std::terminate(), so
+		// the workers already started are joined before rethrowing.  
+		for (auto& t : threads) {
+			t.join();
+		}
+		throw;
+	}
+	worker(0);
+	for (auto& t : threads) {
+		t.join();
+	}
+	for (const auto& e : excs) {
+		if (e) {
+			std::rethrow_exception(e);
+		}
+	}
+	return internal::merge_n_impl<true>(grps.begin(),grps.end(),dest);
+};
 
 
 }  // namespace jmid
@@ -6,6 +6,8 @@ namespace jmid {
 
 namespace internal {
 
+class byte_intern_t;
+
 //
 // TODO:  
 // -Why not just store int32_t (rather than uint32_t) in big_t?
@@ -17,11 +19,15 @@ namespace internal {
 // Class small_t
 // Invariants:  
 // -> flags_&0x80u==0x80u
-// -> flags_&0x7Fu==size(); size() <= capacity();
+// -> flags_&size_mask==size(); size() <= capacity();
 // -> capacity() is constant && capacity()==small_t::size_max()
+// -> flags_&meta_mask are not interpreted; they are preserved by resize()
+//    and cleared by init() (see small_bytevec_t::small_meta()).  
 //
 struct small_t {
 	static constexpr std::int32_t size_max = 23;
+	static constexpr unsigned char size_mask = 0x1Fu;
+	static constexpr unsigned char meta_mask = 0x60u;
 
 	unsigned char flags_;  // small => flags_&0x80u==0x80u
 	std::array<unsigned char,23> d_;
@@ -49,9 +55,16 @@ struct small_t {
 // -> flags_&0x80u==0x00u
 // -> p_ is a valid ptr or nullptr
 // -> If p_==nullptr, sz_==cap_==0
+// -> If flags_&flag_arena, p_ was obtained from a byte_arena_t (see 
+//    arena_scope_t) and is never delete []d.  
+// -> If flags_&flag_shared, p_ points into a byte_intern_t and may be 
+//    referred to by other objects; it is never delete []d or written to, 
+//    and cap_==sz_ at the time it is adopted.  
 //
 struct big_t {
 	static constexpr std::int32_t size_max = 0x0FFFFFFF;
+	static constexpr unsigned char flag_arena = 0x01u;
+	static constexpr unsigned char flag_shared = 0x02u;
 	using pad_t = std::array<unsigned char,7>;
 
 	unsigned char flags_;  // big => flags_&0x80u==0x00u
@@ -68,20 +81,42 @@ struct big_t {
 	// be called from an _initialized_ state.  
 	void free_and_reinit() noexcept;
 	// Object must be initialized before calling.  If p_!=nullptr, 
-	// deletes p_, then assigns pad_, sz_, cap_ to the values passed in
-	void adopt(const pad_t&, unsigned char*, std::int32_t, std::int32_t) noexcept;
+	// deletes p_, then assigns pad_, sz_, cap_ to the values passed in.  
+	// The last two arguments indicate whether the new p_ is owned by an 
+	// arena, and whether it is shared (interned).  
+	void adopt(const pad_t&, unsigned char*, std::int32_t, std::int32_t,
+				bool=false, bool=false) noexcept;
+	// delete []s p_ unless p_==nullptr or p_ is owned by an arena or 
+	// shared.  Does not modify any members.  
+	void free_buffer() noexcept;
+	bool is_arena_owned() const noexcept;
+	bool is_shared() const noexcept;
+	// If is_shared(), copies the data into a newly allocated buffer (w/ 
+	// capacity()==size()) owned by the object; otherwise does nothing.  
+	void unshare();
 	std::int32_t size() const noexcept;
 	// Sets size==0, does not alter capacity
 	void clear() noexcept;
 	// resize() and resize_nocopy() only change the capacity() when new_sz
-	// is > the present capacity.  
+	// is > the present capacity.  resize() grows the capacity geometrically
+	// (to at least twice the present capacity) unless the present capacity
+	// is 0, so that a sequence of small increases is amortized O(1) per 
+	// byte.  Both unshare() a shared buffer.  
 	std::int32_t resize(std::int32_t);
 	// If resizing to something bigger than the present capacity, does 
-	// not copy the data into the new buffer; if resizing smaller, the 
-	// effect is the same as a call to resize().  
+	// not copy the data into the new buffer, and allocates exactly new_sz;
+	// if resizing smaller, the effect is the same as a call to resize().  
 	std::int32_t resize_nocopy(std::int32_t);
+	// Increases the capacity to exactly the value passed in if it is > the
+	// present capacity.  
 	std::int32_t reserve(std::int32_t);
+	// Reallocates so that capacity()==std::max(new_cap,size()), growing or 
+	// shrinking the buffer as needed.  
+	std::int32_t reserve_exact(std::int32_t);
 	std::int32_t capacity() const noexcept;
+	// Allocates a buffer of exactly new_cap bytes (new_cap must be 
+	// >= size()), copies the data into it, and adopts it.  
+	void reallocate(std::int32_t);
 
 	void abort_if_not_active() const noexcept;
 	
@@ -96,6 +131,13 @@ struct big_t {
 // Very simple "'small' std::vector"-like class for managing an array 
 // of unsigned char.  
 //
+// A big object may share its buffer w/ other objects through a 
+// byte_intern_t (see intern()); the buffer is copied-on-write:  Any 
+// method that can write to the data, including the non-const begin(), 
+// end() and data_range(), first gives the object a buffer of its own.  
+// Read the data of a possibly-shared object through a const reference to
+// avoid the copy.  
+//
 struct small_bytevec_range_t {
 	unsigned char *begin;
 	unsigned char *end;
@@ -117,7 +159,9 @@ public:
 
 	// Copy ctor.  The new object has size-type appropriate to rhs.size(), 
 	// and does _not_ necessarily inherit the size-type of rhs.  Big objects
-	// are _only_ produced when rhs.size() > small_t::size_max.  
+	// are _only_ produced when rhs.size() > small_t::size_max.  If rhs 
+	// is_shared(), the new object shares the buffer of rhs and nothing is
+	// allocated or copied; this is also true of copy assignment.  
 	small_bytevec_t(const small_bytevec_t&);
 	// Copy assign.  The lhs object retains its size-type if sufficient to 
 	// accomodate rhs.size().  This means that a big lhs remains big always, 
@@ -128,7 +172,9 @@ public:
 	// Move ctor, move assignment; the new/destination object inherits the 
 	// same size-type as the source, even if the source data will fit in a 
 	// small object.  Contrast w/the copy ctor/assign op.  The source object
-	// is left 'small' w/a size()==0.  
+	// is left 'small' w/a size()==0.  A buffer owned by an arena is 
+	// transferred like any other, so the destination depends on the 
+	// lifetime of the arena; see detach_arena().  
 	small_bytevec_t(small_bytevec_t&&) noexcept;
 	small_bytevec_t& operator=(small_bytevec_t&&) noexcept;
 	// Dtor;  the destructed state is a 'small 'object w/ size()==0.  
@@ -142,11 +188,28 @@ public:
 	// (with a small->big transition if necessary); if new_cap <= the present
 	// capacity, does nothing.  
 	std::int32_t reserve(std::int32_t);
+	// int32_t reserve_exact(int32_t new_cap);
+	// For a big object, reallocates so that the capacity is exactly 
+	// std::max(new_cap,size()); unlike reserve(), this may decrease the 
+	// capacity.  Does not cause big->small transitions.  A small object 
+	// becomes big w/ capacity()==new_cap if new_cap > capacity_small, 
+	// otherwise it is not changed.  
+	std::int32_t reserve_exact(std::int32_t);
+	// void shrink_to_fit();
+	// Frees the unused capacity of a big object:  If size() <= 
+	// capacity_small, the object becomes small, otherwise the buffer is 
+	// reallocated w/ capacity()==size().  Does nothing for small objects 
+	// and for big objects whose buffer is owned by an arena (the memory 
+	// can not be returned to the arena until the arena is released) or is
+	// shared.  
+	void shrink_to_fit();
 	// unsigned char *resize(std::int32_t new_sz);
 	// Changes the size() of the object to the new value.  Does not cause 
 	// unnecessary size transitions:  big objects /always/ remain big, small 
 	// objects remain small if new_sz < small_t::size_max, otherwise they 
-	// become big.  
+	// become big.  A small->big transition allocates exactly new_sz bytes;
+	// growing a big object beyond its capacity at least doubles the 
+	// capacity.  
 	unsigned char *resize(std::uint64_t);
 	unsigned char *resize(std::int64_t);
 	unsigned char *resize(std::int32_t);
@@ -164,15 +227,50 @@ public:
 
 	bool debug_is_big() const noexcept;
 	bool debug_is_small() const noexcept;
+	bool is_big() const noexcept;
+	bool is_small() const noexcept;
 
-	small_bytevec_range_t data_range() noexcept;
+	// void intern(byte_intern_t& store);
+	// If the object is big and size() > capacity_small, replaces the buffer
+	// w/ the copy of the data held by store (see byte_intern_t::intern()),
+	// freeing the present buffer; the object is then is_shared().  
+	// Otherwise does nothing.  The metadata is preserved.  
+	void intern(byte_intern_t&);
+	bool is_shared() const noexcept;
+
+	// void detach_arena();
+	// If the object is big and its buffer is owned by an arena, copies the
+	// data into a buffer of the same capacity obtained from the arena of 
+	// the innermost arena_scope_t, if any, otherwise w/ new [], so that the 
+	// object no longer depends on the lifetime of the original arena.  
+	// Otherwise does nothing.  The metadata is preserved.  
+	void detach_arena();
+	bool is_arena_owned() const noexcept;
+
+	//
+	// Object metadata
+	// Space in the object not needed to represent the data, which the 
+	// owner can use to cache information derived from the data (see 
+	// mtrk_event_t).  small_bytevec_t never interprets it.  A small object
+	// has 2 bits (small_meta()), a big object has the 7-byte big_t::pad_ 
+	// (pad_or_data_range()).  Moves carry the metadata along w/ the data;
+	// after any other operation it is unspecified, and the owner must 
+	// rewrite it.  
+	//
+	static constexpr unsigned char small_meta_max = 0x03u;
+	// Only meaningful if is_small()
+	unsigned char small_meta() const noexcept;
+	// Does nothing if !is_small(); the value is truncated to small_meta_max
+	void set_small_meta(unsigned char) noexcept;
+
+	small_bytevec_range_t data_range();
 	small_bytevec_const_range_t data_range() const noexcept;
 	small_bytevec_range_t pad_or_data_range() noexcept;
 	small_bytevec_const_range_t pad_or_data_range() const noexcept;
 
-	unsigned char* begin() noexcept;
+	unsigned char* begin();
 	const unsigned char* begin() const noexcept;
-	unsigned char* end() noexcept;
+	unsigned char* end();
 	const unsigned char* end() const noexcept;
 	unsigned char* raw_begin() noexcept;
 	const unsigned char* raw_begin() const noexcept;
@@ -186,9 +284,6 @@ private:
 	};
 	sbou_t u_;
 
-	bool is_big() const noexcept;
-	bool is_small() const noexcept;
-
 	// Call only on an unitialized object; calls the init() method of the 
 	// corresponding type (note that big_t::init(), and therefore init_big(),
 	// does _not_ free memory).  These functions are how i formally change
@@ -197,6 +292,26 @@ private:
 	void init_big() noexcept;
 };
 
+//
+// small_bytevec_stats_t get_small_bytevec_stats();
+// void reset_small_bytevec_stats();
+//
+// Running counts, for the calling thread, of the buffers allocated for big
+// objects (from the heap or from an arena) and of the bytes copied from an
+// old buffer into a new one when a big object reallocates, or when a small
+// object becomes big.  Copies of the data between distinct objects (ie, 
+// copy construction/assignment) are not counted as "bytes copied," but any
+// allocation they cause is.  Meant for tests and benchmarks to confirm that
+// a code path does the expected number of allocations.  
+//
+struct small_bytevec_stats_t {
+	std::int64_t n_allocs {0};
+	std::int64_t n_bytes_allocated {0};
+	std::int64_t n_bytes_copied {0};
+};
+small_bytevec_stats_t get_small_bytevec_stats() noexcept;
+void reset_small_bytevec_stats() noexcept;
+
 static_assert(sizeof(small_t)==sizeof(big_t));
 static_assert(sizeof(small_t)==sizeof(small_bytevec_t));
 
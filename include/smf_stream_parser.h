@@ -0,0 +1,121 @@
+#pragma once
+#include "generic_chunk_low_level.h"
+#include "mthd_t.h"
+#include "mtrk_event_t.h"
+#include "smf_t.h"
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <cstddef>  // std::size_t
+
+
+namespace jmid {
+
+//
+// smf_stream_parser_t
+//
+// Resumable, push-style smf parser for data that arrives in fragments of
+// arbitrary size (ex, from a pipe or socket).  The caller passes each 
+// fragment to feed() as it arrives, and calls finish() once the input is
+// exhausted.  As each element of the file is completed, the parser calls 
+// the corresponding callback:
+// on_mthd(mthd):  Once, after the MThd chunk has been read.  
+// on_chunk_begin(header):  After the header of each chunk following the 
+//   MThd.  
+// on_mtrk_event(ev):  For each event of an MTrk chunk, including the EOT.  
+// on_uchk_data(beg,end):  For each run of bytes from the data section of 
+//   an unknown chunk; a single uchk may be delivered in several pieces.  
+// on_chunk_end(header):  After the EOT of an MTrk or the last byte of an
+//   unknown chunk.  
+// Any callback may be empty.  The objects passed to the callbacks are only
+// valid for the duration of the call.  
+//
+// The input is interpreted exactly as by make_smf2():  MTrk events are read
+// until the EOT event (the MTrk length field is not used), and parsing 
+// stops once MThd.ntrks() MTrks have been read; any input beyond this is
+// ignored.  The error codes and counts reported by error() after finish() 
+// are those make_smf2() would report for the concatenated input.  
+//
+// State carried between calls to feed() is the running status, the 
+// number of bytes remaining in the current uchk, and a buffer holding 
+// the bytes of the element (MThd, chunk header, or MTrk event) that was 
+// split across fragments.  Only the element in progress is buffered, and
+// the bytes needed to complete it are determined from its header (ex, the
+// vlq length field of a meta event) so that a large event is not 
+// re-parsed as its bytes arrive.  Thus, apart from an MThd w/ a very 
+// large length field, memory use is bounded by the size of the largest 
+// event (make_mtrk_event3() rejects meta and sysex events w/ payloads 
+// larger than 1000000 bytes) regardless of the size of the file.  Events
+// that are not split across fragments are parsed directly from the 
+// caller's buffer.  
+//
+// bool feed(const unsigned char *p, std::size_t n);
+// Returns false if the input is invalid; in this case, error() describes 
+// the problem and subsequent calls to feed() have no effect.  Also has no
+// effect once is_done().  
+//
+// bool finish();
+// Signals the end of the input.  Returns true if a complete smf has been
+// read.  
+//
+struct smf_stream_callbacks_t {
+	std::function<void(const mthd_t&)> on_mthd;
+	std::function<void(const chunk_header_t&)> on_chunk_begin;
+	std::function<void(const mtrk_event_t&)> on_mtrk_event;
+	std::function<void(const unsigned char*, const unsigned char*)> on_uchk_data;
+	std::function<void(const chunk_header_t&)> on_chunk_end;
+};
+class smf_stream_parser_t {
+public:
+	explicit smf_stream_parser_t(smf_stream_callbacks_t);
+
+	bool feed(const unsigned char*, std::size_t);
+	bool feed(const char*, std::size_t);
+	bool finish();
+	// Restores the parser to its initial state; the callbacks are retained.  
+	void reset();
+
+	bool is_done() const;
+	bool is_error() const;
+	const smf_error_t& error() const;
+	// The number of bytes consumed from the input so far
+	std::int64_t nbytes_read() const;
+	std::int32_t nmtrks_read() const;
+	std::int32_t nuchks_read() const;
+private:
+	enum class state_t : std::uint8_t {
+		mthd,
+		chunk_header,
+		mtrk,
+		uchk,
+		done,
+		error
+	};
+	const unsigned char *feed_mthd(const unsigned char*, const unsigned char*);
+	const unsigned char *feed_chunk_header(const unsigned char*, const unsigned char*);
+	const unsigned char *feed_mtrk(const unsigned char*, const unsigned char*);
+	const unsigned char *feed_uchk(const unsigned char*, const unsigned char*);
+	// Parses the event on [beg,end) and passes it to on_mtrk_event(); 
+	// returns false on error.  
+	bool read_event(const unsigned char*, const unsigned char*);
+	// Called after a complete MTrk or uchk has been read
+	void end_chunk();
+	void set_error(smf_error_t::errc, int, int, int);
+
+	smf_stream_callbacks_t cbs_;
+	std::vector<unsigned char> buf_;
+	mthd_t mthd_;
+	mtrk_event_t ev_;
+	chunk_header_t curr_chk_header_;
+	smf_error_t err_;
+	std::int64_t nbytes_read_ {0};
+	std::uint32_t uchk_nbytes_remain_ {0};
+	std::int32_t expect_ntrks_ {0};
+	std::int32_t n_mtrks_read_ {0};
+	std::int32_t n_uchks_read_ {0};
+	unsigned char rs_ {0x00u};
+	state_t state_ {state_t::mthd};
+};
+
+}  // namespace jmid
+
@@ -7,12 +7,16 @@
 #include <cstdint>
 #include <vector>
 #include <filesystem>
+#include <type_traits>  // std::is_pointer<>
+#include <iterator>  // std::input_iterator_tag
+#include <cstddef>  // std::ptrdiff_t
 
 
 namespace jmid {
 
 struct smf_error_t;
 class smf_t;
+class frozen_smf_t;
 
 //
 // smf_t
@@ -91,12 +95,17 @@ public:
 	
 	reference push_back(const_reference);
 	reference push_back(jmid::mtrk_t&&);
+	// Appends an empty MTrk, to be filled in place; returns a ref to it.  
+	reference emplace_back();
 	iterator insert(iterator, const_reference);
 	const_iterator insert(const_iterator, const_reference);
+	// Returns an iterator to the inserted MTrk
+	iterator insert(iterator, jmid::mtrk_t&&);
 	iterator erase(iterator);
 	const_iterator erase(const_iterator);
 
 	const uchk_value_type& push_back(const uchk_value_type&);
+	const uchk_value_type& push_back(uchk_value_type&&);
 	uchk_iterator insert(uchk_iterator, const uchk_value_type&);
 	uchk_const_iterator insert(uchk_const_iterator, const uchk_value_type&);
 	uchk_iterator erase(uchk_iterator);
@@ -118,6 +127,21 @@ public:
 	void set_mthd(const jmid::maybe_mthd_t&);
 	void set_mthd(const jmid::mthd_t&);
 	void set_mthd(jmid::mthd_t&&) noexcept;
+
+	// Calls mtrk_t::set_arena_enabled() on each MTrk, and on each MTrk 
+	// subsequently read into the container by make_smf2() or 
+	// make_smf2_parallel().  Off by default.  
+	void set_arena_enabled(bool);
+	bool arena_enabled() const;
+	// If non-null, make_smf2() and make_smf2_parallel() read the MTrks of
+	// the container w/ the store in effect (on every thread that parses an
+	// MTrk), so that equal big meta and sysex events share a buffer (see 
+	// internal::intern_scope_t).  Otherwise, the store in effect on the 
+	// calling thread, if any, is used.  Several smf_t's can share a store;
+	// the store must outlive their events.  nullptr by default; copied and
+	// moved w/ the container.  
+	void set_intern_store(internal::byte_intern_t*);
+	internal::byte_intern_t *intern_store() const;
 private:
 	jmid::mthd_t mthd_;
 	std::vector<value_type> mtrks_;
@@ -127,9 +151,14 @@ private:
 	// is lost.  chunkorder_ saves the order of interspersed MTrk and 
 	// unknown chunks.  chunkorder.size()==mtrks_.size+uchks.size().  
 	std::vector<int> chunkorder_ {};  // 0=>mtrk, 1=>unknown
+	bool arena_enabled_ {false};
+	internal::byte_intern_t *intern_store_ {nullptr};
 
 	template<typename InIt>
 	friend InIt make_smf2(InIt, InIt, smf_t*, smf_error_t*);
+	friend const unsigned char *make_smf2_parallel(const unsigned char*,
+				const unsigned char*, smf_t*, smf_error_t*, int);
+	friend class frozen_smf_t;  // Reads chunkorder_
 };
 std::string print(const smf_t&);
 
@@ -173,9 +202,17 @@ struct maybe_smf_t {
 // std::vector<char>, in one shot w/a call to std::ifstream::read().  
 // Delegates to make_smf() w/ the vector iterators.
 //
+// (3)
+// maybe_smf_t read_smf_mmap(const std::filesystem::path&, smf_error_t*);
+// Maps the file read-only (read_only_mapped_file_t) and delegates to 
+// make_smf2() w/ a const unsigned char* range over the mapping.  The file
+// data is never copied into an intermediate buffer.  The mapping is
+// released before returning; the returned smf_t owns all its data.  
+//
 maybe_smf_t read_smf(const std::filesystem::path&, smf_error_t*, std::int32_t);
 maybe_smf_t read_smf_bulkfileread(const std::filesystem::path&, 
 						smf_error_t*, std::vector<char>*, std::int32_t);
+maybe_smf_t read_smf_mmap(const std::filesystem::path&, smf_error_t*);
 // std::string print(smf_error_t::errc ec);
 // if ec == smf_error_t::errc::no_error, returns an empty string
 std::string print(smf_error_t::errc);
@@ -215,6 +252,8 @@ InIt make_smf2(InIt it, InIt end, smf_t *result, smf_error_t *err) {
 	int n_mtrks_read = 0;
 	int n_uchks_read = 0;
 	result->chunkorder_.resize(0);
+	internal::intern_scope_t intern_scope(result->intern_store_ ? 
+		result->intern_store_ : internal::current_intern_store());
 	while ((it!=end) && (n_mtrks_read<expect_ntrks)) {
 		jmid::chunk_header_t curr_chk_header;
 		jmid::chunk_header_error_t curr_chk_header_err;
@@ -229,11 +268,17 @@ InIt make_smf2(InIt it, InIt end, smf_t *result, smf_error_t *err) {
 				&& jmid::has_valid_length(curr_chk_header)) {
 			if (result->mtrks_.size() == n_mtrks_read) {
 				result->mtrks_.resize(result->mtrks_.size()+1);
-				result->mtrks_.back().resize(2000);  // TODO:  Magic number 2000
 				// NB:  If not calling push_back(), the smf_t will not 
 				// correctly record the uchk-mtrk sequence order
 			}
 			auto p_curr_mtrk = result->mtrks_.data() + n_mtrks_read;
+			p_curr_mtrk->set_arena_enabled(result->arena_enabled_);
+			if constexpr (!std::is_pointer<InIt>::value) {
+				// For contiguous input make_mtrk_event_seq() counts the 
+				// events exactly; otherwise, estimate from the chunk length.
+				p_curr_mtrk->reserve(jmid::estimate_n_mtrk_events(
+					static_cast<std::int32_t>(curr_chk_header.length)));
+			}
 			jmid::mtrk_error_t curr_mtrk_error;
 			it = jmid::make_mtrk_event_seq(it,end,0x00u,p_curr_mtrk,&curr_mtrk_error);
 			if (curr_mtrk_error.code != jmid::mtrk_error_t::errc::no_error) {
@@ -250,6 +295,7 @@ InIt make_smf2(InIt it, InIt end, smf_t *result, smf_error_t *err) {
 				result->uchks_.resize(result->uchks_.size()+1);
 				result->uchks_.back().reserve(2000);  // TODO:  Magic number 2000
 			}
+			result->uchks_[n_uchks_read].clear();
 			auto bi_uchk = std::back_inserter(result->uchks_[n_uchks_read]);
 			std::uint32_t j=0;
 			for (j=0; ((it!=end) && (j<curr_chk_header.length)); ++j) {
@@ -282,6 +328,55 @@ InIt make_smf2(InIt it, InIt end, smf_t *result, smf_error_t *err) {
 };
 
 
+//
+// const unsigned char *make_smf2_parallel(const unsigned char *it, 
+//			const unsigned char *end, smf_t *result, smf_error_t *err, 
+//			int nthreads);
+//
+// Produces the same result as make_smf2(it,end,result,err), but parses 
+// the MTrk chunks concurrently on up to nthreads threads (the calling 
+// thread is one of them).  If nthreads <= 0, uses 
+// std::thread::hardware_concurrency().  
+//
+// In a first pass, only the chunk headers are read, yielding the extent
+// of each chunk.  The MTrks are then parsed independently w/ 
+// make_mtrk_event_seq() over [chunk_beg,chunk_end), and stored into 
+// result->mtrks_ in the order in which they occur in the input.  Unknown
+// chunks are copied in the first pass.  
+//
+// make_smf2() ignores the length field of an MTrk header and reads events
+// until it encounters an EOT.  Hence, if anything is amiss w/ the input 
+// (a header can not be read, an MTrk is invalid, an EOT does not fall 
+// exactly at the end of its chunk, etc), this function discards its work
+// and delegates to make_smf2() so that the errors reported, the iterator
+// returned, and the contents of *result are identical to the serial path.
+// An exception thrown on a worker thread (eg, std::bad_alloc) is rethrown
+// on the calling thread after all the workers have finished.  
+//
+const unsigned char *make_smf2_parallel(const unsigned char*, 
+				const unsigned char*, smf_t*, smf_error_t*, int=0);
+
+//
+// const unsigned char *validate_smf(const unsigned char *it, 
+//			const unsigned char *end, smf_error_t *err);
+//
+// Checks [it,end) w/o building an smf_t.  The MThd is read w/ make_mthd2()
+// and the chunk headers w/ read_chunk_header(), exactly as in make_smf2(), 
+// but the events of each MTrk are only decoded in place w/ 
+// read_mtrk_event_view() and the uchks are skipped over.  No mtrk_t, 
+// mtrk_event_t, or uchk buffer is constructed, so validating a file does
+// not allocate.  
+//
+// The error code and counts written to *err, and the returned iterator, 
+// are identical to those of make_smf2(it,end,...).  In addition, for 
+// errc::mtrk_error, err->mtrk_err_obj.code is set to invalid_event or 
+// no_eot_event, and err->mtrk_err_obj.event_error to the error of the
+// offending event, and for errc::mthd_error, err->mthd_err_obj is set.  
+//
+const unsigned char *validate_smf(const unsigned char*, 
+				const unsigned char*, smf_error_t*);
+
+
 /*
 template<typename InIt>
 InIt make_smf(InIt it, InIt end, maybe_smf_t *result, smf_error_t *err,
@@ -390,6 +485,29 @@ InIt make_smf(InIt it, InIt end, maybe_smf_t *result, smf_error_t *err,
 };*/
 
 
+//
+// OIt write_smf(const smf_t& smf, OIt it);
+// unsigned char *write_smf(const smf_t& smf, unsigned char *dest);
+// 
+// Writes the MThd and MTrk chunks of smf to it.  The overload for 
+// unsigned char* writes to a contiguous buffer w/ room for at least 
+// write_smf_nbytes(smf) bytes, copying the MThd and the storage of each
+// event w/ std::memcpy() (see write_mtrk()).  The output is identical.  
+//
+// std::int64_t write_smf_nbytes(const smf_t& smf);
+// The exact number of bytes written by write_smf().  Since the uchks are
+// not written, this differs from smf.nbytes() if smf.nuchks() > 0.  
+//
+// std::filesystem::path write_smf(const smf_t& smf, 
+//									const std::filesystem::path& fp);
+// std::filesystem::path write_smf(const smf_t& smf, 
+//				const std::filesystem::path& fp, std::vector<unsigned char>* buf);
+// Serializes smf into a buffer sized exactly w/ write_smf_nbytes(), then
+// writes the buffer to the file fp w/ a single call to 
+// std::ofstream::write().  The overload taking a buffer reuses the 
+// caller's buffer, so that writing many files does not allocate once 
+// the buffer is large enough for the largest file.  
+//
 template<typename OIt>
 OIt write_smf(const smf_t& smf, OIt it) {
 	for (const auto& e : smf.mthd()) {
@@ -401,7 +519,11 @@ OIt write_smf(const smf_t& smf, OIt it) {
 	return it;
 };
 
+unsigned char *write_smf(const smf_t&, unsigned char*);
+std::int64_t write_smf_nbytes(const smf_t&);
 std::filesystem::path write_smf(const smf_t&, const std::filesystem::path&);
+std::filesystem::path write_smf(const smf_t&, const std::filesystem::path&,
+								std::vector<unsigned char>*);
 
 // For the path fp, checks that std::filesystem::is_regular_file(fp)
 // is true, and that the extension is "mid", "MID", "midi", or 
@@ -441,23 +563,96 @@ private:
 };
 */
 
-/*class smf2_chrono_iterator {
+//
+// smf_chrono_iterator_t
+//
+// Iterates over the events of all the MTrks of an smf_t in order of 
+// onset tick, w/o copying the events:  A lazy k-way merge of the tracks,
+// each of which is already in tick order.  Events w/ the same onset tick
+// are visited in order of track index, and events of the same track in 
+// their order in the track; this is the order of get_events_dt_ordered().
+// The iterator holds a binary min-heap of one position per track that has
+// not been exhausted, so that ++ is O(log(k)) for k tracks.  
+//
+// The smf_t must not be modified while the iterator is in use.  A 
+// default-constructed iterator is the end iterator; two iterators compare
+// equal if both are at the end, or both refer to the same event.  
+//
+struct smf_chrono_event_t {
+	std::int32_t trackn;
+	std::int32_t tkonset;  // Cumulative tick at the onset of ev
+	const mtrk_event_t& ev;
+};
+class smf_chrono_iterator_t {
 public:
+	using iterator_category = std::input_iterator_tag;
+	using value_type = smf_chrono_event_t;
+	using difference_type = std::ptrdiff_t;
+	using pointer = void;
+	using reference = smf_chrono_event_t;
+
+	smf_chrono_iterator_t() noexcept = default;
+	explicit smf_chrono_iterator_t(const smf_t&);
+
+	smf_chrono_event_t operator*() const noexcept;
+	smf_chrono_iterator_t& operator++();
+	smf_chrono_iterator_t operator++(int);
+	
+	std::int32_t trackn() const noexcept;
+	std::int32_t tkonset() const noexcept;
+	const mtrk_event_t& event() const noexcept;
+
+	bool operator==(const smf_chrono_iterator_t&) const noexcept;
+	bool operator!=(const smf_chrono_iterator_t&) const noexcept;
 private:
-	struct event_range_t {
-		mtrk_iterator_t beg;
-		mtrk_iterator_t end;
+	struct pos_t {
+		mtrk_t::const_iterator it;
+		mtrk_t::const_iterator end;
+		std::int32_t tkonset;  // Of *it
+		std::int32_t trackn;
 	};
-	std::vector<event_range_t> trks_;
-};*/
+	// Min-heap by (tkonset,trackn); heap_.front() is the current event
+	std::vector<pos_t> heap_ {};
+
+	static bool gt(const pos_t&, const pos_t&) noexcept;
+};
+// Iterators to the first event in chronological order, and the end
+smf_chrono_iterator_t chrono_begin(const smf_t&);
+smf_chrono_iterator_t chrono_end(const smf_t&);
+
+//
+// mtrk_t flatten_mtrks(const smf_t& smf);
+// smf_t flatten_to_format0(const smf_t& smf);
+//
+// Merges all the MTrks of smf into a single MTrk, in the order of
+// smf_chrono_iterator_t, recomputing the delta times as the events are
+// appended.  The EOT events of the input tracks are dropped, and a single
+// EOT is appended at the onset tick of the last event of the input (the
+// max of the nticks() of the input tracks).  The output track is
+// reserved once up front and the events are copied straight into it, so
+// beyond the output, the working memory is the O(k) merge heap for k
+// tracks; no intermediate vector of all the events is built (cf.
+// get_events_dt_ordered()).
+//
+// flatten_to_format0() returns a format 0 smf_t w/ the division of smf,
+// the flattened MTrk, and the uchks of smf (following the MTrk).
+//
+mtrk_t flatten_mtrks(const smf_t&);
+smf_t flatten_to_format0(const smf_t&);
 
 
+// All the events of all the MTrks, copied into a single vector ordered 
+// as for smf_chrono_iterator_t.  To visit the events in this order w/o 
+// copying them, use smf_chrono_iterator_t.  
 struct all_smf_events_dt_ordered_t {
 	mtrk_event_t ev;
 	std::uint32_t cumtk;
 	int trackn;
 };
 std::vector<all_smf_events_dt_ordered_t> get_events_dt_ordered(const smf_t&);
+// Same as above, but the events are moved out of the smf_t (which is left
+// w/ empty events) rather than copied.  
+std::vector<all_smf_events_dt_ordered_t> get_events_dt_ordered(smf_t&&);
 std::string print(const std::vector<all_smf_events_dt_ordered_t>&);
 
 /*
@@ -0,0 +1,235 @@
+#pragma once
+#include "mthd_t.h"
+#include "mtrk_event_t.h"
+#include "smf_t.h"  // smf_error_t
+#include "aux_types.h"
+#include <cstdint>
+#include <cstddef>  // std::ptrdiff_t
+#include <iterator>  // std::forward_iterator_tag
+#include <vector>
+
+
+namespace jmid {
+
+class mtrk_event_view_t;
+class mtrk_view_t;
+class smf_view_t;
+
+//
+// Non-owning, read-only views of an smf held in a contiguous byte buffer.
+//
+// Nothing is copied out of the source buffer; the caller must keep the
+// buffer alive (and unmodified) for as long as any view (or any iterator
+// or mtrk_event_view_t obtained from a view) is in use.  The typical use
+// is a single scan over a file mapped w/ read_only_mapped_file_t (util.h)
+// or read into a std::vector<unsigned char>.
+//
+// Where make_smf2() materializes an mtrk_event_t per event, iterating over
+// an mtrk_view_t decodes each event in place and allocates nothing.
+//
+
+//
+// mtrk_event_view_t
+//
+// A view of a single MTrk event exactly as it is encoded in the source
+// buffer.  Since the event may be encoded in running status, [begin(),end())
+// is not necessarily a valid stand-alone event:  it spans the delta-time
+// and everything following it, but the status byte is absent if
+// is_in_running_status().  status_byte() always returns the status byte
+// in effect for the event.
+//
+// payload_begin() differs from mtrk_event_t::payload_begin():
+// For meta and sysex events, it is the first byte following the vlq
+// length field (as for mtrk_event_t).  For channel events, it is the first
+// data byte (p1), whether or not the event is in running status.
+// [payload_begin(),end()) is always the complete payload.
+//
+class mtrk_event_view_t {
+public:
+	using size_type = std::int32_t;
+
+	const unsigned char *begin() const noexcept;
+	const unsigned char *end() const noexcept;
+	const unsigned char *event_begin() const noexcept;  // First byte following the delta-time
+	const unsigned char *payload_begin() const noexcept;
+	size_type size() const noexcept;  // Including the delta-time
+	size_type data_size() const noexcept;  // Not including the delta-time
+
+	std::int32_t delta_time() const noexcept;
+	unsigned char status_byte() const noexcept;
+	unsigned char running_status() const noexcept;
+	bool is_in_running_status() const noexcept;
+
+	// These are only meaningful where the event is of the corresponding
+	// type; see mtrk_event_t::get_channel_event_data() etc.  For meta
+	// events, type is the meta type byte; for sysex events, type is the
+	// status byte (0xF0u or 0xF7u).
+	jmid::ch_event_data_t get_channel_event_data() const noexcept;
+	jmid::meta_header_data get_meta() const noexcept;
+	jmid::sysex_header_data get_sysex() const noexcept;
+
+	// Copies the event into a new mtrk_event_t.  If the event is in running
+	// status, the status byte is written explicitly into the result.
+	jmid::mtrk_event_t to_mtrk_event() const;
+private:
+	const unsigned char *beg_ {nullptr};
+	const unsigned char *end_ {nullptr};
+	const unsigned char *payload_ {nullptr};
+	std::int32_t dt_ {0};
+	unsigned char s_ {0x00u};
+	unsigned char type_ {0x00u};  // Meta type byte; 0x00u for non-meta events
+	bool in_rs_ {false};
+
+	friend const unsigned char *read_mtrk_event_view(const unsigned char*,
+					const unsigned char*, unsigned char, mtrk_event_view_t*,
+					mtrk_event_error_t*);
+};
+bool is_eot(const mtrk_event_view_t&) noexcept;
+
+//
+// const unsigned char *read_mtrk_event_view(const unsigned char *it,
+//				const unsigned char *end, unsigned char rs,
+//				mtrk_event_view_t *result, mtrk_event_error_t *err);
+//
+// Decodes the event at [it,end) into *result w/o copying any data.
+// Validation, the error codes written to err, and the returned iterator
+// are identical to those of make_mtrk_event3(it,end,rs,...).  On error,
+// *result is default-initialized (size()==0).
+//
+const unsigned char *read_mtrk_event_view(const unsigned char*,
+					const unsigned char*, unsigned char, mtrk_event_view_t*,
+					mtrk_event_error_t*);
+
+
+//
+// mtrk_view_t
+//
+// A view of the data section (everything following the 8-byte header) of
+// an MTrk chunk.  The forward iterator decodes events one at a time w/
+// read_mtrk_event_view(), carrying the running status from one event to
+// the next exactly as make_mtrk_event_seq() does.  Iteration ends after
+// the first EOT event, at the end of the data section, or at the first
+// invalid event.  In the latter case, the iterator compares == end() and
+// iterator::error() returns the error code for the offending event.  Hence,
+// to detect an invalid track, loop w/ an explicit iterator rather than
+// range-for:
+// auto it=trk.begin();
+// for (; it!=trk.end(); ++it) { ... }
+// if (it.error() != mtrk_event_error_t::errc::no_error) { ... }
+//
+class mtrk_view_iterator_t {
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = mtrk_event_view_t;
+	using difference_type = std::ptrdiff_t;
+	using pointer = const mtrk_event_view_t*;
+	using reference = const mtrk_event_view_t&;
+
+	mtrk_view_iterator_t() noexcept = default;
+	mtrk_view_iterator_t(const unsigned char*, const unsigned char*) noexcept;
+
+	reference operator*() const noexcept;
+	pointer operator->() const noexcept;
+	mtrk_view_iterator_t& operator++() noexcept;
+	mtrk_view_iterator_t operator++(int) noexcept;
+
+	mtrk_event_error_t::errc error() const noexcept;
+private:
+	const unsigned char *p_ {nullptr};  // First byte of the current event
+	const unsigned char *end_ {nullptr};
+	mtrk_event_view_t ev_ {};
+	mtrk_event_error_t::errc err_ {mtrk_event_error_t::errc::no_error};
+
+	void read_curr() noexcept;
+
+	friend bool operator==(const mtrk_view_iterator_t&,
+						const mtrk_view_iterator_t&) noexcept;
+	friend bool operator!=(const mtrk_view_iterator_t&,
+						const mtrk_view_iterator_t&) noexcept;
+};
+bool operator==(const mtrk_view_iterator_t&,
+				const mtrk_view_iterator_t&) noexcept;
+bool operator!=(const mtrk_view_iterator_t&,
+				const mtrk_view_iterator_t&) noexcept;
+
+class mtrk_view_t {
+public:
+	using iterator = mtrk_view_iterator_t;
+	using const_iterator = mtrk_view_iterator_t;
+
+	mtrk_view_t() noexcept = default;
+	// [beg,end) is the data section of the chunk (the header is excluded)
+	mtrk_view_t(const unsigned char*, const unsigned char*) noexcept;
+
+	const_iterator begin() const noexcept;
+	const_iterator end() const noexcept;
+
+	const unsigned char *data_begin() const noexcept;
+	const unsigned char *data_end() const noexcept;
+	std::int32_t data_nbytes() const noexcept;  // Not including the header
+private:
+	const unsigned char *beg_ {nullptr};
+	const unsigned char *end_ {nullptr};
+};
+
+
+//
+// smf_view_t
+//
+// Holds the MThd and views of the MTrk and unknown chunks of an smf in a
+// contiguous byte buffer.  Constructed by make_smf_view(), which walks the
+// chunk headers w/ read_chunk_header(), but does not look inside the MTrk
+// chunks; events are decoded, and thus validated, only as they are
+// iterated over.  In contrast to make_smf2(), which reads MTrk events
+// until it encounters an EOT event, the extent of each chunk is taken from
+// the length field of its header.
+//
+// As for smf_t, size(), operator[], begin(), end() report on the MTrk
+// chunks only.
+//
+class smf_view_t {
+public:
+	using size_type = std::int64_t;
+	using const_iterator = std::vector<mtrk_view_t>::const_iterator;
+	struct uchk_view_t {
+		const unsigned char *beg {nullptr};  // Data section; header excluded
+		const unsigned char *end {nullptr};
+	};
+
+	size_type size() const noexcept;  // Number of mtrk chunks
+	size_type nchunks() const noexcept;  // Number of MTrk + Unkn chunks
+	size_type ntrks() const noexcept;  // Number of MTrk chunks
+	size_type nuchks() const noexcept;  // Number of Unkn chunks
+
+	const_iterator begin() const noexcept;
+	const_iterator end() const noexcept;
+	const mtrk_view_t& operator[](size_type) const noexcept;
+	uchk_view_t get_uchk(size_type) const noexcept;
+
+	const jmid::mthd_t& mthd() const noexcept;
+	std::int32_t format() const noexcept;  // mthd alias
+	jmid::time_division_t division() const noexcept;  // mthd alias
+private:
+	jmid::mthd_t mthd_;
+	std::vector<mtrk_view_t> mtrks_ {};
+	std::vector<uchk_view_t> uchks_ {};
+
+	friend const unsigned char *make_smf_view(const unsigned char*,
+				const unsigned char*, smf_view_t*, smf_error_t*);
+};
+
+//
+// const unsigned char *make_smf_view(const unsigned char *it,
+//				const unsigned char *end, smf_view_t *result, smf_error_t *err);
+//
+// Overwrites the smf_view_t at result w/ views of the chunks in [it,end).
+// The error codes are those of make_smf2(), except that an MTrk chunk
+// whose length field runs past end is reported as smf_error_t::mtrk_error
+// w/ err->mtrk_err_obj.code == mtrk_error_t::errc::other; MTrk events are
+// not examined.
+//
+const unsigned char *make_smf_view(const unsigned char*,
+				const unsigned char*, smf_view_t*, smf_error_t*);
+
+}  // namespace jmid
+
@@ -6,6 +6,41 @@
 
 namespace jmid {
 
+//
+// class read_only_mapped_file_t
+//
+// RAII wrapper around a read-only memory mapping of an entire file.  On 
+// Windows uses CreateFileMapping()/MapViewOfFile(); elsewhere uses POSIX
+// mmap().  If the file can not be opened or mapped, is_open() returns
+// false and begin()==end()==nullptr.  A zero-length file is "open" w/ an
+// empty range.  The mapping is released on destruction; pointers 
+// obtained from begin(), end() are invalidated at that time.  
+//
+// Movable but not copyable.  
+//
+class read_only_mapped_file_t {
+public:
+	read_only_mapped_file_t() noexcept = default;
+	explicit read_only_mapped_file_t(const std::filesystem::path&);
+	read_only_mapped_file_t(const read_only_mapped_file_t&) = delete;
+	read_only_mapped_file_t& operator=(const read_only_mapped_file_t&) = delete;
+	read_only_mapped_file_t(read_only_mapped_file_t&&) noexcept;
+	read_only_mapped_file_t& operator=(read_only_mapped_file_t&&) noexcept;
+	~read_only_mapped_file_t() noexcept;
+
+	bool open(const std::filesystem::path&);
+	void close() noexcept;
+	bool is_open() const noexcept;
+
+	std::size_t size() const noexcept;
+	const unsigned char *begin() const noexcept;
+	const unsigned char *end() const noexcept;
+private:
+	const unsigned char *p_ {nullptr};
+	std::size_t sz_ {0};
+	bool is_open_ {false};
+};
+
 // bool read_binary_csio(std::filesystem::path pth, 
 //							std::vector<char>& dest)
 // Uses C-style I/O (std::fopen, std::fread()) to read a file into dest.  
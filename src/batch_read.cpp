@@ -0,0 +1,218 @@
+#include "batch_read.h"
+#include "smf_t.h"
+#include "util.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <numeric>  // std::iota()
+#include <cstdint>
+#include <cstddef>  // std::size_t
+#include <system_error>
+
+
+namespace {
+
+// A queue of indices into the input vector of paths.  The owning worker
+// pops from the front; other workers steal from the back.
+struct work_queue_t {
+	std::mutex m;
+	std::deque<std::size_t> q;
+};
+
+bool pop_front(work_queue_t& wq, std::size_t& idx) {
+	std::lock_guard<std::mutex> lock(wq.m);
+	if (wq.q.empty()) {
+		return false;
+	}
+	idx = wq.q.front();
+	wq.q.pop_front();
+	return true;
+}
+
+bool steal_back(work_queue_t& wq, std::size_t& idx) {
+	std::lock_guard<std::mutex> lock(wq.m);
+	if (wq.q.empty()) {
+		return false;
+	}
+	idx = wq.q.back();
+	wq.q.pop_back();
+	return true;
+}
+
+// Per-worker state reused from one file to the next
+struct worker_state_t {
+	std::vector<char> fdata;
+	jmid::read_only_mapped_file_t fmap;
+	jmid::smf_t smf;
+};
+
+void read_one(const std::filesystem::path& fp, std::size_t idx, int worker,
+				const jmid::batch_read_opts_t& opts, worker_state_t& ws,
+				jmid::smf_error_t& err, const jmid::batch_read_callback_t& cb) {
+	err.code = jmid::smf_error_t::errc::no_error;
+	err.expect_num_mtrks = 0;
+	err.num_mtrks_read = 0;
+	err.num_uchks_read = 0;
+	const unsigned char *beg = nullptr;
+	const unsigned char *end = nullptr;
+	bool is_read = false;
+
+	if (opts.method == jmid::batch_read_method::bulk_ifstream) {
+		std::basic_ifstream<char> f(fp,std::ios_base::in|std::ios_base::binary);
+		if (f.is_open() && f.good()) {
+			f.seekg(0,std::ios::end);
+			auto fsize = f.tellg();
+			f.seekg(0,std::ios::beg);
+			if (fsize >= 0) {
+				ws.fdata.resize(static_cast<std::size_t>(fsize));
+				f.read(ws.fdata.data(),fsize);
+				is_read = (f.gcount() == fsize);
+			}
+		}
+	} else if (opts.method == jmid::batch_read_method::csio) {
+		std::error_code ec;
+		auto fsize = std::filesystem::file_size(fp,ec);
+		if (!ec) {
+			ws.fdata.resize(fsize);
+			// read_binary_csio() returns 0 if the file can not be opened
+			auto nread = jmid::read_binary_csio(fp,ws.fdata);
+			ws.fdata.resize(nread);
+			is_read = (nread == fsize);
+		}
+	} else if (opts.method == jmid::batch_read_method::mmap) {
+		is_read = ws.fmap.open(fp);
+		beg = ws.fmap.begin();
+		end = ws.fmap.end();
+	} else if (opts.method == jmid::batch_read_method::istreambuf_iterator) {
+		std::basic_ifstream<char> f(fp,std::ios_base::in|std::ios_base::binary);
+		if (f.is_open() && f.good()) {
+			is_read = true;
+			if (opts.make_smf) {
+				std::istreambuf_iterator<char> it(f);
+				auto it_end = std::istreambuf_iterator<char>();
+				jmid::make_smf2(it,it_end,&(ws.smf),&err);
+			}
+		}
+	}
+	if ((opts.method == jmid::batch_read_method::bulk_ifstream)
+			|| (opts.method == jmid::batch_read_method::csio)) {
+		beg = reinterpret_cast<const unsigned char*>(ws.fdata.data());
+		end = beg + ws.fdata.size();
+	}
+
+	if (!is_read) {
+		err.code = jmid::smf_error_t::errc::file_read_error;
+		beg = nullptr;
+		end = nullptr;
+	} else if (opts.make_smf
+			&& (opts.method != jmid::batch_read_method::istreambuf_iterator)) {
+		jmid::make_smf2(beg,end,&(ws.smf),&err);
+	}
+
+	const jmid::smf_t *psmf = nullptr;
+	if (opts.make_smf && is_read) {
+		psmf = &(ws.smf);
+	}
+	if (cb) {
+		cb({idx,fp,psmf,err,beg,end,worker});
+	}
+	ws.fmap.close();
+}
+
+}  // namespace
+
+
+int jmid::batch_read_nthreads(const jmid::batch_read_opts_t& opts) {
+	int nthreads = opts.nthreads;
+	if (nthreads <= 0) {
+		nthreads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	return std::max(1,nthreads);
+}
+
+std::vector<jmid::smf_error_t> jmid::batch_read(
+				const std::vector<std::filesystem::path>& paths,
+				const jmid::batch_read_callback_t& cb,
+				jmid::batch_read_opts_t opts) {
+	std::vector<jmid::smf_error_t> result(paths.size());
+	if (paths.empty()) {
+		return result;
+	}
+	int nthreads = jmid::batch_read_nthreads(opts);
+
+	// Largest files first
+	std::vector<std::uintmax_t> fsizes(paths.size(),0);
+	for (std::size_t i=0; i<paths.size(); ++i) {
+		std::error_code ec;
+		auto sz = std::filesystem::file_size(paths[i],ec);
+		fsizes[i] = ec ? 0 : sz;
+	}
+	std::vector<std::size_t> order(paths.size());
+	std::iota(order.begin(),order.end(),std::size_t{0});
+	std::stable_sort(order.begin(),order.end(),
+		[&fsizes](std::size_t lhs, std::size_t rhs)->bool {
+			return fsizes[lhs] > fsizes[rhs];
+		});
+
+	// Dealt out round-robin, so each queue is itself sorted largest-first
+	std::vector<work_queue_t> queues(nthreads);
+	for (std::size_t i=0; i<order.size(); ++i) {
+		queues[i%nthreads].q.push_back(order[i]);
+	}
+
+	// The intern store is thread-local (see intern_scope_t)
+	auto store = opts.intern_store ? opts.intern_store 
+		: jmid::internal::current_intern_store();
+	auto worker = [&](int w)->void {
+		jmid::internal::intern_scope_t intern_scope(store);
+		worker_state_t ws;
+		std::size_t idx = 0;
+		while (true) {
+			bool have_work = pop_front(queues[w],idx);
+			for (int i=1; (!have_work && i<nthreads); ++i) {
+				have_work = steal_back(queues[(w+i)%nthreads],idx);
+			}
+			if (!have_work) {
+				// Nothing is ever added to a queue after the workers start,
+				// so if every queue is empty, all the work has been claimed.
+				return;
+			}
+			// An exception escaping a std::thread would call 
+			// std::terminate(); it is reported as an error for the file
+			// being processed, and the worker moves on.  
+			try {
+				read_one(paths[idx],idx,w,opts,ws,result[idx],cb);
+			} catch (...) {
+				result[idx].code = jmid::smf_error_t::errc::other;
+				ws.fmap.close();
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(nthreads);
+	try {
+		for (int w=0; w<nthreads; ++w) {
+			threads.emplace_back(worker,w);
+		}
+	} catch (...) {
+		// A std::thread destroyed while joinable calls std::terminate(), so
+		// the workers already started are joined before rethrowing.  They
+		// steal from every queue, so they drain the queues of the workers
+		// that were never started.  
+		for (auto& t : threads) {
+			t.join();
+		}
+		throw;
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	return result;
+}
+
@@ -0,0 +1,128 @@
+#include "byte_arena_t.h"
+#include <cstdint>
+#include <vector>
+#include <memory>  // std::unique_ptr
+#include <algorithm>  // std::max(), std::copy()
+#include <string_view>
+#include <mutex>
+
+
+namespace {
+thread_local jmid::internal::byte_arena_t *curr_thread_arena = nullptr;
+thread_local jmid::internal::byte_intern_t *curr_thread_intern = nullptr;
+}  // namespace
+
+
+jmid::internal::byte_arena_t::byte_arena_t() noexcept {
+	//...
+}
+jmid::internal::byte_arena_t::byte_arena_t(std::int32_t block_size) noexcept {
+	this->block_size_ = std::max(block_size,std::int32_t(64));
+}
+unsigned char *jmid::internal::byte_arena_t::allocate(std::int32_t n) {
+	n = std::max(n,std::int32_t(1));
+	if (n > (this->block_size_/4)) {
+		// Gets a block of its own; the current block remains current
+		this->blocks_.push_back({std::make_unique<unsigned char[]>(n),n});
+		this->nbytes_allocated_ += n;
+		return this->blocks_.back().p.get();
+	}
+	if (n > this->n_avail_) {
+		this->blocks_.push_back({std::make_unique<unsigned char[]>(
+			this->block_size_),this->block_size_});
+		this->curr_ = this->blocks_.back().p.get();
+		this->n_avail_ = this->block_size_;
+	}
+	auto result = this->curr_;
+	this->curr_ += n;
+	this->n_avail_ -= n;
+	this->nbytes_allocated_ += n;
+	return result;
+}
+void jmid::internal::byte_arena_t::release() noexcept {
+	if (!this->blocks_.empty() && (this->blocks_[0].sz==this->block_size_)) {
+		this->blocks_.resize(1);
+		this->curr_ = this->blocks_[0].p.get();
+		this->n_avail_ = this->block_size_;
+	} else {
+		this->blocks_.clear();
+		this->curr_ = nullptr;
+		this->n_avail_ = 0;
+	}
+	this->nbytes_allocated_ = 0;
+}
+std::int64_t jmid::internal::byte_arena_t::nbytes_allocated() const noexcept {
+	return this->nbytes_allocated_;
+}
+std::int64_t jmid::internal::byte_arena_t::nbytes_reserved() const noexcept {
+	std::int64_t result = 0;
+	for (const auto& b : this->blocks_) {
+		result += b.sz;
+	}
+	return result;
+}
+std::int32_t jmid::internal::byte_arena_t::nblocks() const noexcept {
+	return static_cast<std::int32_t>(this->blocks_.size());
+}
+
+
+jmid::internal::arena_scope_t::arena_scope_t(jmid::internal::byte_arena_t *arena) noexcept {
+	this->prev_ = curr_thread_arena;
+	curr_thread_arena = arena;
+}
+jmid::internal::arena_scope_t::~arena_scope_t() noexcept {
+	curr_thread_arena = this->prev_;
+}
+jmid::internal::byte_arena_t *jmid::internal::current_arena() noexcept {
+	return curr_thread_arena;
+}
+
+
+jmid::internal::byte_intern_t::byte_intern_t() {
+	//...
+}
+const unsigned char *jmid::internal::byte_intern_t::intern(
+					const unsigned char *beg, const unsigned char *end) {
+	auto n = static_cast<std::int32_t>(end-beg);
+	std::string_view key(reinterpret_cast<const char*>(beg),n);
+	std::lock_guard<std::mutex> lock(this->mtx_);
+	auto it = this->seqs_.find(key);
+	if (it != this->seqs_.end()) {
+		++(this->nhits_);
+		this->nbytes_saved_ += n;
+		return reinterpret_cast<const unsigned char*>(it->data());
+	}
+	auto p = this->arena_.allocate(n);
+	std::copy(beg,end,p);
+	this->seqs_.insert(std::string_view(reinterpret_cast<const char*>(p),n));
+	this->nbytes_ += n;
+	return p;
+}
+std::int64_t jmid::internal::byte_intern_t::size() const {
+	std::lock_guard<std::mutex> lock(this->mtx_);
+	return static_cast<std::int64_t>(this->seqs_.size());
+}
+std::int64_t jmid::internal::byte_intern_t::nbytes() const {
+	std::lock_guard<std::mutex> lock(this->mtx_);
+	return this->nbytes_;
+}
+std::int64_t jmid::internal::byte_intern_t::nhits() const {
+	std::lock_guard<std::mutex> lock(this->mtx_);
+	return this->nhits_;
+}
+std::int64_t jmid::internal::byte_intern_t::nbytes_saved() const {
+	std::lock_guard<std::mutex> lock(this->mtx_);
+	return this->nbytes_saved_;
+}
+
+
+jmid::internal::intern_scope_t::intern_scope_t(jmid::internal::byte_intern_t *store) noexcept {
+	this->prev_ = curr_thread_intern;
+	curr_thread_intern = store;
+}
+jmid::internal::intern_scope_t::~intern_scope_t() noexcept {
+	curr_thread_intern = this->prev_;
+}
+jmid::internal::byte_intern_t *jmid::internal::current_intern_store() noexcept {
+	return curr_thread_intern;
+}
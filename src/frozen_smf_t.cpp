@@ -0,0 +1,385 @@
+#include "frozen_smf_t.h"
+#include "smf_t.h"
+#include "smf_view_t.h"
+#include "mthd_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "midi_status_byte.h"
+#include "midi_time.h"
+#include <cstdint>
+#include <cstdlib>  // std::abort()
+#include <cstring>  // std::memcpy()
+#include <limits>
+#include <new>  // placement new
+#include <utility>  // std::move()
+
+
+jmid::frozen_smf_t::frozen_smf_t() noexcept {
+	//...
+}
+jmid::frozen_smf_t::frozen_smf_t(const jmid::smf_t& smf) {
+	header_t h {};
+	h.magic = frozen_smf_t::magic;
+	h.version = frozen_smf_t::version;
+	h.ntrks = static_cast<std::int32_t>(smf.ntrks());
+	h.nuchks = static_cast<std::int32_t>(smf.nuchks());
+	std::int64_t nevents = 0;
+	for (const auto& trk : smf) {
+		nevents += trk.size();
+	}
+	std::int64_t uchk_nbytes = 0;
+	for (size_type i=0; i<smf.nuchks(); ++i) {
+		uchk_nbytes += smf.get_uchk(i).size();
+	}
+	auto smf_nbytes = jmid::write_smf_nbytes(smf);
+
+	std::int64_t off = sizeof(header_t);
+	h.trks_offset = static_cast<std::int32_t>(off);
+	off += h.ntrks*sizeof(trk_t);
+	h.uchks_offset = static_cast<std::int32_t>(off);
+	off += h.nuchks*sizeof(uchk_t);
+	h.events_offset = static_cast<std::int32_t>(off);
+	off += nevents*sizeof(event_t);
+	h.chunkorder_offset = static_cast<std::int32_t>(off);
+	off += h.ntrks + h.nuchks;
+	h.smf_offset = static_cast<std::int32_t>(off);
+	off += smf_nbytes;
+	h.uchk_data_offset = static_cast<std::int32_t>(off);
+	off += uchk_nbytes;
+	if (off > std::numeric_limits<std::int32_t>::max()) {
+		// All the offsets in the blob are int32_t
+		std::abort();
+	}
+	h.nevents = static_cast<std::int32_t>(nevents);
+	h.smf_nbytes = static_cast<std::int32_t>(smf_nbytes);
+	h.uchk_data_nbytes = static_cast<std::int32_t>(uchk_nbytes);
+	h.nbytes = off;
+
+	// The storage returned by new unsigned char[] is suitably aligned for
+	// any object that fits in it; each section begins at an offset that is
+	// a multiple of the alignment of its records.
+	this->blob_.reset(new unsigned char[static_cast<std::size_t>(off)]);
+	auto blob = this->blob_.get();
+	new (blob) header_t(h);
+
+	auto p_smf = blob + h.smf_offset;
+	auto dest = p_smf;
+	for (const auto& b : smf.mthd()) {
+		*dest++ = b;
+	}
+	auto p_trks = blob + h.trks_offset;
+	auto p_evs = blob + h.events_offset;
+	std::int32_t ev_idx = 0;
+	for (const auto& trk : smf) {
+		trk_t t;
+		t.offset = static_cast<std::int32_t>(dest-p_smf);
+		t.ev_beg = ev_idx;
+		t.nevents = static_cast<std::int32_t>(trk.size());
+		// write_mtrk() copies the storage of each event, delta time
+		// included, in order following the 8-byte chunk header.
+		std::int32_t ev_offset = t.offset + 8;
+		std::int32_t tk = 0;
+		for (const auto& ev : trk) {
+			event_t e;
+			tk += ev.delta_time();
+			e.tkonset = tk;
+			e.offset = ev_offset;
+			e.nbytes = ev.size();
+			e.status = ev.status_byte();
+			e.dt_nbytes = static_cast<unsigned char>(ev.event_begin()-ev.data());
+			e.p1 = 0x00u;
+			e.p2 = 0x00u;
+			auto p = ev.event_begin();  // The status byte
+			if (jmid::is_channel_status_byte(e.status)) {
+				e.p1 = *(p+1);
+				if (jmid::channel_status_byte_n_data_bytes(e.status)==2) {
+					e.p2 = *(p+2);
+				}
+			} else if (jmid::is_meta_status_byte(e.status)) {
+				e.p1 = *(p+1);
+			}
+			new (p_evs) event_t(e);
+			p_evs += sizeof(event_t);
+			ev_offset += e.nbytes;
+			++ev_idx;
+		}
+		dest = jmid::write_mtrk(trk,dest);
+		t.nbytes = static_cast<std::int32_t>((dest-p_smf)-t.offset);
+		new (p_trks) trk_t(t);
+		p_trks += sizeof(trk_t);
+	}
+
+	auto p_uchks = blob + h.uchks_offset;
+	auto p_uchk_data = blob + h.uchk_data_offset;
+	std::int32_t uchk_offset = 0;
+	for (size_type i=0; i<smf.nuchks(); ++i) {
+		const auto& uchk = smf.get_uchk(i);
+		uchk_t u;
+		u.offset = uchk_offset;
+		u.nbytes = static_cast<std::int32_t>(uchk.size());
+		if (u.nbytes > 0) {
+			std::memcpy(p_uchk_data+u.offset,uchk.data(),uchk.size());
+		}
+		new (p_uchks) uchk_t(u);
+		p_uchks += sizeof(uchk_t);
+		uchk_offset += u.nbytes;
+	}
+
+	auto p_order = blob + h.chunkorder_offset;
+	for (const auto& e : smf.chunkorder_) {
+		*p_order++ = static_cast<unsigned char>(e);
+	}
+}
+jmid::frozen_smf_t::frozen_smf_t(const jmid::frozen_smf_t& rhs) {
+	auto n = rhs.blob_nbytes();
+	if (n > 0) {
+		this->blob_.reset(new unsigned char[static_cast<std::size_t>(n)]);
+		std::memcpy(this->blob_.get(),rhs.blob_.get(),static_cast<std::size_t>(n));
+	}
+}
+jmid::frozen_smf_t::frozen_smf_t(jmid::frozen_smf_t&& rhs) noexcept {
+	this->blob_ = std::move(rhs.blob_);
+}
+jmid::frozen_smf_t& jmid::frozen_smf_t::operator=(const jmid::frozen_smf_t& rhs) {
+	if (this != &rhs) {
+		auto cpy = rhs;
+		this->blob_ = std::move(cpy.blob_);
+	}
+	return *this;
+}
+jmid::frozen_smf_t& jmid::frozen_smf_t::operator=(jmid::frozen_smf_t&& rhs) noexcept {
+	this->blob_ = std::move(rhs.blob_);
+	return *this;
+}
+jmid::frozen_smf_t::~frozen_smf_t() noexcept {
+	//...
+}
+
+jmid::frozen_smf_t::size_type jmid::frozen_smf_t::size() const noexcept {
+	return this->ntrks();
+}
+jmid::frozen_smf_t::size_type jmid::frozen_smf_t::nchunks() const noexcept {
+	if (!this->blob_) {
+		return 0;
+	}
+	return this->ntrks() + this->nuchks() + 1;  // + 1 for the MThd
+}
+jmid::frozen_smf_t::size_type jmid::frozen_smf_t::ntrks() const noexcept {
+	return this->header()->ntrks;
+}
+jmid::frozen_smf_t::size_type jmid::frozen_smf_t::nuchks() const noexcept {
+	return this->header()->nuchks;
+}
+jmid::frozen_smf_t::size_type jmid::frozen_smf_t::nevents() const noexcept {
+	return this->header()->nevents;
+}
+jmid::mthd_t jmid::frozen_smf_t::mthd() const {
+	jmid::mthd_t result;
+	if (this->blob_) {
+		jmid::mthd_error_t err;
+		jmid::make_mthd2(this->smf_begin(),this->smf_end(),&result,&err);
+	}
+	return result;
+}
+std::int32_t jmid::frozen_smf_t::format() const {
+	return this->mthd().format();
+}
+jmid::time_division_t jmid::frozen_smf_t::division() const {
+	return this->mthd().division();
+}
+const jmid::frozen_smf_t::event_t *jmid::frozen_smf_t::event_begin(
+				jmid::frozen_smf_t::size_type i) const noexcept {
+	return this->events() + this->trks()[i].ev_beg;
+}
+const jmid::frozen_smf_t::event_t *jmid::frozen_smf_t::event_end(
+				jmid::frozen_smf_t::size_type i) const noexcept {
+	const auto& t = this->trks()[i];
+	return this->events() + t.ev_beg + t.nevents;
+}
+const unsigned char *jmid::frozen_smf_t::event_data(
+				const jmid::frozen_smf_t::event_t& e) const noexcept {
+	return this->smf_begin() + e.offset;
+}
+jmid::mtrk_event_view_t jmid::frozen_smf_t::event_view(
+				const jmid::frozen_smf_t::event_t& e) const noexcept {
+	jmid::mtrk_event_view_t result;
+	auto p = this->event_data(e);
+	// The events are never written in running status
+	jmid::read_mtrk_event_view(p,p+e.nbytes,0x00u,&result,nullptr);
+	return result;
+}
+jmid::mtrk_event_t jmid::frozen_smf_t::event(
+				const jmid::frozen_smf_t::event_t& e) const {
+	return this->event_view(e).to_mtrk_event();
+}
+const unsigned char *jmid::frozen_smf_t::mtrk_begin(
+				jmid::frozen_smf_t::size_type i) const noexcept {
+	return this->smf_begin() + this->trks()[i].offset;
+}
+const unsigned char *jmid::frozen_smf_t::mtrk_end(
+				jmid::frozen_smf_t::size_type i) const noexcept {
+	const auto& t = this->trks()[i];
+	return this->smf_begin() + t.offset + t.nbytes;
+}
+jmid::mtrk_view_t jmid::frozen_smf_t::mtrk_view(
+				jmid::frozen_smf_t::size_type i) const noexcept {
+	return jmid::mtrk_view_t(this->mtrk_begin(i)+8,this->mtrk_end(i));
+}
+const unsigned char *jmid::frozen_smf_t::uchk_begin(
+				jmid::frozen_smf_t::size_type i) const noexcept {
+	return this->blob_.get() + this->header()->uchk_data_offset
+		+ this->uchks()[i].offset;
+}
+const unsigned char *jmid::frozen_smf_t::uchk_end(
+				jmid::frozen_smf_t::size_type i) const noexcept {
+	return this->uchk_begin(i) + this->uchks()[i].nbytes;
+}
+const unsigned char *jmid::frozen_smf_t::smf_begin() const noexcept {
+	return this->blob_.get() + this->header()->smf_offset;
+}
+const unsigned char *jmid::frozen_smf_t::smf_end() const noexcept {
+	return this->smf_begin() + this->header()->smf_nbytes;
+}
+jmid::frozen_smf_t::size_type jmid::frozen_smf_t::smf_nbytes() const noexcept {
+	return this->header()->smf_nbytes;
+}
+const unsigned char *jmid::frozen_smf_t::blob_begin() const noexcept {
+	return this->blob_.get();
+}
+const unsigned char *jmid::frozen_smf_t::blob_end() const noexcept {
+	return this->blob_.get() + this->header()->nbytes;
+}
+jmid::frozen_smf_t::size_type jmid::frozen_smf_t::blob_nbytes() const noexcept {
+	return this->header()->nbytes;
+}
+jmid::smf_t jmid::frozen_smf_t::to_smf() const {
+	jmid::smf_t result;
+	result.set_mthd(this->mthd());
+	auto order = this->chunkorder();
+	std::int32_t i_trk = 0;
+	std::int32_t i_uchk = 0;
+	for (size_type i=0; i<(this->ntrks()+this->nuchks()); ++i) {
+		if (order[i] == 0) {
+			auto& trk = result.emplace_back();
+			trk.reserve(this->trks()[i_trk].nevents);
+			jmid::mtrk_error_t err;
+			jmid::make_mtrk_event_seq(this->mtrk_begin(i_trk)+8,
+				this->mtrk_end(i_trk),0x00u,&trk,&err);
+			++i_trk;
+		} else {
+			result.push_back(jmid::smf_t::uchk_value_type(
+				this->uchk_begin(i_uchk),this->uchk_end(i_uchk)));
+			++i_uchk;
+		}
+	}
+	return result;
+}
+
+const jmid::frozen_smf_t::header_t *jmid::frozen_smf_t::header() const noexcept {
+	// For a default-constructed object, all the counts and offsets are 0
+	static const header_t empty {};
+	if (!this->blob_) {
+		return &empty;
+	}
+	return reinterpret_cast<const header_t*>(this->blob_.get());
+}
+const jmid::frozen_smf_t::trk_t *jmid::frozen_smf_t::trks() const noexcept {
+	return reinterpret_cast<const trk_t*>(this->blob_.get()
+		+ this->header()->trks_offset);
+}
+const jmid::frozen_smf_t::uchk_t *jmid::frozen_smf_t::uchks() const noexcept {
+	return reinterpret_cast<const uchk_t*>(this->blob_.get()
+		+ this->header()->uchks_offset);
+}
+const jmid::frozen_smf_t::event_t *jmid::frozen_smf_t::events() const noexcept {
+	return reinterpret_cast<const event_t*>(this->blob_.get()
+		+ this->header()->events_offset);
+}
+const unsigned char *jmid::frozen_smf_t::chunkorder() const noexcept {
+	return this->blob_.get() + this->header()->chunkorder_offset;
+}
+
+
+bool jmid::make_frozen_smf(const unsigned char *beg, const unsigned char *end,
+							jmid::frozen_smf_t *result) {
+	using header_t = jmid::frozen_smf_t::header_t;
+	using trk_t = jmid::frozen_smf_t::trk_t;
+	using uchk_t = jmid::frozen_smf_t::uchk_t;
+	using event_t = jmid::frozen_smf_t::event_t;
+	auto n = end-beg;
+	if (n < static_cast<std::ptrdiff_t>(sizeof(header_t))) {
+		return false;
+	}
+	header_t h;
+	std::memcpy(&h,beg,sizeof(header_t));
+	// Checks that each section lies at the expected position; since the
+	// sections are contiguous and the last ends at h.nbytes, every section
+	// is inside the blob.
+	std::int64_t off = sizeof(header_t);
+	auto section_ok = [&off](std::int32_t sec_offset, std::int64_t sec_nbytes)->bool {
+		bool ok = (sec_offset==off) && (sec_nbytes >= 0);
+		off += sec_nbytes;
+		return ok;
+	};
+	if ((h.magic != jmid::frozen_smf_t::magic)
+			|| (h.version != jmid::frozen_smf_t::version)
+			|| (h.nbytes != n) || (h.ntrks < 0) || (h.nuchks < 0)
+			|| (h.nevents < 0)
+			|| !section_ok(h.trks_offset,std::int64_t{h.ntrks}*sizeof(trk_t))
+			|| !section_ok(h.uchks_offset,std::int64_t{h.nuchks}*sizeof(uchk_t))
+			|| !section_ok(h.events_offset,std::int64_t{h.nevents}*sizeof(event_t))
+			|| !section_ok(h.chunkorder_offset,std::int64_t{h.ntrks}+h.nuchks)
+			|| !section_ok(h.smf_offset,h.smf_nbytes)
+			|| !section_ok(h.uchk_data_offset,h.uchk_data_nbytes)
+			|| (off != n) || (h.smf_nbytes < 14)) {
+		return false;
+	}
+
+	std::int32_t ev_idx = 0;
+	for (std::int32_t i=0; i<h.ntrks; ++i) {
+		trk_t t;
+		std::memcpy(&t,beg+h.trks_offset+i*sizeof(trk_t),sizeof(trk_t));
+		if ((t.offset < 14) || (t.nbytes < 8)
+				|| (std::int64_t{t.offset}+t.nbytes > h.smf_nbytes)
+				|| (t.ev_beg != ev_idx) || (t.nevents < 0)
+				|| (std::int64_t{t.ev_beg}+t.nevents > h.nevents)) {
+			return false;
+		}
+		for (std::int32_t j=t.ev_beg; j<(t.ev_beg+t.nevents); ++j) {
+			event_t e;
+			std::memcpy(&e,beg+h.events_offset+j*sizeof(event_t),sizeof(event_t));
+			if ((e.offset < t.offset+8) || (e.nbytes <= e.dt_nbytes)
+					|| (std::int64_t{e.offset}+e.nbytes > t.offset+t.nbytes)) {
+				return false;
+			}
+		}
+		ev_idx += t.nevents;
+	}
+	if (ev_idx != h.nevents) {
+		return false;
+	}
+	for (std::int32_t i=0; i<h.nuchks; ++i) {
+		uchk_t u;
+		std::memcpy(&u,beg+h.uchks_offset+i*sizeof(uchk_t),sizeof(uchk_t));
+		if ((u.offset < 0) || (u.nbytes < 0)
+				|| (std::int64_t{u.offset}+u.nbytes > h.uchk_data_nbytes)) {
+			return false;
+		}
+	}
+	std::int32_t n_mtrk = 0;
+	for (std::int32_t i=0; i<(h.ntrks+h.nuchks); ++i) {
+		auto o = *(beg+h.chunkorder_offset+i);
+		if (o > 1) {
+			return false;
+		}
+		n_mtrk += (o==0);
+	}
+	if (n_mtrk != h.ntrks) {
+		return false;
+	}
+
+	result->blob_.reset(new unsigned char[static_cast<std::size_t>(n)]);
+	std::memcpy(result->blob_.get(),beg,static_cast<std::size_t>(n));
+	return true;
+}
+
@@ -1,6 +1,138 @@
 #include "make_mtrk_event.h"
+#include "mtrk_event_t.h"
+#include "midi_status_byte.h"
+#include "aux_types.h"
+#include <cstdint>
+#include <cstddef>  // std::ptrdiff_t
 
 
+namespace {
 
+struct vlq4_t {
+	std::int32_t val;
+	std::int32_t N;
+	bool is_valid;
+};
+//
+// Reads a vlq field of at most 4 bytes at p w/o checking for the end of 
+// the input; the caller must ensure that p points to >= 4 readable bytes.  
+// Yields the same val, N, is_valid as read_vlq()/read_delta_time() for 
+// any input for which these do not run into the end of the range.  
+// The field length is computed from the high bits of the 4 bytes and the
+// value is assembled from all 4 bytes then shifted down, so the only 
+// branch is the caller's test of is_valid.  
+//
+inline vlq4_t read_vlq4_unchecked(const unsigned char *p) {
+	std::uint32_t b0 = p[0];
+	std::uint32_t b1 = p[1];
+	std::uint32_t b2 = p[2];
+	std::uint32_t b3 = p[3];
+	// c_i == 1 if bytes 0...i all have the high bit set
+	std::uint32_t c0 = b0>>7;
+	std::uint32_t c1 = c0&(b1>>7);
+	std::uint32_t c2 = c1&(b2>>7);
+	std::uint32_t c3 = c2&(b3>>7);
+	std::uint32_t N = 1 + c0 + c1 + c2;
+	std::uint32_t uval = ((b0&0x7Fu)<<21) | ((b1&0x7Fu)<<14) 
+		| ((b2&0x7Fu)<<7) | (b3&0x7Fu);
+	uval >>= 7*(4-N);
+	return {static_cast<std::int32_t>(uval),static_cast<std::int32_t>(N),
+		c3==0};
+}
 
+}  // namespace
+
+
+const unsigned char *jmid::make_mtrk_event3(const unsigned char *it, 
+					const unsigned char *end, unsigned char rs,
+					jmid::mtrk_event_t *result, jmid::mtrk_event_error_t *err) {
+	auto generic = [&]()->const unsigned char* {
+		return jmid::make_mtrk_event3<const unsigned char*>(it,end,rs,
+			result,err);
+	};
+	auto set_no_error = [&err,rs]()->void {
+		if (err!=nullptr) {
+			err->code = mtrk_event_error_t::errc::no_error;
+			err->s = 0;
+			err->rs = rs;
+		}
+	};
+	if ((end-it) < jmid::fast_path_min_nbytes) {
+		return generic();
+	}
+	
+	// The delta-time field
+	auto dtf = read_vlq4_unchecked(it);
+	if (!dtf.is_valid) {
+		return generic();
+	}
+	const unsigned char *p = it + dtf.N;
+
+	// The status byte
+	unsigned char last = *p++;
+	auto s = jmid::get_status_byte(last,rs);
+
+	if (jmid::is_channel_status_byte(s)) {
+		jmid::ch_event_data_t md;
+		md.status_nybble = s&0xF0u;
+		md.ch = s&0x0Fu;
+		auto n = jmid::channel_status_byte_n_data_bytes(s);
+		if (jmid::is_data_byte(last)) {  // In rs; last is data byte p1
+			md.p1 = last;
+		} else {
+			md.p1 = *p++;
+		}
+		if (n==2) {
+			md.p2 = *p++;
+		}
+		if (!jmid::is_data_byte(md.p1) || !jmid::is_data_byte(md.p2)) {
+			return generic();
+		}
+		result->replace_unsafe(dtf.val,md);
+		set_no_error();
+		return p;
+	} else if (jmid::is_sysex_or_meta_status_byte(s)) {
+		// s == 0xFF || 0xF7 || 0xF0
+		if (jmid::is_meta_status_byte(s)) {
+			jmid::meta_header_data mt;
+			mt.type = *p++;
+			if (!jmid::is_meta_type_byte(mt.type)) {
+				return generic();
+			}
+			auto lenf = read_vlq4_unchecked(p);
+			p += lenf.N;
+			if (!lenf.is_valid || (lenf.val > 1000000) 
+					|| (lenf.val > (end-p))) {
+				return generic();
+			}
+			mt.length = lenf.val;
+			p = result->replace_unsafe(dtf.val,mt,p,p+lenf.val).src_last;
+		} else {
+			jmid::sysex_header_data sx;
+			sx.type = s;
+			auto lenf = read_vlq4_unchecked(p);
+			p += lenf.N;
+			if (!lenf.is_valid || (lenf.val > 1000000) 
+					|| (lenf.val > (end-p))) {
+				return generic();
+			}
+			sx.length = lenf.val;
+			p = result->replace_unsafe(dtf.val,sx,p,p+lenf.val).src_last;
+		}
+		result->intern_if_scoped();
+		set_no_error();
+		return p;
+	}
+
+	return generic();
+}
+
+const char *jmid::make_mtrk_event3(const char *it, const char *end, 
+					unsigned char rs, jmid::mtrk_event_t *result, 
+					jmid::mtrk_event_error_t *err) {
+	auto beg = reinterpret_cast<const unsigned char*>(it);
+	auto last = jmid::make_mtrk_event3(beg,
+		reinterpret_cast<const unsigned char*>(end),rs,result,err);
+	return it + (last-beg);
+}
 
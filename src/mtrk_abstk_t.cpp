@@ -0,0 +1,122 @@
+#include "mtrk_abstk_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "midi_delta_time.h"
+#include "midi_vlq.h"  // write_32bit_be()
+#include <cstdint>
+#include <cstring>  // std::memcpy()
+#include <array>
+#include <algorithm>
+#include <utility>  // std::move()
+#include <iterator>  // std::prev()
+
+
+jmid::mtrk_abstk_t::mtrk_abstk_t() noexcept {
+	//...
+}
+jmid::mtrk_abstk_t::mtrk_abstk_t(const jmid::mtrk_t& mtrk) {
+	std::int32_t tk = 0;
+	for (const auto& ev : mtrk) {
+		tk += ev.delta_time();
+		auto cpy = ev;
+		cpy.set_delta_time(0);
+		// The events arrive in order of onset, so the hint is always exact
+		this->evnts_.emplace_hint(this->evnts_.end(),tk,std::move(cpy));
+	}
+}
+jmid::mtrk_abstk_t::size_type jmid::mtrk_abstk_t::size() const noexcept {
+	return static_cast<jmid::mtrk_abstk_t::size_type>(this->evnts_.size());
+}
+bool jmid::mtrk_abstk_t::empty() const noexcept {
+	return this->evnts_.empty();
+}
+std::int32_t jmid::mtrk_abstk_t::nticks() const noexcept {
+	if (this->evnts_.empty()) {
+		return 0;
+	}
+	return this->evnts_.rbegin()->first;
+}
+jmid::mtrk_abstk_t::size_type jmid::mtrk_abstk_t::nbytes() const {
+	return this->data_nbytes() + 8;
+}
+jmid::mtrk_abstk_t::size_type jmid::mtrk_abstk_t::data_nbytes() const {
+	std::int32_t result = 0;
+	std::int32_t tk = 0;
+	for (const auto& e : this->evnts_) {
+		// The stored delta time is 0, which occupies a single byte
+		result += jmid::delta_time_field_size(e.first-tk) + e.second.size()-1;
+		tk = e.first;
+	}
+	return result;
+}
+jmid::mtrk_abstk_t::const_iterator jmid::mtrk_abstk_t::begin() const noexcept {
+	return this->evnts_.cbegin();
+}
+jmid::mtrk_abstk_t::const_iterator jmid::mtrk_abstk_t::end() const noexcept {
+	return this->evnts_.cend();
+}
+jmid::mtrk_abstk_t::const_iterator jmid::mtrk_abstk_t::at_tkonset(std::int32_t tk) const {
+	return this->evnts_.lower_bound(tk);
+}
+jmid::mtrk_abstk_t::const_iterator jmid::mtrk_abstk_t::insert(
+						std::int32_t cumtk, jmid::mtrk_event_t ev) {
+	auto tk = std::max(cumtk + ev.delta_time(),0);
+	ev.set_delta_time(0);
+	// std::multimap::insert() places the new element at the upper bound
+	// of the range of equivalent keys
+	return this->evnts_.insert({tk,std::move(ev)});
+}
+jmid::mtrk_abstk_t::const_iterator jmid::mtrk_abstk_t::erase(
+						jmid::mtrk_abstk_t::const_iterator it) {
+	return this->evnts_.erase(it);
+}
+jmid::mtrk_abstk_t::const_iterator jmid::mtrk_abstk_t::set_tkonset(
+						jmid::mtrk_abstk_t::const_iterator it, std::int32_t tk) {
+	// Relinks the node; the event is neither copied nor reallocated
+	auto nh = this->evnts_.extract(it);
+	nh.key() = std::max(tk,0);
+	return this->evnts_.insert(std::move(nh));
+}
+jmid::mtrk_abstk_t::const_iterator jmid::mtrk_abstk_t::replace(
+			jmid::mtrk_abstk_t::const_iterator it, jmid::mtrk_event_t ev) {
+	ev.set_delta_time(0);
+	// Converts it to a non-const iterator in O(1)
+	auto mit = this->evnts_.erase(it,it);
+	mit->second = std::move(ev);
+	return mit;
+}
+void jmid::mtrk_abstk_t::clear() noexcept {
+	this->evnts_.clear();
+}
+jmid::mtrk_t jmid::mtrk_abstk_t::to_mtrk() const {
+	jmid::mtrk_t result;
+	result.reserve(this->size());
+	std::int32_t tk = 0;
+	for (const auto& e : this->evnts_) {
+		auto ev = e.second;
+		ev.set_delta_time(e.first-tk);
+		result.push_back(ev);
+		tk = e.first;
+	}
+	return result;
+}
+
+unsigned char *jmid::write_mtrk(const jmid::mtrk_abstk_t& mtrk, unsigned char *dest) {
+	std::array<unsigned char,4> h {0x4Du,0x54u,0x72u,0x6Bu};  // MTrk
+	std::memcpy(dest,h.data(),h.size());
+	auto p_len = dest + 4;
+	dest += 8;
+	auto data_beg = dest;
+	std::int32_t tk = 0;
+	for (const auto& e : mtrk) {
+		dest = jmid::write_delta_time_unsafe(e.first-tk,dest);
+		tk = e.first;
+		// Skip the (single-byte) stored delta time
+		auto n = e.second.size()-1;
+		std::memcpy(dest,e.second.data()+1,n);
+		dest += n;
+	}
+	jmid::write_32bit_be(static_cast<std::uint32_t>(dest-data_beg),p_len);
+	return dest;
+}
+
@@ -0,0 +1,170 @@
+#include "mtrk_columns_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "aux_types.h"
+#include "midi_status_byte.h"
+#include "midi_time.h"
+#include "midi_vlq.h"  // read_be()
+#include <cstdint>
+#include <vector>
+#include <algorithm>  // std::lower_bound()
+#include <iterator>  // std::back_inserter()
+
+
+jmid::mtrk_columns_t::mtrk_columns_t() noexcept {
+	//...
+}
+jmid::mtrk_columns_t::mtrk_columns_t(const jmid::mtrk_t& mtrk) {
+	std::int32_t npayload = 0;
+	for (const auto& ev : mtrk) {
+		if (!jmid::is_channel_status_byte(ev.status_byte())) {
+			auto its = ev.payload_range();
+			npayload += static_cast<std::int32_t>(its.end-its.begin);
+		}
+	}
+	this->reserve(mtrk.size(),npayload);
+	for (const auto& ev : mtrk) {
+		this->push_back(ev);
+	}
+}
+jmid::mtrk_columns_t::size_type jmid::mtrk_columns_t::size() const noexcept {
+	return static_cast<jmid::mtrk_columns_t::size_type>(this->tkonset_.size());
+}
+std::int32_t jmid::mtrk_columns_t::nticks() const noexcept {
+	if (this->tkonset_.empty()) {
+		return 0;
+	}
+	return this->tkonset_.back();
+}
+std::int32_t jmid::mtrk_columns_t::payload_nbytes() const noexcept {
+	return static_cast<std::int32_t>(this->payload_.size());
+}
+void jmid::mtrk_columns_t::push_back(const jmid::mtrk_event_t& ev) {
+	auto tk = this->nticks() + ev.delta_time();
+	auto s = ev.status_byte();
+	unsigned char p1 = 0x00u;
+	unsigned char p2 = 0x00u;
+	auto p = ev.event_begin();  // The status byte
+	if (jmid::is_channel_status_byte(s)) {
+		p1 = *(p+1);
+		if (jmid::channel_status_byte_n_data_bytes(s)==2) {
+			p2 = *(p+2);
+		}
+	} else {
+		if (jmid::is_meta_status_byte(s)) {
+			p1 = *(p+1);
+		}
+		auto its = ev.payload_range();
+		std::copy(its.begin,its.end,std::back_inserter(this->payload_));
+	}
+	this->tkonset_.push_back(tk);
+	this->status_.push_back(s);
+	this->p1_.push_back(p1);
+	this->p2_.push_back(p2);
+	this->payload_offset_.push_back(
+		static_cast<std::int32_t>(this->payload_.size()));
+}
+void jmid::mtrk_columns_t::clear() noexcept {
+	this->tkonset_.clear();
+	this->status_.clear();
+	this->p1_.clear();
+	this->p2_.clear();
+	this->payload_offset_.resize(1);
+	this->payload_.clear();
+}
+void jmid::mtrk_columns_t::reserve(jmid::mtrk_columns_t::size_type nevents,
+								std::int32_t npayload) {
+	this->tkonset_.reserve(nevents);
+	this->status_.reserve(nevents);
+	this->p1_.reserve(nevents);
+	this->p2_.reserve(nevents);
+	this->payload_offset_.reserve(nevents+1);
+	this->payload_.reserve(npayload);
+}
+const std::vector<std::int32_t>& jmid::mtrk_columns_t::tkonset() const noexcept {
+	return this->tkonset_;
+}
+const std::vector<unsigned char>& jmid::mtrk_columns_t::status() const noexcept {
+	return this->status_;
+}
+const std::vector<unsigned char>& jmid::mtrk_columns_t::p1() const noexcept {
+	return this->p1_;
+}
+const std::vector<unsigned char>& jmid::mtrk_columns_t::p2() const noexcept {
+	return this->p2_;
+}
+const std::vector<std::int32_t>& jmid::mtrk_columns_t::payload_offset() const noexcept {
+	return this->payload_offset_;
+}
+const std::vector<unsigned char>& jmid::mtrk_columns_t::payload() const noexcept {
+	return this->payload_;
+}
+std::int32_t jmid::mtrk_columns_t::delta_time(jmid::mtrk_columns_t::size_type idx) const noexcept {
+	if (idx == 0) {
+		return this->tkonset_[0];
+	}
+	return this->tkonset_[idx]-this->tkonset_[idx-1];
+}
+const unsigned char *jmid::mtrk_columns_t::payload_begin(jmid::mtrk_columns_t::size_type idx) const noexcept {
+	return this->payload_.data() + this->payload_offset_[idx];
+}
+const unsigned char *jmid::mtrk_columns_t::payload_end(jmid::mtrk_columns_t::size_type idx) const noexcept {
+	return this->payload_.data() + this->payload_offset_[idx+1];
+}
+jmid::mtrk_event_t jmid::mtrk_columns_t::event(jmid::mtrk_columns_t::size_type idx) const {
+	jmid::mtrk_event_t result;
+	auto dt = this->delta_time(idx);
+	auto s = this->status_[idx];
+	if (jmid::is_channel_status_byte(s)) {
+		jmid::ch_event_data_t md;
+		md.status_nybble = s&0xF0u;
+		md.ch = s&0x0Fu;
+		md.p1 = this->p1_[idx];
+		md.p2 = this->p2_[idx];
+		result.replace_unsafe(dt,md);
+		return result;
+	}
+	auto beg = this->payload_begin(idx);
+	auto end = this->payload_end(idx);
+	auto len = static_cast<std::int32_t>(end-beg);
+	if (jmid::is_meta_status_byte(s)) {
+		result.replace_unsafe(dt,jmid::meta_header_data {len,this->p1_[idx]},
+			beg,end);
+	} else {
+		result.replace_unsafe(dt,jmid::sysex_header_data {len,s},beg,end);
+	}
+	result.intern_if_scoped();
+	return result;
+}
+jmid::mtrk_columns_t::size_type jmid::mtrk_columns_t::at_tkonset(std::int32_t tk) const noexcept {
+	auto it = std::lower_bound(this->tkonset_.begin(),this->tkonset_.end(),tk);
+	return static_cast<jmid::mtrk_columns_t::size_type>(it-this->tkonset_.begin());
+}
+jmid::mtrk_t jmid::mtrk_columns_t::to_mtrk() const {
+	jmid::mtrk_t result;
+	result.reserve(this->size());
+	for (size_type i=0; i<this->size(); ++i) {
+		result.push_back(this->event(i));
+	}
+	return result;
+}
+
+
+double jmid::duration(const jmid::mtrk_columns_t& cols, 
+				const jmid::time_division_t& tdiv, std::int32_t tempo) {
+	const auto& tk = cols.tkonset();
+	const auto& s = cols.status();
+	const auto& p1 = cols.p1();
+	double result = 0.0;  // cumulative number of seconds
+	std::int32_t prev_tk = 0;
+	for (std::int32_t i=0; i<cols.size(); ++i) {
+		result += jmid::ticks2sec(tk[i]-prev_tk,tdiv,tempo);
+		prev_tk = tk[i];
+		if ((s[i]==0xFFu) && (p1[i]==0x51u)) {  // Tempo meta event
+			tempo = static_cast<std::int32_t>(jmid::read_be<std::uint32_t>(
+				cols.payload_begin(i),cols.payload_end(i)));
+		}
+	}
+	return result;
+}
+
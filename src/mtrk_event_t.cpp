@@ -1,14 +1,18 @@
 #include "mtrk_event_t.h"
 #include "small_bytevec_t.h"
+#include "byte_arena_t.h"  // current_intern_store()
 #include "midi_status_byte.h"
 #include "midi_vlq.h"
 #include "midi_delta_time.h"
 #include "aux_types.h"
 #include "print_hexascii.h"
 #include <cstdint>
+#include <cstddef>  // std::ptrdiff_t
+#include <cstring>  // std::memcpy()
 #include <algorithm>
 #include <string>
-#include <utility>  // std::move()
+#include <utility>  // std::move(), std::as_const()
+#include <type_traits>  // std::is_standard_layout
 
 
 jmid::mtrk_event_t::mtrk_event_t(jmid::delta_time dt, 
@@ -22,12 +26,14 @@ jmid::mtrk_event_t::mtrk_event_t(jmid::delta_time dt,
 		*dest++ = md.p2();
 	}
 	this->d_.resize(dest-dest_beg);
+	this->update_cache();
 }
 jmid::mtrk_event_t::mtrk_event_t(jmid::delta_time dt, 
 					jmid::meta_header mt, const unsigned char *beg, 
 					const unsigned char *end) {
 	if ((end-beg) != mt.length()) {
 		this->d_.resize(0);
+		this->update_cache();
 		return;
 	}
 	// 4 + 1 + 1 + 4 == 10; dt + 0xFF + mt-type + vlq-len
@@ -39,6 +45,8 @@ jmid::mtrk_event_t::mtrk_event_t(jmid::delta_time dt,
 	dest_end = this->d_.resize((dest_end-dest_beg)+mt.length()) 
 		+ (dest_end-dest_beg);
 	dest_end = std::copy(beg,end,dest_end);
+	this->update_cache();
+	this->intern_if_scoped();
 	// An alternative strategy is to resize to 10+mt.length(), write
 	// everything, then resize to dest_end-dest_beg at the end.  This is 
 	// suboptimal because the initial oversized resize may cause an 
@@ -49,6 +57,7 @@ jmid::mtrk_event_t::mtrk_event_t(jmid::delta_time dt,
 					const unsigned char *end) {
 	if ((end-beg) != sx.length()) {
 		this->d_.resize(0);
+		this->update_cache();
 		return;
 	}
 	// 4 + 1 + 4 == 9; dt + 0xF0/F7 + vlq-len
@@ -59,12 +68,16 @@ jmid::mtrk_event_t::mtrk_event_t(jmid::delta_time dt,
 	dest_end = this->d_.resize((dest_end-dest_beg)+sx.length()) 
 		+ (dest_end-dest_beg);
 	dest_end = std::copy(beg,end,dest_end);
+	this->update_cache();
+	this->intern_if_scoped();
 }
 jmid::mtrk_event_t::mtrk_event_t(const jmid::mtrk_event_t& rhs) {
 	this->d_=rhs.d_;
+	this->update_cache();
 }
 jmid::mtrk_event_t& jmid::mtrk_event_t::operator=(const jmid::mtrk_event_t& rhs) {
 	this->d_ = rhs.d_;
+	this->update_cache();
 	return *this;
 }
 jmid::mtrk_event_t::mtrk_event_t(jmid::mtrk_event_t&& rhs) noexcept {
@@ -79,6 +92,44 @@ jmid::mtrk_event_t::~mtrk_event_t() noexcept {  // dtor
 }
 void jmid::mtrk_event_t::clear() noexcept {
 	this->d_.resize_nocopy(0);
+	this->update_cache();
+}
+jmid::mtrk_event_t::replace_unsafe_result<const unsigned char*> 
+			jmid::mtrk_event_t::replace_unsafe(std::int32_t dt, 
+			jmid::meta_header_data mt, const unsigned char *beg, 
+			const unsigned char *end) {
+	auto dest_beg = this->d_.resize_nocopy(10);  // Probably oversized
+	auto dest = jmid::write_delta_time_unsafe(dt,dest_beg);
+	*dest++ = 0xFFu;
+	*dest++ = mt.type;
+	dest = jmid::write_vlq_unsafe(mt.length,dest);
+	
+	auto init_sz = dest - dest_beg;
+	dest_beg = this->d_.resize(init_sz + mt.length);
+	auto n = static_cast<std::int32_t>(std::min<std::ptrdiff_t>(mt.length,end-beg));
+	if (n > 0) {
+		std::memcpy(dest_beg + init_sz,beg,n);
+	}
+	this->update_cache();
+	return {beg+n,n};
+}
+jmid::mtrk_event_t::replace_unsafe_result<const unsigned char*> 
+			jmid::mtrk_event_t::replace_unsafe(std::int32_t dt, 
+			jmid::sysex_header_data sx, const unsigned char *beg, 
+			const unsigned char *end) {
+	auto dest_beg = this->d_.resize_nocopy(9);  // Probably oversized
+	auto dest = jmid::write_delta_time_unsafe(dt,dest_beg);
+	*dest++ = sx.type;
+	dest = jmid::write_vlq_unsafe(sx.length,dest);
+	
+	auto init_sz = dest - dest_beg;
+	dest_beg = this->d_.resize(init_sz + sx.length);
+	auto n = static_cast<std::int32_t>(std::min<std::ptrdiff_t>(sx.length,end-beg));
+	if (n > 0) {
+		std::memcpy(dest_beg + init_sz,beg,n);
+	}
+	this->update_cache();
+	return {beg+n,n};
 }
 void jmid::mtrk_event_t::replace_unsafe(std::int32_t dt,
 										jmid::ch_event_data_t md) {
@@ -91,6 +142,7 @@ void jmid::mtrk_event_t::replace_unsafe(std::int32_t dt,
 		*dest++ = md.p2;
 	}
 	this->d_.resize(dest-dest_beg);
+	this->update_cache();
 }
 
 jmid::mtrk_event_t::size_type jmid::mtrk_event_t::size() const noexcept {
@@ -104,37 +156,43 @@ jmid::mtrk_event_t::size_type jmid::mtrk_event_t::capacity() const noexcept {
 }
 jmid::mtrk_event_t::size_type jmid::mtrk_event_t::reserve(jmid::mtrk_event_t::size_type new_cap) {
 	new_cap = std::clamp(new_cap,0,this->max_size());
-	return this->d_.reserve(new_cap);
+	auto result = this->d_.reserve(new_cap);
+	this->update_cache();  // May have caused a small->big transition
+	return result;
+}
+void jmid::mtrk_event_t::shrink_to_fit() {
+	this->d_.shrink_to_fit();
+	this->update_cache();  // May have caused a big->small transition
 }
 bool jmid::mtrk_event_t::is_empty() const {
 	return this->d_.size()==0;
 }
 const unsigned char *jmid::mtrk_event_t::data() noexcept {
-	return this->d_.begin();
+	return std::as_const(this->d_).begin();
 }
 const unsigned char *jmid::mtrk_event_t::data() const noexcept {
 	return this->d_.begin();
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::begin() noexcept {
-	return jmid::mtrk_event_t::const_iterator(this->d_.begin());
+	return jmid::mtrk_event_t::const_iterator(std::as_const(this->d_).begin());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::begin() const noexcept {
 	return jmid::mtrk_event_t::const_iterator(this->d_.begin());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::cbegin() noexcept {
-	return jmid::mtrk_event_t::const_iterator(this->d_.begin());
+	return jmid::mtrk_event_t::const_iterator(std::as_const(this->d_).begin());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::cbegin() const noexcept {
 	return jmid::mtrk_event_t::const_iterator(this->d_.begin());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::end() noexcept {
-	return jmid::mtrk_event_t::const_iterator(this->d_.end());
+	return jmid::mtrk_event_t::const_iterator(std::as_const(this->d_).end());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::end() const noexcept {
 	return jmid::mtrk_event_t::const_iterator(this->d_.end());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::cend() noexcept {
-	return jmid::mtrk_event_t::const_iterator(this->d_.end());
+	return jmid::mtrk_event_t::const_iterator(std::as_const(this->d_).end());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::cend() const noexcept {
 	return jmid::mtrk_event_t::const_iterator(this->d_.end());
@@ -143,19 +201,19 @@ jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::dt_begin() const noexcept
 	return jmid::mtrk_event_t::const_iterator(this->d_.begin());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::dt_begin() noexcept {
-	return jmid::mtrk_event_t::const_iterator(this->d_.begin());
+	return jmid::mtrk_event_t::const_iterator(std::as_const(this->d_).begin());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::dt_end() const noexcept {
-	return jmid::advance_to_dt_end(this->d_.begin(),this->d_.end());
+	return jmid::mtrk_event_t::const_iterator(this->d_.begin()+this->dt_nbytes());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::dt_end() noexcept {
-	return jmid::advance_to_dt_end(this->d_.begin(),this->d_.end());
+	return jmid::mtrk_event_t::const_iterator(std::as_const(this->d_).begin()+this->dt_nbytes());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::event_begin() const noexcept {
-	return jmid::advance_to_dt_end(this->d_.begin(),this->d_.end());
+	return jmid::mtrk_event_t::const_iterator(this->d_.begin()+this->dt_nbytes());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::event_begin() noexcept {
-	return jmid::advance_to_dt_end(this->d_.begin(),this->d_.end());
+	return jmid::mtrk_event_t::const_iterator(std::as_const(this->d_).begin()+this->dt_nbytes());
 }
 jmid::mtrk_event_t::const_iterator jmid::mtrk_event_t::payload_begin() const noexcept {
 	return this->payload_range_impl().begin;
@@ -173,15 +231,80 @@ unsigned char jmid::mtrk_event_t::operator[](jmid::mtrk_event_t::size_type i) co
 	return *(this->d_.begin()+i);
 };
 unsigned char jmid::mtrk_event_t::operator[](jmid::mtrk_event_t::size_type i) noexcept {
-	return *(this->d_.begin()+i);
+	return *(std::as_const(this->d_).begin()+i);
 };
 
+void jmid::mtrk_event_t::update_cache() noexcept {  // Private
+	// Read through a const d_ so that an event sharing an interned buffer
+	// is not copied
+	auto its = std::as_const(this->d_).data_range();
+	std::int32_t dt = 0;
+	std::int32_t dt_n = 0;
+	unsigned char s = 0x00u;
+	std::int32_t payload_offset = 0;
+	if (its.begin!=its.end) {
+		auto dtf = jmid::read_delta_time(its.begin,its.end);
+		dt = dtf.val;
+		dt_n = std::clamp<std::int32_t>(dtf.N,1,4);
+		auto p = its.begin + dt_n;
+		if (p!=its.end) {
+			s = *p;
+			if (jmid::is_meta_status_byte(s)) {
+				p += 2;  // 0xFFu, type-byte
+				p = jmid::advance_to_vlq_end(std::min(p,its.end),its.end);
+			} else if (jmid::is_sysex_status_byte(s)) {
+				p += 1;  // 0xF0u or 0xF7u
+				p = jmid::advance_to_vlq_end(p,its.end);
+			}
+		}
+		payload_offset = static_cast<std::int32_t>(p-its.begin);
+	}
+
+	if (this->d_.is_small()) {
+		this->d_.set_small_meta(static_cast<unsigned char>(dt_n > 0 ? dt_n-1 : 0));
+	} else {
+		auto pad = this->d_.pad_or_data_range().begin;
+		std::memcpy(pad,&dt,sizeof(std::int32_t));
+		pad[4] = s;
+		pad[5] = static_cast<unsigned char>(dt_n);
+		pad[6] = static_cast<unsigned char>(payload_offset);
+	}
+}
+void jmid::mtrk_event_t::intern_if_scoped() {
+	auto store = jmid::internal::current_intern_store();
+	if (store) {
+		this->d_.intern(*store);  // Preserves the cache
+	}
+}
+void jmid::mtrk_event_t::detach_arena() {
+	this->d_.detach_arena();  // Preserves the cache
+}
+const unsigned char *jmid::mtrk_event_t::raw_begin() const noexcept {  // Private
+	// Same as this->d_.raw_begin(), but w/o the out-of-line call:  
+	// small_bytevec_t is standard-layout and its only member is the union 
+	// of small_t, big_t and the raw byte array.  
+	static_assert(std::is_standard_layout<jmid::internal::small_bytevec_t>::value);
+	return reinterpret_cast<const unsigned char*>(&(this->d_));
+}
+std::int32_t jmid::mtrk_event_t::dt_nbytes() const noexcept {  // Private
+	auto raw = this->raw_begin();
+	if ((raw[0]&0x80u)==0x00u) {  // Big
+		return raw[1+5];
+	}
+	if ((raw[0]&jmid::internal::small_t::size_mask)==0) {
+		return 0;
+	}
+	return ((raw[0]&jmid::internal::small_t::meta_mask)>>5)+1;
+}
 jmid::mtrk_event_iterator_range_t jmid::mtrk_event_t::payload_range_impl() const noexcept {
 	auto its = this->d_.data_range();
+	if (this->d_.is_big()) {
+		return {its.begin + *(this->d_.pad_or_data_range().begin+6),its.end};
+	}
 	if (its.begin!=its.end) {
 		// If the object is_empty(), the manual increments of its.begin
 		// for the meta and sysex cases will result in hard UB.  
-		its.begin = jmid::advance_to_dt_end(its.begin,its.end);
+		its.begin += this->dt_nbytes();
 		auto s = *(its.begin);
 		if (jmid::is_meta_status_byte(s)) {
 			its.begin += 2;  // 0xFFu, type-byte
@@ -194,35 +317,43 @@ jmid::mtrk_event_iterator_range_t jmid::mtrk_event_t::payload_range_impl() const
 	return {its.begin,its.end};
 }
 std::int32_t jmid::mtrk_event_t::delta_time() const noexcept {
-	return jmid::read_delta_time(this->d_.begin(),this->d_.end()).val;
+	auto raw = this->raw_begin();
+	std::int32_t dt = 0;
+	if ((raw[0]&0x80u)==0x00u) {  // Big
+		std::memcpy(&dt,raw+1,sizeof(std::int32_t));
+		return dt;
+	}
+	// The size of the field is known, so there is no need to test each
+	// byte for the continuation bit or check against end.  
+	auto n = this->dt_nbytes();
+	for (int i=0; i<n; ++i) {
+		dt = (dt<<7) + (raw[1+i]&0x7Fu);
+	}
+	return dt;
 }
 unsigned char jmid::mtrk_event_t::status_byte() const noexcept {
-	auto its = this->d_.data_range();
-	auto p = jmid::advance_to_dt_end(its.begin,its.end);
-	return *p;
+	auto raw = this->raw_begin();
+	if ((raw[0]&0x80u)==0x00u) {  // Big
+		return raw[1+4];
+	}
+	return raw[1+this->dt_nbytes()];
 }
 unsigned char jmid::mtrk_event_t::running_status() const noexcept {
-	auto its = this->d_.data_range();
-	auto p = jmid::advance_to_dt_end(its.begin,its.end);
-	return jmid::get_running_status_byte(*p,0x00u);
+	return jmid::get_running_status_byte(this->status_byte(),0x00u);
 }
 jmid::mtrk_event_t::size_type jmid::mtrk_event_t::data_size() const noexcept {  // Not including delta-t
-	auto its = this->d_.data_range();
-	auto p = jmid::advance_to_dt_end(its.begin,its.end);
-	return its.end - p;
+	return this->d_.size() - this->dt_nbytes();
 }
 
 jmid::ch_event_data_t jmid::mtrk_event_t::get_channel_event_data() const noexcept {
-	// TODO:
-	// The reason this is most efficiently implemented as a member function
-	// is that if big, it can safely read d_.u_.b_.pad_ directly, skipping
-	// the its.end-its.begin checks.  The present implementation is no
-	// better than the free function impl.  
+	// NB:  The pad of a big d_ holds the cache (see update_cache()), not 
+	// the leading bytes of the event, so the data must be read from 
+	// d_.data_range().  
 	jmid::ch_event_data_t result;
 	result.status_nybble = 0x00u;  // Causes result to test invalid
 
-	auto its = this->d_.pad_or_data_range();
-	its.begin = jmid::advance_to_dt_end(its.begin,its.end);
+	auto its = this->d_.data_range();
+	its.begin += this->dt_nbytes();
 	if (its.end-its.begin <= 2) {
 		return result;
 	}
@@ -244,15 +375,13 @@ jmid::ch_event_data_t jmid::mtrk_event_t::get_channel_event_data() const noexcep
 	return result;
 }
 jmid::meta_header_data jmid::mtrk_event_t::get_meta() const noexcept {
-	// TODO:
-	// The reason this is most efficiently implemented as a member function
-	// is that if big, it can safely read d_.u_.b_.pad_ directly, skipping
-	// the its.end-its.begin checks and the pointer-chasing into the 
-	// remote buffer.  
+	// NB:  The pad of a big d_ holds the cache (see update_cache()), not 
+	// the leading bytes of the event, so the data must be read from 
+	// d_.data_range().  
 	jmid::meta_header_data result;
 
-	auto its = this->d_.pad_or_data_range();
-	its.begin = jmid::advance_to_dt_end(its.begin,its.end);
+	auto its = this->d_.data_range();
+	its.begin += this->dt_nbytes();
 	if (its.end-its.begin < 3) {
 		return result;
 	}
@@ -267,15 +396,13 @@ jmid::meta_header_data jmid::mtrk_event_t::get_meta() const noexcept {
 	return result;
 }
 jmid::sysex_header_data jmid::mtrk_event_t::get_sysex() const noexcept {
-	// TODO:
-	// The reason this is most efficiently implemented as a member function
-	// is that if big, it can safely read d_.u_.b_.pad_ directly, skipping
-	// the its.end-its.begin checks and the pointer-chasing into the 
-	// remote buffer.  
+	// NB:  The pad of a big d_ holds the cache (see update_cache()), not 
+	// the leading bytes of the event, so the data must be read from 
+	// d_.data_range().  
 	jmid::sysex_header_data result;
 
-	auto its = this->d_.pad_or_data_range();
-	its.begin = jmid::advance_to_dt_end(its.begin,its.end);
+	auto its = this->d_.data_range();
+	its.begin += this->dt_nbytes();
 	if (its.end-its.begin < 2) {
 		return result;
 	}
@@ -305,6 +432,7 @@ std::int32_t jmid::mtrk_event_t::set_delta_time(std::int32_t dt) {
 		std::copy_backward(new_beg,new_beg+old_size,new_end);
 		jmid::write_delta_time(dt,this->d_.begin());
 	}
+	this->update_cache();
 	return this->delta_time();
 }
 std::string jmid::mtrk_event_t::debug_print() const {
@@ -0,0 +1,132 @@
+#include "mtrk_packed_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "midi_delta_time.h"
+#include "midi_status_byte.h"
+#include "aux_types.h"  // ch_event_data_t
+#include <cstdint>
+#include <cstdlib>  // std::abort()
+#include <vector>
+
+
+namespace {
+std::int32_t side_index(const jmid::packed_ch_event_t& e) {
+	return (std::int32_t{e.p1}<<16) | (std::int32_t{e.p2}<<8) | e.p3;
+}
+}  // namespace
+
+
+jmid::mtrk_packed_t::mtrk_packed_t() noexcept {
+	//...
+}
+jmid::mtrk_packed_t::mtrk_packed_t(const jmid::mtrk_t& mtrk) {
+	jmid::mtrk_packed_t::size_type n_side = 0;
+	for (const auto& ev : mtrk) {
+		n_side += !jmid::is_channel_status_byte(ev.status_byte());
+	}
+	this->reserve(mtrk.size(),n_side);
+	for (const auto& ev : mtrk) {
+		this->push_back(ev);
+	}
+}
+jmid::mtrk_packed_t::size_type jmid::mtrk_packed_t::size() const noexcept {
+	return static_cast<jmid::mtrk_packed_t::size_type>(this->evnts_.size());
+}
+jmid::mtrk_packed_t::size_type jmid::mtrk_packed_t::side_size() const noexcept {
+	return static_cast<jmid::mtrk_packed_t::size_type>(this->side_.size());
+}
+std::int32_t jmid::mtrk_packed_t::nticks() const noexcept {
+	return this->nticks_;
+}
+jmid::mtrk_packed_t::size_type jmid::mtrk_packed_t::nbytes() const {
+	return this->data_nbytes() + 8;
+}
+jmid::mtrk_packed_t::size_type jmid::mtrk_packed_t::data_nbytes() const {
+	std::int32_t result = 0;
+	for (const auto& e : this->evnts_) {
+		result += jmid::delta_time_field_size(e.delta_time);
+		if (this->is_channel(e)) {
+			result += 1 + jmid::channel_status_byte_n_data_bytes(e.status);
+		} else {
+			// The stored delta time is 0, which occupies a single byte
+			result += this->side_event(e).size()-1;
+		}
+	}
+	return result;
+}
+void jmid::mtrk_packed_t::push_back(const jmid::mtrk_event_t& ev) {
+	jmid::packed_ch_event_t e;
+	e.delta_time = ev.delta_time();
+	e.status = ev.status_byte();
+	e.p1 = 0x00u;
+	e.p2 = 0x00u;
+	e.p3 = 0x00u;
+	if (jmid::is_channel_status_byte(e.status)) {
+		auto p = ev.event_begin();  // The status byte
+		e.p1 = *(p+1);
+		if (jmid::channel_status_byte_n_data_bytes(e.status)==2) {
+			e.p2 = *(p+2);
+		}
+	} else {
+		auto idx = this->side_size();
+		if (idx >= jmid::mtrk_packed_t::side_size_max) {
+			std::abort();
+		}
+		e.p1 = static_cast<unsigned char>((idx>>16)&0xFF);
+		e.p2 = static_cast<unsigned char>((idx>>8)&0xFF);
+		e.p3 = static_cast<unsigned char>(idx&0xFF);
+		this->side_.push_back(ev);
+		this->side_.back().set_delta_time(0);
+	}
+	this->evnts_.push_back(e);
+	this->nticks_ += e.delta_time;
+}
+void jmid::mtrk_packed_t::clear() noexcept {
+	this->evnts_.clear();
+	this->side_.clear();
+	this->nticks_ = 0;
+}
+void jmid::mtrk_packed_t::reserve(jmid::mtrk_packed_t::size_type nevents,
+								jmid::mtrk_packed_t::size_type nside) {
+	this->evnts_.reserve(nevents);
+	this->side_.reserve(nside);
+}
+const jmid::packed_ch_event_t *jmid::mtrk_packed_t::begin() const noexcept {
+	return this->evnts_.data();
+}
+const jmid::packed_ch_event_t *jmid::mtrk_packed_t::end() const noexcept {
+	return this->evnts_.data() + this->evnts_.size();
+}
+const jmid::packed_ch_event_t& jmid::mtrk_packed_t::operator[](
+					jmid::mtrk_packed_t::size_type i) const noexcept {
+	return this->evnts_[i];
+}
+bool jmid::mtrk_packed_t::is_channel(const jmid::packed_ch_event_t& e) const noexcept {
+	return jmid::is_channel_status_byte(e.status);
+}
+const jmid::mtrk_event_t& jmid::mtrk_packed_t::side_event(
+					const jmid::packed_ch_event_t& e) const noexcept {
+	return this->side_[side_index(e)];
+}
+jmid::mtrk_event_t jmid::mtrk_packed_t::event(const jmid::packed_ch_event_t& e) const {
+	if (this->is_channel(e)) {
+		jmid::ch_event_data_t md;
+		md.status_nybble = e.status&0xF0u;
+		md.ch = e.status&0x0Fu;
+		md.p1 = e.p1;
+		md.p2 = e.p2;
+		return jmid::mtrk_event_t(e.delta_time,md);
+	}
+	auto result = this->side_event(e);
+	result.set_delta_time(e.delta_time);
+	return result;
+}
+jmid::mtrk_t jmid::mtrk_packed_t::to_mtrk() const {
+	jmid::mtrk_t result;
+	result.reserve(this->size());
+	for (const auto& e : this->evnts_) {
+		result.push_back(this->event(e));
+	}
+	return result;
+}
+
@@ -10,10 +10,13 @@
 #include <utility>
 #include <vector>
 #include <array>  // get_header()
-#include <algorithm>  // std::copy(), std::find_if() in linked-pair finding functions
+#include <algorithm>  // std::copy(), std::find_if(), std::stable_partition()
 #include <iomanip>  // std::setw()
 #include <ios>  // std::left
 #include <sstream>
+#include <cstring>  // std::memcpy() in write_mtrk()
+#include <memory>  // std::make_unique() in set_arena_enabled()
+#include <cstddef>  // std::ptrdiff_t
 
 jmid::mtrk_t::mtrk_t() noexcept {
 	//...
@@ -21,19 +24,61 @@ jmid::mtrk_t::mtrk_t() noexcept {
 jmid::mtrk_t::mtrk_t(jmid::mtrk_t::const_iterator beg, jmid::mtrk_t::const_iterator end) {
 	this->evnts_.resize(end-beg);
 	std::copy(beg,end,this->evnts_.begin());
+	this->stale_ = true;
+	this->update_totals();
 }
 jmid::mtrk_t::mtrk_t(const jmid::mtrk_t& rhs) {
 	this->evnts_ = rhs.evnts_;
+	this->stale_ = rhs.stale_;
+	if (!this->stale_) {  // O(1); includes any change to the watched event
+		this->data_nbytes_ = rhs.data_nbytes();
+		this->nticks_ = rhs.nticks();
+	}
 }
 jmid::mtrk_t::mtrk_t(jmid::mtrk_t&& rhs) noexcept {
 	this->evnts_ = std::move(rhs.evnts_);
+	this->arena_ = std::move(rhs.arena_);
+	this->data_nbytes_ = rhs.data_nbytes_;
+	this->nticks_ = rhs.nticks_;
+	this->stale_ = rhs.stale_;
+	rhs.stale_ = true;
+	this->tkidx_enabled_ = rhs.tkidx_enabled_;
+	this->tkidx_stale_ = rhs.tkidx_stale_;
+	this->tkidx_ = std::move(rhs.tkidx_);
+	this->watch_ = rhs.watch_;
+	this->watch_dt_ = rhs.watch_dt_;
+	this->watch_size_ = rhs.watch_size_;
+	rhs.tkidx_enabled_ = false;
+	rhs.tkidx_.clear();
+	rhs.watch_ = -1;
 }
 jmid::mtrk_t& jmid::mtrk_t::operator=(const jmid::mtrk_t& rhs) {
 	this->evnts_ = rhs.evnts_;
+	this->stale_ = rhs.stale_;
+	if (!this->stale_) {
+		this->data_nbytes_ = rhs.data_nbytes();
+		this->nticks_ = rhs.nticks();
+	}
+	this->watch_ = -1;
+	this->rebuild_tk_index();
 	return *this;
 }
 jmid::mtrk_t& jmid::mtrk_t::operator=(jmid::mtrk_t&& rhs) noexcept {
 	this->evnts_ = std::move(rhs.evnts_);
+	this->arena_ = std::move(rhs.arena_);
+	this->data_nbytes_ = rhs.data_nbytes_;
+	this->nticks_ = rhs.nticks_;
+	this->stale_ = rhs.stale_;
+	rhs.stale_ = true;
+	this->tkidx_enabled_ = rhs.tkidx_enabled_;
+	this->tkidx_stale_ = rhs.tkidx_stale_;
+	this->tkidx_ = std::move(rhs.tkidx_);
+	this->watch_ = rhs.watch_;
+	this->watch_dt_ = rhs.watch_dt_;
+	this->watch_size_ = rhs.watch_size_;
+	rhs.tkidx_enabled_ = false;
+	rhs.tkidx_.clear();
+	rhs.watch_ = -1;
 	return *this;
 }
 jmid::mtrk_t::~mtrk_t() noexcept {
@@ -51,29 +96,178 @@ jmid::mtrk_t::size_type jmid::mtrk_t::capacity() const {
 	return static_cast<jmid::mtrk_t::size_type>(cap);
 }
 jmid::mtrk_t::size_type jmid::mtrk_t::nbytes() const {
-	jmid::mtrk_t::size_type sz = 8;  // MTrk+4-byte length field
+	return (this->data_nbytes()+8);  // MTrk+4-byte length field
+}
+jmid::mtrk_t::size_type jmid::mtrk_t::data_nbytes() const {
+	if (!this->stale_) {
+		return static_cast<jmid::mtrk_t::size_type>(this->data_nbytes_
+			+ this->watched_size_change());
+	}
+	jmid::mtrk_t::size_type sz = 0;
 	for (const auto& e : this->evnts_) {
 		sz += e.size();
 	}
 	return sz;
 }
-jmid::mtrk_t::size_type jmid::mtrk_t::data_nbytes() const {
-	return (this->nbytes()-8);
-}
 std::int32_t jmid::mtrk_t::nticks() const {
+	if (!this->stale_) {
+		return static_cast<std::int32_t>(this->nticks_
+			+ this->watched_dt_change());
+	}
 	std::int32_t cumtk = 0;
 	for (const auto& e : this->evnts_) {
 		cumtk += e.delta_time();
 	}
 	return cumtk;
 }
+jmid::mtrk_t::size_type jmid::mtrk_t::nbytes() {
+	return (this->data_nbytes()+8);
+}
+jmid::mtrk_t::size_type jmid::mtrk_t::data_nbytes() {
+	this->update_totals();
+	return static_cast<jmid::mtrk_t::size_type>(this->data_nbytes_);
+}
+std::int32_t jmid::mtrk_t::nticks() {
+	this->update_totals();
+	return static_cast<std::int32_t>(this->nticks_);
+}
+void jmid::mtrk_t::update_totals() {  // Private
+	this->apply_watch();
+	if (!this->stale_) {
+		return;
+	}
+	this->data_nbytes_ = 0;
+	this->nticks_ = 0;
+	for (const auto& e : this->evnts_) {
+		this->data_nbytes_ += e.size();
+		this->nticks_ += e.delta_time();
+	}
+	this->stale_ = false;
+}
+void jmid::mtrk_t::add_to_totals(const jmid::mtrk_event_t& ev) {  // Private
+	if (!this->stale_) {
+		this->data_nbytes_ += ev.size();
+		this->nticks_ += ev.delta_time();
+	}
+}
+void jmid::mtrk_t::sub_from_totals(const jmid::mtrk_event_t& ev) {  // Private
+	if (!this->stale_) {
+		this->data_nbytes_ -= ev.size();
+		this->nticks_ -= ev.delta_time();
+	}
+}
+bool jmid::mtrk_t::tk_index_current() const {
+	return (this->tkidx_enabled_ && !this->tkidx_stale_ 
+		&& (this->watched_dt_change() == 0));
+}
+void jmid::mtrk_t::watch(jmid::mtrk_t::size_type idx) {  // Private
+	if (idx >= this->size()) {
+		this->watch_ = -1;
+		return;
+	}
+	this->watch_ = idx;
+	this->watch_dt_ = this->evnts_[idx].delta_time();
+	this->watch_size_ = this->evnts_[idx].size();
+}
+std::int32_t jmid::mtrk_t::watched_dt_change() const {  // Private
+	if (this->watch_ < 0) {
+		return 0;
+	}
+	return this->evnts_[this->watch_].delta_time() - this->watch_dt_;
+}
+std::int32_t jmid::mtrk_t::watched_size_change() const {  // Private
+	if (this->watch_ < 0) {
+		return 0;
+	}
+	return this->evnts_[this->watch_].size() - this->watch_size_;
+}
+void jmid::mtrk_t::apply_watch() {  // Private
+	if (this->watch_ < 0) {
+		return;
+	}
+	auto dtk = this->watched_dt_change();
+	if (!this->stale_) {
+		this->data_nbytes_ += this->watched_size_change();
+		this->nticks_ += dtk;
+	}
+	if (this->tkidx_enabled_ && !this->tkidx_stale_ && (dtk != 0)) {
+		this->tk_index_shift(this->watch_+1,dtk);
+	}
+	this->watch_ = -1;
+}
+void jmid::mtrk_t::update_tk_index() {  // Private
+	this->apply_watch();
+	if (this->tkidx_stale_) {
+		this->rebuild_tk_index();
+	}
+}
+void jmid::mtrk_t::rebuild_tk_index() {  // Private
+	this->tkidx_stale_ = false;
+	if (!this->tkidx_enabled_) {
+		return;
+	}
+	this->tkidx_.resize(this->evnts_.size()+1);
+	std::int32_t tk = 0;
+	this->tkidx_[0] = 0;
+	for (std::size_t i=0; i<this->evnts_.size(); ++i) {
+		tk += this->evnts_[i].delta_time();
+		this->tkidx_[i+1] = tk;
+	}
+}
+void jmid::mtrk_t::tk_index_shift(jmid::mtrk_t::size_type idx,
+								std::int32_t dtk) {  // Private
+	for (auto it=this->tkidx_.begin()+idx; it!=this->tkidx_.end(); ++it) {
+		*it += dtk;
+	}
+}
+void jmid::mtrk_t::tk_index_inserted(jmid::mtrk_t::size_type idx) {  // Private
+	if (!this->tk_index_current()) {
+		return;
+	}
+	auto dt = this->evnts_[idx].delta_time();
+	this->tkidx_.insert(this->tkidx_.begin()+idx+1,this->tkidx_[idx]+dt);
+	this->tk_index_shift(idx+2,dt);
+}
+void jmid::mtrk_t::tk_index_erased(jmid::mtrk_t::size_type idx,
+								std::int32_t dt) {  // Private
+	if (!this->tk_index_current()) {
+		return;
+	}
+	this->tkidx_.erase(this->tkidx_.begin()+idx+1);
+	this->tk_index_shift(idx+1,-dt);
+}
+void jmid::mtrk_t::set_tk_index_enabled(bool enable) {
+	this->apply_watch();
+	this->tkidx_enabled_ = enable;
+	if (!enable) {
+		this->tkidx_.clear();
+		this->tkidx_.shrink_to_fit();
+		return;
+	}
+	this->rebuild_tk_index();
+}
+bool jmid::mtrk_t::tk_index_enabled() const {
+	return this->tkidx_enabled_;
+}
+jmid::mtrk_t::iterator jmid::mtrk_t::iter_at(jmid::mtrk_t::size_type idx) {
+	if (this->evnts_.size()==0) {
+		return jmid::mtrk_t::iterator(nullptr);
+	}
+	return jmid::mtrk_t::iterator(&(this->evnts_[0]) + idx);
+}
 jmid::mtrk_t::iterator jmid::mtrk_t::begin() {
+	this->stale_ = true;
+	this->tkidx_stale_ = true;
+	this->watch_ = -1;
 	if (this->evnts_.size()==0) {
 		return jmid::mtrk_t::iterator(nullptr);
 	}
 	return jmid::mtrk_t::iterator(&(this->evnts_[0]));
 }
 jmid::mtrk_t::iterator jmid::mtrk_t::end() {
+	this->stale_ = true;
+	this->tkidx_stale_ = true;
+	this->watch_ = -1;
 	if (this->evnts_.size()==0) {
 		return jmid::mtrk_t::iterator(nullptr);
 	}
@@ -92,33 +286,49 @@ jmid::mtrk_t::const_iterator jmid::mtrk_t::end() const {
 	return jmid::mtrk_t::const_iterator(&(this->evnts_[0]) + this->evnts_.size());
 }
 jmid::mtrk_event_t& jmid::mtrk_t::operator[](jmid::mtrk_t::size_type idx) {
+	this->stale_ = true;
+	this->tkidx_stale_ = true;
+	this->watch_ = -1;
 	return this->evnts_[idx];
 }
 const jmid::mtrk_event_t& jmid::mtrk_t::operator[](jmid::mtrk_t::size_type idx) const {
 	return this->evnts_[idx];
 }
 jmid::mtrk_event_t& jmid::mtrk_t::back() {
+	this->stale_ = true;
+	this->tkidx_stale_ = true;
+	this->watch_ = -1;
 	return this->evnts_.back();
 }
 const jmid::mtrk_event_t& jmid::mtrk_t::back() const {
 	return this->evnts_.back();
 }
 jmid::mtrk_event_t& jmid::mtrk_t::front() {
+	this->stale_ = true;
+	this->tkidx_stale_ = true;
+	this->watch_ = -1;
 	return this->evnts_.front();
 }
 const jmid::mtrk_event_t& jmid::mtrk_t::front() const {
 	return this->evnts_.front();
 }
 jmid::event_tk_t<jmid::mtrk_t::iterator> jmid::mtrk_t::at_cumtk(std::int32_t cumtk_on) {
-	jmid::event_tk_t<jmid::mtrk_t::iterator> res {this->begin(),0};
-	while (res.it!=this->end() && res.tk<cumtk_on) {
-		res.tk += res.it->delta_time();
-		++(res.it);
-	}
-	return res;
+	this->update_tk_index();
+	const auto& cthis = *this;
+	auto res = cthis.at_cumtk(cumtk_on);
+	auto idx = static_cast<jmid::mtrk_t::size_type>(res.it-cthis.begin());
+	return {this->handout(idx),res.tk};
 }
 jmid::event_tk_t<jmid::mtrk_t::const_iterator>
 						jmid::mtrk_t::at_cumtk(std::int32_t cumtk_on) const {
+	if (this->tk_index_current()) {
+		// The first event w/ cumtk >= cumtk_on; tkidx_[size()] is the 
+		// cumtk of end()
+		auto n = this->evnts_.size();
+		auto idx = std::lower_bound(this->tkidx_.begin(),
+			this->tkidx_.begin()+n,cumtk_on) - this->tkidx_.begin();
+		return {this->begin()+idx,this->tkidx_[idx]};
+	}
 	jmid::event_tk_t<jmid::mtrk_t::const_iterator> res {this->begin(),0};
 	while (res.it!=this->end() && res.tk<cumtk_on) {
 		res.tk += res.it->delta_time();
@@ -127,20 +337,21 @@ jmid::event_tk_t<jmid::mtrk_t::const_iterator>
 	return res;
 }
 jmid::event_tk_t<jmid::mtrk_t::iterator> jmid::mtrk_t::at_tkonset(std::int32_t tk_on) {
-	jmid::event_tk_t<mtrk_t::iterator> 
-		res {this->begin(),0};
-	while (res.it!=this->end()) {
-		res.tk += res.it->delta_time();
-		if (res.tk >= tk_on) {
-			break;
-		}
-		++(res.it);
-	}
-	return res;
+	this->update_tk_index();
+	const auto& cthis = *this;
+	auto res = cthis.at_tkonset(tk_on);
+	auto idx = static_cast<jmid::mtrk_t::size_type>(res.it-cthis.begin());
+	return {this->handout(idx),res.tk};
 }
 jmid::event_tk_t<jmid::mtrk_t::const_iterator> jmid::mtrk_t::at_tkonset(std::int32_t tk_on) const {
-	jmid::event_tk_t<jmid::mtrk_t::const_iterator> 
-		res {this->begin(),this->begin()->delta_time()};
+	if (this->tk_index_current()) {
+		// The onset tk of event i is tkidx_[i+1]
+		auto idx = std::lower_bound(this->tkidx_.begin()+1,
+			this->tkidx_.end(),tk_on) - (this->tkidx_.begin()+1);
+		auto n = static_cast<std::ptrdiff_t>(this->evnts_.size());
+		return {this->begin()+idx,this->tkidx_[std::min(idx+1,n)]};
+	}
+	jmid::event_tk_t<jmid::mtrk_t::const_iterator> res {this->begin(),0};
 	while (res.it!=this->end()) {
 		res.tk += res.it->delta_time();
 		if (res.tk >= tk_on) {
@@ -150,73 +361,215 @@ jmid::event_tk_t<jmid::mtrk_t::const_iterator> jmid::mtrk_t::at_tkonset(std::int
 	}
 	return res;
 }
+jmid::mtrk_event_t& jmid::mtrk_t::appended() {  // Private
+	this->apply_watch();  // Appending does not move the watched event
+	const auto& ev = this->evnts_.back();
+	this->add_to_totals(ev);
+	if (this->tk_index_current()) {
+		this->tkidx_.push_back(this->tkidx_.back() + ev.delta_time());
+	}
+	this->watch(this->size()-1);
+	return this->evnts_.back();
+}
+jmid::mtrk_t::iterator jmid::mtrk_t::handout(jmid::mtrk_t::size_type idx) {  // Private
+	this->stale_ = true;
+	this->watch(idx);
+	return this->iter_at(idx);
+}
 jmid::mtrk_event_t& jmid::mtrk_t::push_back(const jmid::mtrk_event_t& ev) {
+	internal::arena_scope_t arena_scope(this->arena_.get());
 	if (this->evnts_.size() < jmid::mtrk_t::capacity_max) {
 		this->evnts_.push_back(ev);
+		return this->appended();
+	}
+	return this->evnts_.back();
+}
+jmid::mtrk_event_t& jmid::mtrk_t::push_back(jmid::mtrk_event_t&& ev) {
+	internal::arena_scope_t arena_scope(this->arena_.get());
+	if (this->evnts_.size() < jmid::mtrk_t::capacity_max) {
+		ev.detach_arena();
+		this->evnts_.push_back(std::move(ev));
+		return this->appended();
+	}
+	return this->evnts_.back();
+}
+jmid::mtrk_event_t& jmid::mtrk_t::emplace_back(std::int32_t dt,
+								jmid::ch_event_data_t md) {
+	internal::arena_scope_t arena_scope(this->arena_.get());
+	if (this->evnts_.size() < jmid::mtrk_t::capacity_max) {
+		this->evnts_.emplace_back(dt,md);
+		return this->appended();
+	}
+	return this->evnts_.back();
+}
+jmid::mtrk_event_t& jmid::mtrk_t::emplace_back(std::int32_t dt,
+			jmid::meta_header mt, const unsigned char *beg, 
+			const unsigned char *end) {
+	internal::arena_scope_t arena_scope(this->arena_.get());
+	if (this->evnts_.size() < jmid::mtrk_t::capacity_max) {
+		this->evnts_.emplace_back(jmid::delta_time(dt),mt,beg,end);
+		return this->appended();
+	}
+	return this->evnts_.back();
+}
+jmid::mtrk_event_t& jmid::mtrk_t::emplace_back(std::int32_t dt,
+			jmid::sysex_header sx, const unsigned char *beg, 
+			const unsigned char *end) {
+	internal::arena_scope_t arena_scope(this->arena_.get());
+	if (this->evnts_.size() < jmid::mtrk_t::capacity_max) {
+		this->evnts_.emplace_back(jmid::delta_time(dt),sx,beg,end);
+		return this->appended();
 	}
-	return this->back();
+	return this->evnts_.back();
 }
 void jmid::mtrk_t::pop_back() {
+	this->apply_watch();
+	this->sub_from_totals(this->evnts_.back());
 	this->evnts_.pop_back();
+	if (this->tk_index_current()) {
+		this->tkidx_.pop_back();
+	}
 }
 jmid::mtrk_t::iterator jmid::mtrk_t::insert(jmid::mtrk_t::iterator it, const jmid::mtrk_event_t& ev) {
+	internal::arena_scope_t arena_scope(this->arena_.get());
+	this->apply_watch();
+	if (this->evnts_.size() >= jmid::mtrk_t::capacity_max) {
+		return it;
+	}
+	auto vit = this->evnts_.insert(this->evnts_.begin()+(it-this->iter_at(0)),ev);
+	auto idx = static_cast<mtrk_t::size_type>(vit-this->evnts_.begin());
+	this->add_to_totals(*vit);
+	this->tk_index_inserted(idx);
+	return this->handout(idx);
+}
+jmid::mtrk_t::iterator jmid::mtrk_t::insert(jmid::mtrk_t::iterator it, jmid::mtrk_event_t&& ev) {
+	internal::arena_scope_t arena_scope(this->arena_.get());
+	this->apply_watch();
 	if (this->evnts_.size() >= jmid::mtrk_t::capacity_max) {
 		return it;
 	}
-	auto vit = this->evnts_.insert(this->evnts_.begin()+(it-this->begin()),ev);
-	return this->begin() + static_cast<mtrk_t::size_type>(vit-this->evnts_.begin());
+	ev.detach_arena();
+	auto vit = this->evnts_.insert(this->evnts_.begin()+(it-this->iter_at(0)),std::move(ev));
+	auto idx = static_cast<mtrk_t::size_type>(vit-this->evnts_.begin());
+	this->add_to_totals(*vit);
+	this->tk_index_inserted(idx);
+	return this->handout(idx);
 }
 jmid::mtrk_t::iterator jmid::mtrk_t::insert_no_tkshift(jmid::mtrk_t::iterator it, jmid::mtrk_event_t ev) {
 	std::int32_t new_dt = ev.delta_time();
-	while ((it != this->end()) && (it->delta_time() < new_dt)) {
+	auto end = this->iter_at(this->size());
+	while ((it != end) && (it->delta_time() < new_dt)) {
 		new_dt -= it->delta_time();
 		++it;
 	}
-	if (it != this->end()) {
-		it->set_delta_time(it->delta_time()-new_dt);
+	if (it != end) {
+		this->set_delta_time(it,it->delta_time()-new_dt);
 	}
 	ev.set_delta_time(new_dt);
-	return this->insert(it,ev);
+	return this->insert(it,std::move(ev));
 }
 // Insert the provided event into the sequence such that its onset tick
 // is == arg1 + arg2.delta_time()
 jmid::mtrk_t::iterator jmid::mtrk_t::insert(std::int32_t cumtk_pos, jmid::mtrk_event_t ev) {
 	auto new_tk_onset = cumtk_pos+ev.delta_time();
-	auto where = this->at_tkonset(cumtk_pos);
+	// The insertion is O(n) anyway, so the tick index is brought up to 
+	// date first.  The lookup is through the const overload, which does 
+	// not mark the totals stale.  
+	this->update_tk_index();
+	const auto& cthis = *this;
+	auto where = cthis.at_tkonset(cumtk_pos);
 	// Insertion before where.it guarantees insertion at cumtk < cumtk_pos
 	auto where_cumtk = where.tk;
-	if (where.it != this->end()) {
+	if (where.it != cthis.end()) {
 		// TODO:  Gross behavior to have to check for the end iterator
 		where_cumtk -= where.it->delta_time();
 	}
 	// The tkonset would be where_cumtk + ev.delta_time()
 	ev.set_delta_time(new_tk_onset - where_cumtk);
-	return this->insert(where.it,ev);
+	return this->insert(this->iter_at(where.it-cthis.begin()),std::move(ev));
 }
 jmid::mtrk_t::iterator jmid::mtrk_t::erase(jmid::mtrk_t::iterator it) {
-	auto idx = it-this->begin();
+	this->apply_watch();
+	auto idx = it-this->iter_at(0);
+	auto dt = this->evnts_[idx].delta_time();
+	this->sub_from_totals(this->evnts_[idx]);
 	auto vit = this->evnts_.erase(this->evnts_.begin()+idx);
-	return this->begin()+static_cast<jmid::mtrk_t::size_type>(vit-this->evnts_.begin());
+	this->tk_index_erased(idx,dt);
+	return this->handout(static_cast<jmid::mtrk_t::size_type>(vit-this->evnts_.begin()));
 }
 jmid::mtrk_t::const_iterator jmid::mtrk_t::erase(jmid::mtrk_t::const_iterator it) {
-	auto idx = it-this->begin();
+	this->apply_watch();
+	auto idx = it-this->iter_at(0);
+	auto dt = this->evnts_[idx].delta_time();
+	this->sub_from_totals(this->evnts_[idx]);
 	auto vit = this->evnts_.erase(this->evnts_.begin()+idx);
-	return this->begin()+static_cast<mtrk_t::size_type>(vit-this->evnts_.begin());
+	this->tk_index_erased(idx,dt);
+	return this->iter_at(static_cast<mtrk_t::size_type>(vit-this->evnts_.begin()));
 }
 jmid::mtrk_t::iterator jmid::mtrk_t::erase_no_tkshift(jmid::mtrk_t::iterator it) {
 	auto dt = it->delta_time();
 	it = this->erase(it);
-	if (it!=this->end()) {
-		it->set_delta_time(it->delta_time()+dt);
+	if (it!=this->iter_at(this->size())) {
+		this->set_delta_time(it,it->delta_time()+dt);
 	}
 	return it;
 }
+jmid::mtrk_t::iterator jmid::mtrk_t::set_delta_time(jmid::mtrk_t::iterator it,
+								std::int32_t dt) {
+	this->apply_watch();
+	auto dtk = -(it->delta_time());
+	this->sub_from_totals(*it);
+	it->set_delta_time(dt);
+	this->add_to_totals(*it);
+	if (this->tk_index_current()) {
+		dtk += it->delta_time();
+		this->tk_index_shift((it-this->iter_at(0))+1,dtk);
+	}
+	return this->handout(it-this->iter_at(0));
+}
 void jmid::mtrk_t::clear() {
 	this->evnts_.clear();
+	if (this->arena_) {
+		this->arena_->release();
+	}
+	this->data_nbytes_ = 0;
+	this->nticks_ = 0;
+	this->stale_ = false;
+	this->watch_ = -1;
+	this->rebuild_tk_index();
+}
+void jmid::mtrk_t::set_arena_enabled(bool enable) {
+	if (enable == this->arena_enabled()) {
+		return;
+	}
+	if (enable) {
+		this->arena_ = std::make_unique<jmid::internal::byte_arena_t>();
+		return;
+	}
+	// The copy ctor allocates w/ new [], since no arena_scope_t is active
+	for (auto& ev : this->evnts_) {
+		ev = jmid::mtrk_event_t(ev);
+	}
+	this->arena_.reset();
+}
+bool jmid::mtrk_t::arena_enabled() const {
+	return static_cast<bool>(this->arena_);
+}
+const jmid::internal::byte_arena_t *jmid::mtrk_t::arena() const {
+	return this->arena_.get();
 }
 void jmid::mtrk_t::resize(jmid::mtrk_t::size_type n) {
+	this->apply_watch();
 	n = std::clamp(n,0,jmid::mtrk_t::capacity_max);
+	for (auto i=n; i<this->size(); ++i) {
+		this->sub_from_totals(this->evnts_[i]);
+	}
+	auto old_size = this->size();
 	this->evnts_.resize(n);
+	for (auto i=old_size; i<n; ++i) {
+		this->add_to_totals(this->evnts_[i]);
+	}
+	this->rebuild_tk_index();
 }
 void jmid::mtrk_t::reserve(jmid::mtrk_t::size_type n) {
 	if (n > jmid::mtrk_t::capacity_max) {
@@ -224,116 +577,149 @@ void jmid::mtrk_t::reserve(jmid::mtrk_t::size_type n) {
 	}
 	this->evnts_.reserve(n);
 }
-jmid::mtrk_t::validate_t jmid::mtrk_t::validate() const {
+jmid::mtrk_t::validate_t jmid::mtrk_t::validate(std::int32_t max_diagnostics) const {
 	jmid::mtrk_t::validate_t r {};
-
-	// vector sounding holds a list of note-on events for which a 
-	// corresponding note-off event has not yet been encountered.  When the
-	// corresponding note-off event is found, the on event is cleared from 
-	// the list.  
-	// -> Multiple "on" events w/the same note and ch number are considered 
-	//    warnings, not errors; the first off event will match with the 
-	//    first on event only.  
-	// -> Orphan note-off events are considered warnings, not errors
-	// is_matching_onoff(const sounding_notes_t& sev) also serves to check 
-	// for duplicate note-on events.  
-	struct sounding_notes_t {
-		int idx;
-		int ch {0};
-		int note {0};  // note number
-	};
-	std::vector<sounding_notes_t> sounding;
-	sounding.reserve(10);  // Expect <= 10 simultaneously sounding notes???
-	jmid::ch_event_data_t curr_chev_data;  //mtrk_event_t::channel_event_data_t curr_chev_data;
-	auto is_matching_onoff 
-		= [&curr_chev_data](const sounding_notes_t& sev) -> bool {
-		return jmid::is_onoff_pair(sev.ch,sev.note,
-						curr_chev_data.ch,curr_chev_data.p1);
+	using errc = jmid::mtrk_diagnostic_t::errc;
+	// Returns false if the scan should stop
+	auto add = [&r,max_diagnostics](errc ec, std::int32_t idx, 
+			std::int32_t cumtk, unsigned char ch, unsigned char note) -> bool {
+		r.diagnostics.push_back({ec,idx,cumtk,ch,note});
+		if (jmid::is_error(ec)) {
+			return false;
+		}
+		if (static_cast<std::int32_t>(r.diagnostics.size()) >= max_diagnostics) {
+			r.truncated = true;
+			return false;
+		}
+		return true;
 	};
+	if (max_diagnostics <= 0) {
+		r.truncated = true;
+		return r;
+	}
+
+	// sounding[128*ch+note] is the number of note-on events for which a 
+	// corresponding note-off event has not yet been encountered.  
+	// -> Multiple "on" events w/the same note and ch number are warnings, 
+	//    not errors; the first off event matches the first on event.  
+	// -> Orphan note-off events are warnings, not errors
+	std::array<std::int32_t,16*128> sounding {};
+	std::int32_t n_sounding = 0;
 
 	// Certain meta events are not allowed to occur after the first channel
 	// event, or after t=0.  found_ch_event is set to true once a ch event 
 	// has been encountered.  
 	bool found_ch_ev = false;
-	std::int32_t cumtk = 0;  // Cumulative delta-time
-	for (int i=0; i<this->evnts_.size(); ++i) {
-		auto s = this->evnts_[i].status_byte();
+	// The diagnostics record the cumtk of ev, ie the cumulative delta-time
+	// prior to ev; tkonset is cumtk + ev.delta_time().  
+	std::int32_t cumtk = 0;
+	std::int32_t tkonset = 0;
+	auto n = static_cast<std::int32_t>(this->evnts_.size());
+	for (std::int32_t i=0; i<n; ++i) {
+		const auto& ev = this->evnts_[i];
+		auto s = ev.status_byte();
+		cumtk = tkonset;
+		tkonset += ev.delta_time();
 		if (!jmid::is_status_byte(s) || jmid::is_unrecognized_status_byte(s)) {
-			r.error = "this->evnts_[i].status_byte() == " + std::to_string(s)
-				+ " is invalid\n\t";
+			add(errc::invalid_status_byte,i,cumtk,0,0);
 			return r;
 		}
 		
-		cumtk += this->evnts_[i].delta_time();
-		found_ch_ev = (found_ch_ev || jmid::is_channel_status_byte(s));
-		
-		if (jmid::is_note_on(this->evnts_[i])) {
-			curr_chev_data = jmid::get_channel_event(this->evnts_[i]);
-			auto it = std::find_if(sounding.begin(),sounding.end(),
-				is_matching_onoff);
-			if (it!=sounding.end()) {
-				r.warning += ("Multiple on-events found for note "
-					+ std::to_string(curr_chev_data.p1) + " on channel "
-					+ std::to_string(curr_chev_data.ch) + "; events "
-					+ std::to_string(it->idx) + " and " + std::to_string(i)
-					+ ".  \n");
-			}  //it==sounding.end() => orphan "off" event
-			sounding.push_back({i,curr_chev_data.ch,curr_chev_data.p1});
-		} else if (jmid::is_note_off(this->evnts_[i])) {
-			curr_chev_data = jmid::get_channel_event(this->evnts_[i]);  //curr_chev_data = this->evnts_[i].midi_data();
-			auto it = std::find_if(sounding.begin(),sounding.end(),
-				is_matching_onoff);
-			if (it!=sounding.end()) {
-				sounding.erase(it);
-			} else {
-				r.warning += ("Orphan note-off event found for note "
-					+ std::to_string(curr_chev_data.p1) + " on channel "
-					+ std::to_string(curr_chev_data.ch) + "; event number "
-					+ std::to_string(it->idx) + ".  \n");
+		if (jmid::is_channel_status_byte(s)) {
+			found_ch_ev = true;
+			auto md = jmid::get_channel_event_impl(ev);
+			bool is_on = jmid::is_note_on(md);
+			if (!is_on && !jmid::is_note_off(md)) {
+				continue;
+			}
+			auto k = 128*(md.ch&0x0Fu) + (md.p1&0x7Fu);
+			if (is_on) {
+				++n_sounding;
+				if ((sounding[k]++ > 0) 
+						&& !add(errc::multiple_note_on,i,cumtk,md.ch,md.p1)) {
+					return r;
+				}
+			} else if (sounding[k] > 0) {
+				--sounding[k];
+				--n_sounding;
+			} else if (!add(errc::orphan_note_off,i,cumtk,md.ch,md.p1)) {
+				return r;
 			}
-		} else if (jmid::is_eot(this->evnts_[i]) && (i!=(this->evnts_.size()-1))) {
-			r.error = ("Illegal \"End-of-track\" (EOT) meta-event found "
-				"at idx i = " + std::to_string(i) + " and cumulative "
-				"delta-time = " + std::to_string(cumtk) + ".  EOT "
-				"events are only valid as the very last event in an MTrk "
-				"event sequence.  ");
+		} else if (jmid::is_eot(ev) && (i!=(n-1))) {
+			add(errc::eot_not_last,i,cumtk,0,0);
 			return r;
-		} else if (jmid::is_seqn(this->evnts_[i]) && ((cumtk>0) || found_ch_ev)) {
+		} else if (jmid::is_seqn(ev) && ((tkonset>0) || found_ch_ev)) {
 			// Test for illegal sequence-number meta event occuring after 
 			// a midi channel event or at t>0.  
-			r.error = ("Illegal \"Sequence number\" meta-event found "
-				"at idx i = " + std::to_string(i) + " and cumulative "
-				"delta-time = " + std::to_string(cumtk) + ".  Sequence "
-				"number events must occur before any non-zero delta times "
-				"and before any MIDI [channel] events.  ");
+			add(errc::seqn_after_start,i,cumtk,0,0);
 			return r;
 		}
 	}
 
-	// The final event must be a meta-end-of-track msg.  
-	if ((this->evnts_.size()==0) || !jmid::is_eot(this->evnts_.back())) {
-		r.error = "this->evnts_.size()==0 || !is_eot(this->evnts_.back()):  "
-			"The final event in an MTrk event sequence must be an"
-			"\"end-of-track\" meta event.  ";
+	// The final event must be a meta-end-of-track msg.  idx==n, so the 
+	// cumtk is that of end(), ie the duration of the track.  
+	if ((n==0) || !jmid::is_eot(this->evnts_.back())) {
+		add(errc::no_terminal_eot,n,tkonset,0,0);
 		return r;
 	}
 
-	// std::vector<sounding_notes_t> sounding must be empty
-	if (sounding.size() > 0) {
-		r.error = "Orphan note-on events found (sounding.size() > 0):  \n";
-		r.error += "\tidx\tch\tnote\n";
-			for (int i=0; i<sounding.size(); ++i) {
-				r.error += ("\t" + std::to_string(sounding[i].idx));
-				r.error += ("\t" + std::to_string(sounding[i].ch));
-				r.error += ("\t" + std::to_string(sounding[i].note) + "\n");
+	// Since the first off closes the first on, the orphans for a given 
+	// (ch,note) are the last sounding[k] on events; find them w/ a 
+	// backwards scan, then restore the order of the events.  
+	if (n_sounding > 0) {
+		auto orphans_beg = r.diagnostics.size();
+		std::int32_t tk = tkonset;
+		for (std::int32_t i=n-1; (i>=0 && n_sounding>0); --i) {
+			const auto& ev = this->evnts_[i];
+			tk -= ev.delta_time();  // The cumtk of ev
+			if (jmid::is_channel_status_byte(ev.status_byte())) {
+				auto md = jmid::get_channel_event_impl(ev);
+				auto k = 128*(md.ch&0x0Fu) + (md.p1&0x7Fu);
+				if (jmid::is_note_on(md) && (sounding[k] > 0)) {
+					--sounding[k];
+					--n_sounding;
+					r.diagnostics.push_back({errc::orphan_note_on,i,tk,md.ch,md.p1});
+				}
 			}
-		return r;
+		}
+		std::reverse(r.diagnostics.begin()+orphans_beg,r.diagnostics.end());
+		auto max_sz = std::max<std::size_t>(orphans_beg+1,max_diagnostics);
+		if (r.diagnostics.size() > max_sz) {
+			r.diagnostics.resize(max_sz);
+			r.truncated = true;
+		}
 	}
 
 	return r;
 }
+std::string jmid::mtrk_t::validate_t::error() const {
+	std::string s;
+	for (const auto& d : this->diagnostics) {
+		if (jmid::is_error(d.code)) {
+			s += jmid::explain(d);
+			s += "\n";
+		}
+	}
+	return s;
+}
+std::string jmid::mtrk_t::validate_t::warning() const {
+	std::string s;
+	for (const auto& d : this->diagnostics) {
+		if (!jmid::is_error(d.code)) {
+			s += jmid::explain(d);
+			s += "\n";
+		}
+	}
+	return s;
+}
 jmid::mtrk_t::validate_t::operator bool() const {
-	return this->error.size()==0;
+	if (this->truncated) {
+		return false;
+	}
+	return std::none_of(this->diagnostics.begin(),this->diagnostics.end(),
+		[](const jmid::mtrk_diagnostic_t& d)->bool {
+			return jmid::is_error(d.code);
+		});
 }
 
 
@@ -543,6 +929,86 @@ std::string jmid::explain(const jmid::mtrk_error_t& err) {
 	}
 	return s;
 }
+std::string jmid::print(jmid::mtrk_diagnostic_t::errc ec) {
+	std::string s;
+	switch (ec) {
+	case jmid::mtrk_diagnostic_t::errc::multiple_note_on:
+		s = "mtrk_diagnostic_t::errc::multiple_note_on";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::orphan_note_off:
+		s = "mtrk_diagnostic_t::errc::orphan_note_off";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::invalid_status_byte:
+		s = "mtrk_diagnostic_t::errc::invalid_status_byte";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::eot_not_last:
+		s = "mtrk_diagnostic_t::errc::eot_not_last";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::seqn_after_start:
+		s = "mtrk_diagnostic_t::errc::seqn_after_start";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::no_terminal_eot:
+		s = "mtrk_diagnostic_t::errc::no_terminal_eot";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::orphan_note_on:
+		s = "mtrk_diagnostic_t::errc::orphan_note_on";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::other:
+		s = "mtrk_diagnostic_t::errc::other";
+		break;
+	default:
+		s = "mtrk_diagnostic_t::errc::?";
+		break;
+	}
+	return s;
+}
+std::string jmid::explain(const jmid::mtrk_diagnostic_t& d) {
+	auto where = [&d]() -> std::string {
+		return "event " + std::to_string(d.idx) + " (cumulative delta-time "
+			+ std::to_string(d.cumtk) + ")";
+	};
+	auto note = [&d]() -> std::string {
+		return "note " + std::to_string(d.note) + " on channel "
+			+ std::to_string(d.ch);
+	};
+	std::string s;
+	switch (d.code) {
+	case jmid::mtrk_diagnostic_t::errc::multiple_note_on:
+		s = "Multiple on-events found for " + note() + "; " + where() + ".  ";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::orphan_note_off:
+		s = "Orphan note-off event found for " + note() + "; " + where() + ".  ";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::invalid_status_byte:
+		s = "Invalid status byte; " + where() + ".  ";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::eot_not_last:
+		s = "Illegal \"End-of-track\" (EOT) meta-event found at " + where()
+			+ ".  EOT events are only valid as the very last event in an "
+			"MTrk event sequence.  ";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::seqn_after_start:
+		s = "Illegal \"Sequence number\" meta-event found at " + where() 
+			+ ".  Sequence number events must occur before any non-zero "
+			"delta times and before any MIDI [channel] events.  ";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::no_terminal_eot:
+		s = "The final event in an MTrk event sequence must be an "
+			"\"end-of-track\" meta event.  ";
+		break;
+	case jmid::mtrk_diagnostic_t::errc::orphan_note_on:
+		s = "Orphan note-on event found for " + note() + "; " + where() + ".  ";
+		break;
+	default:
+		s = print(d.code) + "; " + where() + ".  ";
+		break;
+	}
+	return s;
+}
+bool jmid::is_error(jmid::mtrk_diagnostic_t::errc ec) {
+	return !((ec==jmid::mtrk_diagnostic_t::errc::multiple_note_on)
+		|| (ec==jmid::mtrk_diagnostic_t::errc::orphan_note_off));
+}
 
 
 
@@ -552,6 +1018,18 @@ jmid::mtrk_t::iterator jmid::get_simultaneous_events(jmid::mtrk_t::iterator beg,
 				jmid::mtrk_t::const_iterator(end));
 	return beg+(it-beg);
 }
+jmid::mtrk_t::const_iterator jmid::get_simultaneous_events(const jmid::mtrk_t& mtrk,
+					jmid::mtrk_t::const_iterator beg) {
+	if (!mtrk.tk_index_current() || (beg==mtrk.end())) {
+		return jmid::get_simultaneous_events(beg,mtrk.end());
+	}
+	// One past the last event w/ the same onset tk as *beg; the onset tk
+	// of event i is tkidx_[i+1].  
+	auto idx = beg-mtrk.begin();
+	auto it = std::upper_bound(mtrk.tkidx_.begin()+idx+2,mtrk.tkidx_.end(),
+		mtrk.tkidx_[idx+1]);
+	return beg + (it-(mtrk.tkidx_.begin()+idx+2)) + 1;
+}
 jmid::mtrk_t::const_iterator jmid::get_simultaneous_events(jmid::mtrk_t::const_iterator beg, 
 					jmid::mtrk_t::const_iterator end) {
 	jmid::mtrk_t::const_iterator range_end = beg;
@@ -585,25 +1063,69 @@ jmid::event_tk_t<jmid::mtrk_t::const_iterator> jmid::find_linked_off(jmid::mtrk_
 std::vector<jmid::linked_onoff_pair_t>
 	jmid::get_linked_onoff_pairs(jmid::mtrk_t::const_iterator beg,
 							jmid::mtrk_t::const_iterator end) {
-	std::vector<jmid::linked_onoff_pair_t> result;
+	return jmid::get_linked_onoff_pairs_and_orphans(beg,end).linked;
+}
+
+jmid::linked_and_orphans_t jmid::get_linked_onoff_pairs_and_orphans(
+							jmid::mtrk_t::const_iterator beg,
+							jmid::mtrk_t::const_iterator end) {
+	jmid::linked_and_orphans_t result;
+	// Each note-on is appended to result.linked w/ off.it==end when it is
+	// encountered, so the pairs are in order of the on events.  For each
+	// (ch,note), the pairs still waiting for an off event form a FIFO 
+	// queue, kept as a singly linked list through next:  head[k], tail[k]
+	// are the indices into result.linked of the first and last pair in
+	// the queue for k==128*ch+note (-1 if empty), and next[i] is the pair
+	// after pair i in its queue.  
+	std::vector<std::int32_t> head(16*128,-1);
+	std::vector<std::int32_t> tail(16*128,-1);
+	std::vector<std::int32_t> next;
 
 	std::int32_t tkonset = 0;
 	for (auto curr=beg; curr!=end; ++curr) {
 		tkonset += curr->delta_time();
-		if (!jmid::is_note_on(*curr)) {
+		if (!jmid::is_channel_status_byte(curr->status_byte())) {
 			continue;
 		}
-
-		auto off = find_linked_off(curr,end,*curr);  // Note:  Not starting @ curr+1
-		if (off.it==end) {  // Orphan on event; not included in the results
+		auto md = jmid::get_channel_event_impl(*curr);
+		bool is_on = jmid::is_note_on(md);
+		if (!is_on && !jmid::is_note_off(md)) {
 			continue;
 		}
-		// Event *curr is the on-event
-		auto cumtk_on = (tkonset - curr->delta_time());
-		auto cumtk_off = cumtk_on + off.tk;
-		result.push_back({{curr,cumtk_on},{off.it,cumtk_off}});
+		auto k = 128*(md.ch&0x0Fu) + (md.p1&0x7Fu);
+		auto cumtk = tkonset - curr->delta_time();
+		if (is_on) {
+			auto i = static_cast<std::int32_t>(result.linked.size());
+			result.linked.push_back({{curr,cumtk},{end,0}});
+			next.push_back(-1);
+			if (tail[k] == -1) {
+				head[k] = i;
+			} else {
+				next[tail[k]] = i;
+			}
+			tail[k] = i;
+		} else if (head[k] == -1) {
+			result.orphan_off.push_back({curr,cumtk});
+		} else {
+			auto i = head[k];
+			result.linked[i].off = {curr,cumtk};
+			head[k] = next[i];
+			if (head[k] == -1) {
+				tail[k] = -1;
+			}
+		}
 	}
 
+	// Move the on events never matched by an off into orphan_on
+	auto it_keep = std::stable_partition(result.linked.begin(),
+		result.linked.end(),
+		[end](const jmid::linked_onoff_pair_t& p)->bool {
+			return p.off.it!=end;
+		});
+	for (auto it=it_keep; it!=result.linked.end(); ++it) {
+		result.orphan_on.push_back(it->on);
+	}
+	result.linked.erase(it_keep,result.linked.end());
 	return result;
 }
 
@@ -656,3 +1178,77 @@ std::string jmid::print_linked_onoff_pairs(const jmid::mtrk_t& mtrk) {
 
 
 
+
+
+std::int32_t jmid::count_mtrk_events(const unsigned char *beg, 
+						const unsigned char *end, unsigned char rs) {
+	std::int32_t n = 0;
+	while (beg < end) {
+		beg = jmid::advance_to_dt_end(beg,end);
+		if (beg == end) {
+			break;
+		}
+		auto s = jmid::get_status_byte(*beg,rs);
+		if (jmid::is_channel_status_byte(s)) {
+			if (jmid::is_status_byte(*beg)) {
+				++beg;
+			}
+			// Don't advance past end if the event is truncated
+			beg += std::min<std::ptrdiff_t>(
+				jmid::channel_status_byte_n_data_bytes(s),end-beg);
+			rs = s;
+			++n;
+		} else if (jmid::is_sysex_or_meta_status_byte(s)) {
+			bool is_eot = false;
+			++beg;
+			if (jmid::is_meta_status_byte(s)) {
+				if (beg == end) {
+					++n;
+					break;
+				}
+				is_eot = (*beg == 0x2Fu);
+				++beg;
+			}
+			auto len = jmid::read_vlq(beg,end);
+			beg = jmid::advance_to_vlq_end(beg,end);
+			if ((end-beg) < len.val) {
+				beg = end;
+			} else {
+				beg += len.val;
+			}
+			rs = 0x00u;
+			++n;
+			if (is_eot) {
+				break;
+			}
+		} else {
+			break;
+		}
+	}
+	return n;
+}
+
+std::int32_t jmid::estimate_n_mtrk_events(std::int32_t nbytes) {
+	if (nbytes <= 0) {
+		return 0;
+	}
+	return std::min(nbytes/3 + 1,jmid::estimate_n_mtrk_events_max);
+}
+
+unsigned char *jmid::write_mtrk(const jmid::mtrk_t& mtrk, unsigned char *dest) {
+	std::array<unsigned char,4> h {0x4Du,0x54u,0x72u,0x6Bu};  // MTrk
+	std::memcpy(dest,h.data(),h.size());
+	auto p_len = dest + 4;
+	dest += 8;
+	auto data_beg = dest;
+	for (const auto& ev : mtrk) {
+		auto n = ev.size();
+		std::memcpy(dest,ev.data(),n);
+		dest += n;
+	}
+	// The length field is filled in after the events have been written so
+	// that the events are only traversed once.  
+	jmid::write_32bit_be(static_cast<std::uint32_t>(dest-data_beg),p_len);
+	return dest;
+}
+
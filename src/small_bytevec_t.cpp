@@ -1,4 +1,5 @@
 #include "small_bytevec_t.h"
+#include "byte_arena_t.h"
 #include <cstdint>
 #include <cstdlib>  // std::abort()
 #include <algorithm>  // std::clamp(), std::max(), std::copy()
@@ -6,13 +7,44 @@
 #include <utility>  // std::move()
 
 
+namespace {
+thread_local jmid::internal::small_bytevec_stats_t stats {};
+// Allocates the buffer for a big_t:  From the arena of the innermost 
+// arena_scope_t on the calling thread, if any, otherwise w/ new [].  
+unsigned char *allocate_big(std::int32_t n, bool *from_arena) {
+	++stats.n_allocs;
+	stats.n_bytes_allocated += n;
+	auto arena = jmid::internal::current_arena();
+	*from_arena = (arena != nullptr);
+	if (arena) {
+		return arena->allocate(n);
+	}
+	return new unsigned char[static_cast<std::uint32_t>(n)];
+}
+// The capacity for a big_t growing from cap to hold at least new_sz bytes
+std::int32_t grow_capacity(std::int32_t cap, std::int32_t new_sz) {
+	if (cap == 0) {
+		return new_sz;
+	}
+	return std::max(new_sz,std::min(2*cap,jmid::internal::big_t::size_max));
+}
+}  // namespace
+
+
+jmid::internal::small_bytevec_stats_t jmid::internal::get_small_bytevec_stats() noexcept {
+	return stats;
+}
+void jmid::internal::reset_small_bytevec_stats() noexcept {
+	stats = jmid::internal::small_bytevec_stats_t();
+}
+
 
 void jmid::internal::small_t::init() noexcept {
 	this->flags_ = 0x80u;
 }
 int32_t jmid::internal::small_t::size() const noexcept {
 	this->abort_if_not_active();
-	return ((this->flags_)&0x7Fu);
+	return ((this->flags_)&small_t::size_mask);
 }
 constexpr std::int32_t jmid::internal::small_t::capacity() const noexcept {
 	return jmid::internal::small_t::size_max;
@@ -20,12 +52,14 @@ constexpr std::int32_t jmid::internal::small_t::capacity() const noexcept {
 std::int32_t jmid::internal::small_t::resize(std::int32_t sz) noexcept {
 	this->abort_if_not_active();
 	sz = std::clamp(sz,0,this->capacity());
-	this->flags_ = (static_cast<unsigned char>(sz)|0x80u);
+	this->flags_ = (static_cast<unsigned char>(sz)|0x80u
+		|(this->flags_&small_t::meta_mask));
 	return this->size();
 }
 std::int32_t jmid::internal::small_t::resize_unchecked(std::int32_t sz) noexcept {
 	this->abort_if_not_active();
-	this->flags_ = (static_cast<unsigned char>(sz)|0x80u);
+	this->flags_ = (static_cast<unsigned char>(sz)|0x80u
+		|(this->flags_&small_t::meta_mask));
 	return this->size();
 }
 void jmid::internal::small_t::abort_if_not_active() const noexcept {
@@ -59,24 +93,38 @@ void jmid::internal::big_t::init() noexcept {
 }
 void jmid::internal::big_t::free_and_reinit() noexcept {
 	this->abort_if_not_active();
-	if (this->p_) {
-		delete [] this->p_;
-	}
+	this->free_buffer();
 	this->init();
 }
 void jmid::internal::big_t::adopt(const big_t::pad_t& pad, 
 							unsigned char *ptr,  std::int32_t sz, 
-							std::int32_t cap) noexcept {
+							std::int32_t cap, bool arena, bool shared) noexcept {
 	this->abort_if_not_active();
 
 	this->pad_ = pad;
-	if (this->p_) {
-		delete [] this->p_;
-	}
+	this->free_buffer();
+	this->flags_ = (arena ? big_t::flag_arena : 0x00u)
+		| (shared ? big_t::flag_shared : 0x00u);
 	this->p_ = ptr;
 	this->sz_ = static_cast<uint32_t>(sz);
 	this->cap_ = static_cast<uint32_t>(cap);
 }
+void jmid::internal::big_t::free_buffer() noexcept {
+	if (this->p_ && !this->is_arena_owned() && !this->is_shared()) {
+		delete [] this->p_;
+	}
+}
+bool jmid::internal::big_t::is_arena_owned() const noexcept {
+	return (this->flags_&big_t::flag_arena)==big_t::flag_arena;
+}
+bool jmid::internal::big_t::is_shared() const noexcept {
+	return (this->flags_&big_t::flag_shared)==big_t::flag_shared;
+}
+void jmid::internal::big_t::unshare() {
+	if (this->is_shared()) {
+		this->reallocate(this->size());
+	}
+}
 std::int32_t jmid::internal::big_t::size() const noexcept {
 	this->abort_if_not_active();
 	return static_cast<std::int32_t>(this->sz_);
@@ -94,33 +142,51 @@ void jmid::internal::big_t::clear() noexcept {
 std::int32_t jmid::internal::big_t::resize(std::int32_t new_sz) {
 	this->abort_if_not_active();
 	new_sz = std::clamp(new_sz,0,big_t::size_max);
-	if (new_sz <= this->capacity()) {
-		this->sz_ = static_cast<std::uint32_t>(new_sz);
-	} else {  // resize to new_size > present capacity
-		auto new_cap = new_sz;
-		// For a freshly init()'d object, p_==nullptr, but sz_==cap_==0
-		unsigned char *pdest = new unsigned char[static_cast<uint32_t>(new_cap)];
-		std::copy(this->begin(),this->end(),pdest);
-		this->adopt(this->pad_,pdest,new_sz,new_cap);  // Frees the current p_
+	if (new_sz > this->capacity()) {
+		this->reallocate(grow_capacity(this->capacity(),new_sz));
+	} else {
+		this->unshare();
 	}
+	this->sz_ = static_cast<std::uint32_t>(new_sz);
 	return this->size();
 }
 std::int32_t jmid::internal::big_t::resize_nocopy(std::int32_t new_sz) {
 	this->abort_if_not_active();
+	if (this->is_shared()) {
+		this->init();  // Drops the reference to the shared buffer
+	}
 	this->clear();
-	return this->resize(new_sz);
+	new_sz = std::clamp(new_sz,0,big_t::size_max);
+	if (new_sz > this->capacity()) {
+		this->reallocate(new_sz);  // size()==0; nothing is copied
+	}
+	this->sz_ = static_cast<std::uint32_t>(new_sz);
+	return this->size();
 }
 std::int32_t jmid::internal::big_t::reserve(std::int32_t new_cap) {
 	this->abort_if_not_active();
 	new_cap = std::clamp(new_cap,this->capacity(),big_t::size_max);
 	if (new_cap > this->capacity()) {
-		// For a freshly init()'d object, p_==nullptr, but sz_==cap_==0
-		unsigned char *pdest = new unsigned char[static_cast<std::uint32_t>(new_cap)];
-		std::copy(this->begin(),this->end(),pdest);
-		this->adopt(this->pad_,pdest,this->size(),new_cap);
+		this->reallocate(new_cap);
+	}
+	return this->capacity();
+}
+std::int32_t jmid::internal::big_t::reserve_exact(std::int32_t new_cap) {
+	this->abort_if_not_active();
+	new_cap = std::clamp(new_cap,this->size(),big_t::size_max);
+	if (new_cap != this->capacity()) {
+		this->reallocate(new_cap);
 	}
 	return this->capacity();
 }
+void jmid::internal::big_t::reallocate(std::int32_t new_cap) {
+	// For a freshly init()'d object, p_==nullptr, but sz_==cap_==0
+	bool from_arena = false;
+	unsigned char *pdest = allocate_big(new_cap,&from_arena);
+	std::copy(this->begin(),this->end(),pdest);
+	stats.n_bytes_copied += this->size();
+	this->adopt(this->pad_,pdest,this->size(),new_cap,from_arena);  // Frees the current p_
+}
 
 void jmid::internal::big_t::abort_if_not_active() const noexcept {
 	if ((this->flags_)&0x80u) {
@@ -172,6 +238,10 @@ jmid::internal::small_bytevec_t::small_bytevec_t(const jmid::internal::small_byt
 		this->init_small();
 		this->u_.s_.resize_unchecked(rhs_sz);
 		std::copy(p_rhs_beg,p_rhs_beg+rhs_sz,this->u_.s_.begin());
+	} else if (rhs.u_.b_.is_shared()) {
+		this->init_big();
+		this->u_.b_.adopt(rhs.u_.b_.pad_,rhs.u_.b_.p_,rhs_sz,
+							rhs.u_.b_.cap_,false,true);
 	} else {
 		this->init_big();
 		this->u_.b_.resize_nocopy(rhs_sz);
@@ -180,6 +250,16 @@ jmid::internal::small_bytevec_t::small_bytevec_t(const jmid::internal::small_byt
 	}
 }
 jmid::internal::small_bytevec_t& jmid::internal::small_bytevec_t::operator=(const jmid::internal::small_bytevec_t& rhs) {
+	if (rhs.is_shared()) {
+		if (this->is_small()) {
+			this->init_big();
+		}
+		// If this and rhs share a buffer (or this==&rhs), adopt() does 
+		// not free it.  
+		this->u_.b_.adopt(rhs.u_.b_.pad_,rhs.u_.b_.p_,rhs.u_.b_.sz_,
+							rhs.u_.b_.cap_,false,true);
+		return *this;
+	}
 	auto rhs_sz = rhs.size();
 	auto p = this->resize_nocopy(rhs_sz);
 	std::copy(rhs.begin(),rhs.begin()+rhs_sz,p);
@@ -196,11 +276,11 @@ jmid::internal::small_bytevec_t::small_bytevec_t(jmid::internal::small_bytevec_t
 	if (rhs.is_big()) {
 		this->init_big();
 		this->u_.b_.adopt(rhs.u_.b_.pad_,rhs.u_.b_.p_,rhs.u_.b_.sz_,
-							rhs.u_.b_.cap_);
+							rhs.u_.b_.cap_,rhs.u_.b_.is_arena_owned(),
+							rhs.u_.b_.is_shared());
 	} else {  // rhs is 'small'
-		this->init_small();
-		this->u_.s_.resize(rhs.u_.s_.size());
-		std::copy(rhs.u_.s_.begin(),rhs.u_.s_.end(),this->u_.s_.begin());
+		// Copies the metadata bits in flags_ along w/ the data
+		this->u_.s_ = rhs.u_.s_;
 	}
 	// Ensures rhs.~small_bytevec_t() will not delete [] the ptr.  Also has 
 	// the effect of setting rhs.size()==0.  
@@ -208,7 +288,7 @@ jmid::internal::small_bytevec_t::small_bytevec_t(jmid::internal::small_bytevec_t
 }
 jmid::internal::small_bytevec_t& jmid::internal::small_bytevec_t::operator=(jmid::internal::small_bytevec_t&& rhs) noexcept {  // Move assign
 	if (this->is_big()) {
-		delete [] this->u_.b_.p_;
+		this->u_.b_.free_buffer();
 	}
 	// In principle i could replace what is below w/
 	// std::memcpy(&(this->u_.raw_[0]),&(rhs.u_.raw_[0]),sizeof(small_t));
@@ -216,11 +296,11 @@ jmid::internal::small_bytevec_t& jmid::internal::small_bytevec_t::operator=(jmid
 	if (rhs.is_big()) {
 		this->init_big();
 		this->u_.b_.adopt(rhs.u_.b_.pad_,rhs.u_.b_.p_,rhs.u_.b_.sz_,
-							rhs.u_.b_.cap_);
+							rhs.u_.b_.cap_,rhs.u_.b_.is_arena_owned(),
+							rhs.u_.b_.is_shared());
 	} else {  // rhs is 'small'
-		this->init_small();
-		this->u_.s_.resize(rhs.u_.s_.size());
-		std::copy(rhs.u_.s_.begin(),rhs.u_.s_.end(),this->u_.s_.begin());
+		// Copies the metadata bits in flags_ along w/ the data
+		this->u_.s_ = rhs.u_.s_;
 	}
 	// Ensures rhs.~small_bytevec_t() will not delete [] the ptr.  Also has 
 	// the effect of setting rhs.size()==0.  
@@ -229,7 +309,7 @@ jmid::internal::small_bytevec_t& jmid::internal::small_bytevec_t::operator=(jmid
 }
 jmid::internal::small_bytevec_t::~small_bytevec_t() noexcept {  // Dtor
 	if (this->is_big()) {
-		delete [] this->u_.b_.p_;
+		this->u_.b_.free_buffer();
 	}
 	this->init_small();
 }
@@ -242,14 +322,43 @@ std::int32_t jmid::internal::small_bytevec_t::reserve(std::int32_t new_cap) {
 	} else {  // present object is small
 		if (new_cap > small_t::size_max) {  // Resize small->big
 			auto sz = this->u_.s_.size();
-			unsigned char *pdest = new unsigned char[static_cast<uint32_t>(new_cap)];
+			bool from_arena = false;
+			unsigned char *pdest = allocate_big(new_cap,&from_arena);
 			std::copy(this->u_.s_.begin(),this->u_.s_.end(),pdest);
+			stats.n_bytes_copied += sz;
 			this->init_big();
-			this->u_.b_.adopt(this->u_.b_.pad_,pdest,sz,new_cap);
+			this->u_.b_.adopt(this->u_.b_.pad_,pdest,sz,new_cap,from_arena);
 		}  // else (new_cap <= small_t::size_max); do nothing
 	}
 	return this->capacity();
 }
+std::int32_t jmid::internal::small_bytevec_t::reserve_exact(std::int32_t new_cap) {
+	new_cap = std::clamp(new_cap,0,jmid::internal::small_bytevec_t::size_max);
+	if (this->is_big()) {
+		return this->u_.b_.reserve_exact(new_cap);
+	}
+	// For a small object, reserve() allocates exactly new_cap
+	return this->reserve(new_cap);
+}
+void jmid::internal::small_bytevec_t::shrink_to_fit() {
+	if (this->is_small() || this->u_.b_.is_arena_owned()
+			|| this->u_.b_.is_shared()) {
+		return;
+	}
+	auto sz = this->u_.b_.size();
+	if (sz > jmid::internal::small_t::size_max) {
+		this->u_.b_.reserve_exact(sz);
+		return;
+	}
+	// big->small transition; copy the data out of the big buffer before 
+	// the small object overwrites the union.  
+	small_t s;
+	s.init();
+	s.resize_unchecked(sz);
+	std::copy(this->u_.b_.begin(),this->u_.b_.end(),s.begin());
+	this->u_.b_.free_buffer();
+	this->u_.s_ = s;
+}
 unsigned char *jmid::internal::small_bytevec_t::resize(std::uint64_t new_sz) {
 	auto sz32 = static_cast<std::int32_t>(std::clamp(new_sz,std::uint64_t(0),
 		static_cast<std::uint64_t>(jmid::internal::small_bytevec_t::size_max)));
@@ -272,10 +381,12 @@ unsigned char *jmid::internal::small_bytevec_t::resize(std::int32_t new_sz) {
 	} else {  // this->is_small()
 		if (new_sz > jmid::internal::small_t::size_max) {
 			auto new_cap = new_sz;
-			unsigned char *pdest = new unsigned char[static_cast<uint32_t>(new_cap)];
+			bool from_arena = false;
+			unsigned char *pdest = allocate_big(new_cap,&from_arena);
 			std::copy(this->u_.s_.begin(),this->u_.s_.end(),pdest);
+			stats.n_bytes_copied += this->u_.s_.size();
 			this->init_big();
-			this->u_.b_.adopt(this->u_.b_.pad_,pdest,new_sz,new_cap);
+			this->u_.b_.adopt(this->u_.b_.pad_,pdest,new_sz,new_cap,from_arena);
 			return this->u_.b_.begin();
 		} else {
 			this->u_.s_.resize(new_sz);
@@ -336,16 +447,40 @@ std::int32_t jmid::internal::small_bytevec_t::capacity() const noexcept {
 }
 
 
+void jmid::internal::small_bytevec_t::intern(jmid::internal::byte_intern_t& store) {
+	if (this->is_small() || this->u_.b_.is_shared()
+			|| (this->u_.b_.size() <= jmid::internal::small_t::size_max)) {
+		return;
+	}
+	auto& b = this->u_.b_;
+	auto p = store.intern(b.begin(),b.end());
+	// The store never writes to p; big_t::is_shared() objects never write
+	// through p_.  
+	b.adopt(b.pad_,const_cast<unsigned char*>(p),b.size(),b.size(),false,true);
+}
+bool jmid::internal::small_bytevec_t::is_shared() const noexcept {
+	return this->is_big() && this->u_.b_.is_shared();
+}
+void jmid::internal::small_bytevec_t::detach_arena() {
+	if (this->is_big() && this->u_.b_.is_arena_owned()) {
+		// adopt() does not free an arena-owned buffer
+		this->u_.b_.reallocate(this->u_.b_.capacity());
+	}
+}
+bool jmid::internal::small_bytevec_t::is_arena_owned() const noexcept {
+	return this->is_big() && this->u_.b_.is_arena_owned();
+}
 bool jmid::internal::small_bytevec_t::debug_is_big() const noexcept {
 	return this->is_big();
 }
 bool jmid::internal::small_bytevec_t::debug_is_small() const noexcept {
 	return this->is_small();
 }
-jmid::internal::small_bytevec_range_t jmid::internal::small_bytevec_t::data_range() noexcept {
+jmid::internal::small_bytevec_range_t jmid::internal::small_bytevec_t::data_range() {
 	if (this->is_small()) {
 		return {this->u_.s_.begin(),this->u_.s_.end()};
 	} else {
+		this->u_.b_.unshare();
 		return {this->u_.b_.begin(),this->u_.b_.end()};
 	}
 }
@@ -372,10 +507,11 @@ jmid::internal::small_bytevec_const_range_t jmid::internal::small_bytevec_t::pad
 			this->u_.b_.pad_.data()+this->u_.b_.pad_.size()};
 	}
 }
-unsigned char *jmid::internal::small_bytevec_t::begin() noexcept {
+unsigned char *jmid::internal::small_bytevec_t::begin() {
 	if (this->is_small()) {
 		return this->u_.s_.begin();
 	} else {
+		this->u_.b_.unshare();
 		return this->u_.b_.begin();
 	}
 }
@@ -386,10 +522,11 @@ const unsigned char *jmid::internal::small_bytevec_t::begin() const noexcept {
 		return this->u_.b_.begin();
 	}
 }
-unsigned char *jmid::internal::small_bytevec_t::end() noexcept {
+unsigned char *jmid::internal::small_bytevec_t::end() {
 	if (this->is_small()) {
 		return this->u_.s_.end();
 	} else {
+		this->u_.b_.unshare();
 		return this->u_.b_.end();
 	}
 }
@@ -412,12 +549,22 @@ unsigned char *jmid::internal::small_bytevec_t::raw_end() noexcept {
 const unsigned char *jmid::internal::small_bytevec_t::raw_end() const noexcept{
 	return &(this->u_.raw_[0]) + this->u_.raw_.size();
 }
-bool jmid::internal::small_bytevec_t::is_big() const noexcept {  // private
+bool jmid::internal::small_bytevec_t::is_big() const noexcept {
 	return !(this->is_small());
 }
-bool jmid::internal::small_bytevec_t::is_small() const noexcept {  // private
+bool jmid::internal::small_bytevec_t::is_small() const noexcept {
 	return ((this->u_.s_.flags_)&0x80u)==0x80u;
 }
+unsigned char jmid::internal::small_bytevec_t::small_meta() const noexcept {
+	return ((this->u_.s_.flags_)&small_t::meta_mask)>>5;
+}
+void jmid::internal::small_bytevec_t::set_small_meta(unsigned char m) noexcept {
+	if (this->is_small()) {
+		auto& f = this->u_.s_.flags_;
+		f = static_cast<unsigned char>((f&(~small_t::meta_mask)) 
+			| ((m&small_bytevec_t::small_meta_max)<<5));
+	}
+}
 
 void jmid::internal::small_bytevec_t::init_small() noexcept {  // Private
 	this->u_.s_.init();
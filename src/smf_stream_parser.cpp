@@ -0,0 +1,379 @@
+#include "smf_stream_parser.h"
+#include "generic_chunk_low_level.h"
+#include "mthd_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "make_mtrk_event.h"
+#include "midi_status_byte.h"
+#include "midi_vlq.h"
+#include <vector>
+#include <algorithm>
+#include <utility>  // std::move()
+#include <cstdint>
+#include <cstddef>  // std::size_t
+
+
+namespace {
+
+//
+// Returns the size in bytes of the mtrk event beginning at beg if this can
+// be determined from the bytes on [beg,end) (the result may be larger than
+// end-beg), 0 if more bytes are needed to determine the size, or -1 if the
+// bytes on [beg,end) already make the event invalid.  In the latter case,
+// make_mtrk_event3() reports the same error for [beg,end) as for any 
+// longer input beginning w/ the same bytes.  
+//
+std::int64_t event_nbytes(const unsigned char *beg, const unsigned char *end,
+							unsigned char rs) {
+	auto p = beg;
+	for (int i=1; true; ++i) {  // Delta time
+		if (p==end) {
+			return 0;
+		}
+		if (!((*p++)&0x80u)) {
+			break;
+		}
+		if (i==4) {
+			return -1;
+		}
+	}
+	if (p==end) {
+		return 0;
+	}
+	auto last = *p++;
+	auto s = jmid::get_status_byte(last,rs);
+	if (jmid::is_channel_status_byte(s)) {
+		auto n = jmid::channel_status_byte_n_data_bytes(s);
+		return (p-beg) + n - (jmid::is_data_byte(last) ? 1 : 0);
+	} else if (jmid::is_meta_status_byte(s)) {
+		if (p==end) {
+			return 0;
+		}
+		if (!jmid::is_meta_type_byte(*p++)) {
+			return -1;
+		}
+	} else if (!jmid::is_sysex_status_byte(s)) {
+		return -1;
+	}
+	std::uint32_t len = 0;  // The vlq length field of a meta or sysex event
+	for (int i=1; true; ++i) {
+		if (p==end) {
+			return 0;
+		}
+		auto b = *p++;
+		len = (len<<7) + (b&0x7Fu);
+		if (!(b&0x80u)) {
+			break;
+		}
+		if (i==4) {
+			return -1;
+		}
+	}
+	if (len > 1000000) {  // See make_mtrk_event3()
+		return -1;
+	}
+	return (p-beg) + len;
+}
+
+}  // namespace
+
+
+jmid::smf_stream_parser_t::smf_stream_parser_t(jmid::smf_stream_callbacks_t cbs)
+		: cbs_(std::move(cbs)) {
+	this->reset();
+}
+
+void jmid::smf_stream_parser_t::reset() {
+	this->buf_.clear();
+	this->err_.code = jmid::smf_error_t::errc::no_error;
+	this->err_.mthd_err_obj.code = jmid::mthd_error_t::errc::no_error;
+	this->err_.mtrk_err_obj.code = jmid::mtrk_error_t::errc::no_error;
+	this->err_.expect_num_mtrks = 0;
+	this->err_.num_mtrks_read = 0;
+	this->err_.num_uchks_read = 0;
+	this->nbytes_read_ = 0;
+	this->uchk_nbytes_remain_ = 0;
+	this->expect_ntrks_ = 0;
+	this->n_mtrks_read_ = 0;
+	this->n_uchks_read_ = 0;
+	this->rs_ = 0x00u;
+	this->state_ = state_t::mthd;
+}
+
+bool jmid::smf_stream_parser_t::feed(const char *p, std::size_t n) {
+	return this->feed(reinterpret_cast<const unsigned char*>(p),n);
+}
+
+bool jmid::smf_stream_parser_t::feed(const unsigned char *p, std::size_t n) {
+	auto beg = p;
+	auto end = p+n;
+	while ((p!=end) && (this->state_!=state_t::done) 
+			&& (this->state_!=state_t::error)) {
+		if (this->state_ == state_t::mtrk) {
+			p = this->feed_mtrk(p,end);
+		} else if (this->state_ == state_t::chunk_header) {
+			p = this->feed_chunk_header(p,end);
+		} else if (this->state_ == state_t::uchk) {
+			p = this->feed_uchk(p,end);
+		} else if (this->state_ == state_t::mthd) {
+			p = this->feed_mthd(p,end);
+		}
+	}
+	this->nbytes_read_ += (p-beg);
+	return (this->state_ != state_t::error);
+}
+
+bool jmid::smf_stream_parser_t::finish() {
+	if (this->state_ == state_t::mthd) {
+		// make_mthd2() reports the same error for the partial MThd as 
+		// make_smf2() would for the truncated file
+		jmid::mthd_error_t mthd_err;
+		jmid::make_mthd2(this->buf_.data(),this->buf_.data()+this->buf_.size(),
+			&(this->mthd_),&mthd_err);
+		this->err_.mthd_err_obj = mthd_err;
+		this->set_error(jmid::smf_error_t::errc::mthd_error,0,0,0);
+	} else if (this->state_ == state_t::chunk_header) {
+		if (this->buf_.empty()) {
+			this->set_error(jmid::smf_error_t::errc::unexpected_num_mtrks,
+				this->expect_ntrks_,this->n_mtrks_read_,this->n_uchks_read_);
+		} else {
+			this->set_error(jmid::smf_error_t::errc::other,0,0,0);
+		}
+	} else if (this->state_ == state_t::mtrk) {
+		this->err_.mtrk_err_obj.rs = this->rs_;
+		this->err_.mtrk_err_obj.code = jmid::mtrk_error_t::errc::no_eot_event;
+		if (!this->buf_.empty()) {
+			this->read_event(this->buf_.data(),this->buf_.data()+this->buf_.size());
+		}
+		this->set_error(jmid::smf_error_t::errc::mtrk_error,
+			this->expect_ntrks_,this->n_mtrks_read_,this->n_uchks_read_);
+	} else if (this->state_ == state_t::uchk) {
+		this->set_error(jmid::smf_error_t::errc::overflow_reading_uchk,
+			this->expect_ntrks_,this->n_mtrks_read_,this->n_uchks_read_);
+	}
+	this->buf_.clear();
+	return (this->state_ == state_t::done);
+}
+
+bool jmid::smf_stream_parser_t::is_done() const {
+	return (this->state_ == state_t::done);
+}
+bool jmid::smf_stream_parser_t::is_error() const {
+	return (this->state_ == state_t::error);
+}
+const jmid::smf_error_t& jmid::smf_stream_parser_t::error() const {
+	return this->err_;
+}
+std::int64_t jmid::smf_stream_parser_t::nbytes_read() const {
+	return this->nbytes_read_;
+}
+std::int32_t jmid::smf_stream_parser_t::nmtrks_read() const {
+	return this->n_mtrks_read_;
+}
+std::int32_t jmid::smf_stream_parser_t::nuchks_read() const {
+	return this->n_uchks_read_;
+}
+
+void jmid::smf_stream_parser_t::set_error(jmid::smf_error_t::errc ec, 
+					int expect_ntrks, int n_mtrks_read, int n_uchks_read) {
+	this->err_.code = ec;
+	this->err_.expect_num_mtrks = expect_ntrks;
+	this->err_.num_mtrks_read = n_mtrks_read;
+	this->err_.num_uchks_read = n_uchks_read;
+	if (ec == jmid::smf_error_t::errc::no_error) {
+		this->state_ = state_t::done;
+	} else {
+		this->state_ = state_t::error;
+	}
+}
+
+const unsigned char *jmid::smf_stream_parser_t::feed_mthd(
+					const unsigned char *p, const unsigned char *end) {
+	// The MThd is accumulated in buf_ and passed to make_mthd2() once the
+	// header (8 bytes), standard data section (6 bytes), and the full data
+	// section (length bytes) are present, and thereafter once per call 
+	// until make_mthd2() succeeds.  Since make_mthd2() checks the id and 
+	// length as soon as the header is available, the length is known to be
+	// valid by the time it is used to compute the target size.  Any bytes 
+	// beyond the end of the MThd (as determined by make_mthd2()) are 
+	// returned to the input.  
+	std::size_t target = 8;
+	if (this->buf_.size() >= 14) {
+		target = 8 + jmid::read_be<std::uint32_t>(this->buf_.data()+4,
+			this->buf_.data()+8);
+		if (target <= this->buf_.size()) {
+			target = this->buf_.size() + (end-p);
+		}
+	} else if (this->buf_.size() >= 8) {
+		target = 14;
+	}
+	auto n = std::min(static_cast<std::size_t>(end-p),target-this->buf_.size());
+	this->buf_.insert(this->buf_.end(),p,p+n);
+	p += n;
+	if (this->buf_.size() < target) {
+		return p;
+	}
+
+	jmid::mthd_error_t mthd_err;
+	auto it = jmid::make_mthd2(this->buf_.data(),
+		this->buf_.data()+this->buf_.size(),&(this->mthd_),&mthd_err);
+	if (mthd_err.code == jmid::mthd_error_t::errc::overflow_in_data_section) {
+		return p;  // Valid so far; more data needed
+	}
+	p -= (this->buf_.data()+this->buf_.size()) - it;
+	this->buf_.clear();
+	this->err_.mthd_err_obj = mthd_err;
+	if (mthd_err.code != jmid::mthd_error_t::errc::no_error) {
+		this->set_error(jmid::smf_error_t::errc::mthd_error,0,0,0);
+		return p;
+	}
+	if (this->cbs_.on_mthd) {
+		this->cbs_.on_mthd(this->mthd_);
+	}
+	this->expect_ntrks_ = this->mthd_.ntrks();
+	this->state_ = state_t::chunk_header;
+	if (this->expect_ntrks_ == 0) {
+		this->set_error(jmid::smf_error_t::errc::no_error,0,0,0);
+	}
+	return p;
+}
+
+const unsigned char *jmid::smf_stream_parser_t::feed_chunk_header(
+					const unsigned char *p, const unsigned char *end) {
+	auto n = std::min(static_cast<std::size_t>(end-p),8-this->buf_.size());
+	this->buf_.insert(this->buf_.end(),p,p+n);
+	p += n;
+	if (this->buf_.size() < 8) {
+		return p;
+	}
+
+	jmid::chunk_header_error_t chk_header_err;
+	jmid::read_chunk_header(this->buf_.data(),this->buf_.data()+8,
+		&(this->curr_chk_header_),&chk_header_err);
+	this->buf_.clear();
+	const auto& h = this->curr_chk_header_;
+	if (jmid::has_mtrk_id(h) && jmid::has_valid_length(h)) {
+		this->rs_ = 0x00u;
+		this->state_ = state_t::mtrk;
+	} else if (jmid::has_uchk_id(h) && jmid::has_valid_length(h)) {
+		this->uchk_nbytes_remain_ = h.length;
+		this->state_ = state_t::uchk;
+	} else {  // Non-MTrk, non-UChk header field
+		this->set_error(jmid::smf_error_t::errc::other,this->expect_ntrks_,
+			this->n_mtrks_read_,this->n_uchks_read_);
+		return p;
+	}
+	if (this->cbs_.on_chunk_begin) {
+		this->cbs_.on_chunk_begin(h);
+	}
+	if ((this->state_ == state_t::uchk) && (this->uchk_nbytes_remain_ == 0)) {
+		this->end_chunk();
+	}
+	return p;
+}
+
+const unsigned char *jmid::smf_stream_parser_t::feed_mtrk(
+					const unsigned char *p, const unsigned char *end) {
+	if (this->buf_.empty()) {
+		// Events lying entirely within [p,end) are parsed in place
+		while ((p!=end) && (this->state_==state_t::mtrk)) {
+			auto sz = event_nbytes(p,end,this->rs_);
+			if ((sz == 0) || (sz > (end-p))) {
+				break;
+			}
+			auto next = p + (sz > 0 ? sz : (end-p));
+			if (!this->read_event(p,next)) {
+				return next;
+			}
+			p = next;
+		}
+		if (this->state_ == state_t::mtrk) {
+			// The event is split across fragments
+			this->buf_.insert(this->buf_.end(),p,end);
+			p = end;
+		}
+		return p;
+	}
+
+	// Top up buf_ w/ only as many bytes as the event in progress needs; the
+	// header fields are added one byte at a time until the size is known.  
+	std::int64_t sz = 0;
+	while (p!=end) {
+		sz = event_nbytes(this->buf_.data(),this->buf_.data()+this->buf_.size(),
+			this->rs_);
+		if (sz != 0) {
+			break;
+		}
+		this->buf_.push_back(*p++);
+	}
+	if (sz == 0) {
+		sz = event_nbytes(this->buf_.data(),this->buf_.data()+this->buf_.size(),
+			this->rs_);
+	}
+	if (sz > 0) {
+		auto n = std::min(static_cast<std::int64_t>(end-p),
+			sz-static_cast<std::int64_t>(this->buf_.size()));
+		this->buf_.insert(this->buf_.end(),p,p+n);
+		p += n;
+	}
+	if ((sz < 0) 
+			|| ((sz > 0) && (this->buf_.size() == static_cast<std::size_t>(sz)))) {
+		this->read_event(this->buf_.data(),this->buf_.data()+this->buf_.size());
+		this->buf_.clear();
+	}
+	return p;
+}
+
+bool jmid::smf_stream_parser_t::read_event(const unsigned char *beg,
+					const unsigned char *end) {
+	jmid::mtrk_event_error_t ev_err;
+	jmid::make_mtrk_event3(beg,end,this->rs_,&(this->ev_),&ev_err);
+	if (ev_err.code != jmid::mtrk_event_error_t::errc::no_error) {
+		this->err_.mtrk_err_obj.event_error = ev_err;
+		this->err_.mtrk_err_obj.rs = this->rs_;
+		this->err_.mtrk_err_obj.code = jmid::mtrk_error_t::errc::invalid_event;
+		this->set_error(jmid::smf_error_t::errc::mtrk_error,
+			this->expect_ntrks_,this->n_mtrks_read_,this->n_uchks_read_);
+		return false;
+	}
+	this->rs_ = this->ev_.running_status();
+	if (this->cbs_.on_mtrk_event) {
+		this->cbs_.on_mtrk_event(this->ev_);
+	}
+	if (jmid::is_eot(this->ev_)) {
+		this->end_chunk();
+	}
+	return true;
+}
+
+const unsigned char *jmid::smf_stream_parser_t::feed_uchk(
+					const unsigned char *p, const unsigned char *end) {
+	auto n = static_cast<std::uint32_t>(std::min(static_cast<std::size_t>(end-p),
+		static_cast<std::size_t>(this->uchk_nbytes_remain_)));
+	if (this->cbs_.on_uchk_data) {
+		this->cbs_.on_uchk_data(p,p+n);
+	}
+	this->uchk_nbytes_remain_ -= n;
+	p += n;
+	if (this->uchk_nbytes_remain_ == 0) {
+		this->end_chunk();
+	}
+	return p;
+}
+
+void jmid::smf_stream_parser_t::end_chunk() {
+	if (this->state_ == state_t::mtrk) {
+		++(this->n_mtrks_read_);
+	} else {
+		++(this->n_uchks_read_);
+	}
+	if (this->cbs_.on_chunk_end) {
+		this->cbs_.on_chunk_end(this->curr_chk_header_);
+	}
+	this->state_ = state_t::chunk_header;
+	if (this->n_mtrks_read_ == this->expect_ntrks_) {
+		this->set_error(jmid::smf_error_t::errc::no_error,this->expect_ntrks_,
+			this->n_mtrks_read_,this->n_uchks_read_);
+	}
+}
+
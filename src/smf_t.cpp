@@ -1,13 +1,15 @@
 #include "smf_t.h"
 #include "mthd_t.h"
 #include "mtrk_t.h"
+#include "smf_view_t.h"  // read_mtrk_event_view() in validate_smf()
 #include "midi_vlq.h"
 #include "midi_status_byte.h"
 #include "print_hexascii.h"
+#include "util.h"
 #include <string>
 #include <cstdint>
 #include <vector>
-#include <algorithm>  // std::copy() in smf_t::smf_t(const validate_smf_result_t& maybe_smf)
+#include <algorithm>  // std::copy(), std::push_heap(), std::stable_sort()
 #include <iomanip>  // std::setw()
 #include <ios>  // std::left
 #include <sstream>
@@ -15,6 +17,11 @@
 #include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <thread>
+#include <utility>  // std::move()
+#include <atomic>
+#include <exception>  // std::exception_ptr
+#include <cstring>  // std::memcpy() in write_smf()
 
 
 jmid::smf_t::smf_t() noexcept {
@@ -25,18 +32,24 @@ jmid::smf_t::smf_t(const jmid::smf_t& rhs) {
 	this->mtrks_ = rhs.mtrks_;
 	this->uchks_ = rhs.uchks_;
 	this->chunkorder_ = rhs.chunkorder_;
+	this->arena_enabled_ = rhs.arena_enabled_;
+	this->intern_store_ = rhs.intern_store_;
 }
 jmid::smf_t::smf_t(jmid::smf_t&& rhs) noexcept {
 	this->mthd_ = std::move(rhs.mthd_);
 	this->mtrks_ = std::move(rhs.mtrks_);
 	this->uchks_ = std::move(rhs.uchks_);
 	this->chunkorder_ = std::move(rhs.chunkorder_);
+	this->arena_enabled_ = rhs.arena_enabled_;
+	this->intern_store_ = rhs.intern_store_;
 }
 jmid::smf_t& jmid::smf_t::operator=(const jmid::smf_t& rhs) {
 	this->mthd_ = rhs.mthd_;
 	this->mtrks_ = rhs.mtrks_;
 	this->uchks_ = rhs.uchks_;
 	this->chunkorder_ = rhs.chunkorder_;
+	this->arena_enabled_ = rhs.arena_enabled_;
+	this->intern_store_ = rhs.intern_store_;
 	return *this;
 }
 jmid::smf_t& jmid::smf_t::operator=(jmid::smf_t&& rhs) noexcept {
@@ -44,6 +57,8 @@ jmid::smf_t& jmid::smf_t::operator=(jmid::smf_t&& rhs) noexcept {
 	this->mtrks_ = std::move(rhs.mtrks_);
 	this->uchks_ = std::move(rhs.uchks_);
 	this->chunkorder_ = std::move(rhs.chunkorder_);
+	this->arena_enabled_ = rhs.arena_enabled_;
+	this->intern_store_ = rhs.intern_store_;
 	return *this;
 }
 jmid::smf_t::~smf_t() noexcept {
@@ -116,6 +131,19 @@ jmid::smf_t::reference jmid::smf_t::push_back(jmid::mtrk_t&& mtrk) {
 	this->mthd_.set_ntrks(this->mtrks_.size());
 	return this->mtrks_.back();
 }
+jmid::smf_t::reference jmid::smf_t::emplace_back() {
+	this->mtrks_.emplace_back();
+	this->chunkorder_.push_back(0);
+	this->mthd_.set_ntrks(this->mtrks_.size());
+	return this->mtrks_.back();
+}
+jmid::smf_t::iterator jmid::smf_t::insert(jmid::smf_t::iterator it, jmid::mtrk_t&& mtrk) {
+	auto n = it-this->begin();
+	this->mtrks_.insert((this->mtrks_.begin()+n),std::move(mtrk));
+	this->chunkorder_.insert((this->chunkorder_.begin()+n),0);
+	this->mthd_.set_ntrks(this->mtrks_.size());
+	return this->begin()+n;
+}
 jmid::smf_t::iterator jmid::smf_t::insert(jmid::smf_t::iterator it, jmid::smf_t::const_reference mtrk) {
 	auto n = it-this->begin();
 	this->mtrks_.insert((this->mtrks_.begin()+n),mtrk);
@@ -149,6 +177,11 @@ const jmid::smf_t::uchk_value_type& jmid::smf_t::push_back(const jmid::smf_t::uc
 	this->chunkorder_.push_back(1);
 	return this->uchks_.back();
 }
+const jmid::smf_t::uchk_value_type& jmid::smf_t::push_back(jmid::smf_t::uchk_value_type&& uchk) {
+	this->uchks_.push_back(std::move(uchk));
+	this->chunkorder_.push_back(1);
+	return this->uchks_.back();
+}
 jmid::smf_t::uchk_iterator jmid::smf_t::insert(jmid::smf_t::uchk_iterator it,
 				const jmid::smf_t::uchk_value_type& uchk) {
 	auto n = it-this->uchks_.begin();
@@ -216,8 +249,22 @@ void jmid::smf_t::set_mthd(jmid::mthd_t&& mthd) noexcept {
 	this->mthd_ = std::move(mthd);
 	this->mthd_.set_ntrks(this->mtrks_.size());
 }
+void jmid::smf_t::set_arena_enabled(bool enable) {
+	this->arena_enabled_ = enable;
+	for (auto& trk : this->mtrks_) {
+		trk.set_arena_enabled(enable);
+	}
+}
+bool jmid::smf_t::arena_enabled() const {
+	return this->arena_enabled_;
+}
+void jmid::smf_t::set_intern_store(jmid::internal::byte_intern_t *store) {
+	this->intern_store_ = store;
+}
+jmid::internal::byte_intern_t *jmid::smf_t::intern_store() const {
+	return this->intern_store_;
+}
 
-// TODO:  The call to nbytes() is v. expensive
 std::string jmid::print(const jmid::smf_t& smf) {
 	std::string s {};
 	s.reserve(20*smf.size());  // TODO: Magic constant 20
@@ -338,6 +385,264 @@ jmid::maybe_smf_t jmid::read_smf_bulkfileread(const std::filesystem::path& fp,
 	return result;
 }
 
+jmid::maybe_smf_t jmid::read_smf_mmap(const std::filesystem::path& fp, 
+					jmid::smf_error_t *err) {
+	jmid::maybe_smf_t result;
+	result.nbytes_read = 0;
+	result.error = jmid::smf_error_t::errc::no_error;
+	jmid::read_only_mapped_file_t fmap(fp);
+	if (!fmap.is_open()) {
+		result.error = jmid::smf_error_t::errc::file_read_error;
+		if (err) {
+			err->code = jmid::smf_error_t::errc::file_read_error;
+		}
+		return result;
+	}
+
+	const unsigned char *it = fmap.begin();
+	const unsigned char *end = fmap.end();
+	auto p_result = &(result.smf);
+	smf_error_t local_err_obj;
+	auto it_end = jmid::make_smf2(it,end,p_result,&local_err_obj);
+	result.nbytes_read = it_end-it;
+	if (err!=nullptr) {
+		*err = local_err_obj;
+	}
+	result.error = local_err_obj.code;
+	return result;
+}
+
+const unsigned char *jmid::make_smf2_parallel(const unsigned char *it, 
+				const unsigned char *end, jmid::smf_t *result, 
+				jmid::smf_error_t *err, int nthreads) {
+	const unsigned char *beg = it;
+	auto serial = [&]()->const unsigned char* {
+		return jmid::make_smf2(beg,end,result,err);
+	};
+
+	jmid::mthd_error_t mthd_err;
+	it = jmid::make_mthd2(it,end,&(result->mthd_),&mthd_err);
+	if (mthd_err.code != mthd_error_t::errc::no_error) {
+		return serial();
+	}
+
+	// Pass 1:  The chunk headers
+	struct mtrk_span_t {
+		const unsigned char *beg;  // First byte following the header
+		const unsigned char *end;
+	};
+	std::vector<mtrk_span_t> mtrk_spans;
+	auto expect_ntrks = result->mthd_.ntrks();
+	mtrk_spans.reserve(expect_ntrks);
+	int n_uchks_read = 0;
+	result->chunkorder_.resize(0);
+	while ((it!=end) && (static_cast<int>(mtrk_spans.size())<expect_ntrks)) {
+		jmid::chunk_header_t curr_chk_header;
+		jmid::chunk_header_error_t curr_chk_header_err;
+		it = jmid::read_chunk_header(it,end,&curr_chk_header,
+			&curr_chk_header_err);
+		if ((curr_chk_header_err.code != jmid::chunk_header_error_t::errc::no_error)
+				|| !jmid::has_valid_length(curr_chk_header)
+				|| (curr_chk_header.length > (end-it))) {
+			return serial();
+		}
+		auto chk_end = it + curr_chk_header.length;
+		if (jmid::has_mtrk_id(curr_chk_header)) {
+			mtrk_spans.push_back({it,chk_end});
+			result->chunkorder_.push_back(0);
+		} else if (jmid::has_uchk_id(curr_chk_header)) {
+			if (result->uchks_.size() == static_cast<std::size_t>(n_uchks_read)) {
+				result->uchks_.resize(result->uchks_.size()+1);
+			}
+			result->uchks_[n_uchks_read].assign(it,chk_end);
+			result->chunkorder_.push_back(1);
+			++n_uchks_read;
+		} else {
+			return serial();
+		}
+		it = chk_end;
+	}
+	if (static_cast<int>(mtrk_spans.size()) != expect_ntrks) {
+		return serial();
+	}
+	result->uchks_.resize(n_uchks_read);
+
+	// Pass 2:  The MTrks
+	auto n_mtrks = static_cast<int>(mtrk_spans.size());
+	result->mtrks_.resize(n_mtrks);
+	std::atomic<int> next_mtrk {0};
+	std::atomic<bool> failed {false};
+	// The intern store is thread-local (see intern_scope_t), so the one in
+	// effect here is installed on each worker.  
+	auto store = result->intern_store_ ? result->intern_store_ 
+		: jmid::internal::current_intern_store();
+	// An exception escaping a std::thread would call std::terminate();
+	// each worker stores its own, which is rethrown on the calling thread
+	// once all the workers have been joined.  
+	std::vector<std::exception_ptr> worker_excs;
+	auto worker = [&](int w)->void {
+		jmid::internal::intern_scope_t intern_scope(store);
+		try {
+			int i = 0;
+			while ((i = next_mtrk++) < n_mtrks) {
+				if (failed) {
+					return;
+				}
+				auto p_curr_mtrk = result->mtrks_.data() + i;
+				p_curr_mtrk->set_arena_enabled(result->arena_enabled_);
+				jmid::mtrk_error_t curr_mtrk_error;
+				auto mtrk_end = jmid::make_mtrk_event_seq(mtrk_spans[i].beg,
+					mtrk_spans[i].end,0x00u,p_curr_mtrk,&curr_mtrk_error);
+				if ((curr_mtrk_error.code != jmid::mtrk_error_t::errc::no_error)
+						|| (mtrk_end != mtrk_spans[i].end)) {
+					failed = true;
+					return;
+				}
+			}
+		} catch (...) {
+			worker_excs[w] = std::current_exception();
+			failed = true;
+		}
+	};
+
+	if (nthreads <= 0) {
+		nthreads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	nthreads = std::max(1,std::min(nthreads,n_mtrks));
+	worker_excs.resize(nthreads);
+	std::vector<std::thread> threads;
+	threads.reserve(nthreads-1);
+	try {
+		for (int i=1; i<nthreads; ++i) {
+			threads.emplace_back(worker,i);
+		}
+	} catch (...) {
+		// A std::thread destroyed while joinable calls std::terminate(), so
+		// the workers already started are stopped and joined before 
+		// rethrowing.  
+		failed = true;
+		for (auto& t : threads) {
+			t.join();
+		}
+		throw;
+	}
+	worker(0);
+	for (auto& t : threads) {
+		t.join();
+	}
+	for (const auto& e : worker_excs) {
+		if (e) {
+			std::rethrow_exception(e);
+		}
+	}
+	if (failed) {
+		return serial();
+	}
+
+	if (err!=nullptr) {
+		err->code = smf_error_t::errc::no_error;
+		err->num_mtrks_read = n_mtrks;
+		err->num_uchks_read = n_uchks_read;
+		err->expect_num_mtrks = expect_ntrks;
+	}
+	return it;
+}
+
+const unsigned char *jmid::validate_smf(const unsigned char *it, 
+				const unsigned char *end, jmid::smf_error_t *err) {
+	auto set_error = [&err](smf_error_t::errc ec, int expect_ntrks, 
+						int n_mtrks_read, int n_uchks_read)->void {
+		if (err!=nullptr) {
+			err->code = ec;
+			err->num_mtrks_read = n_mtrks_read;
+			err->num_uchks_read = n_uchks_read;
+			err->expect_num_mtrks = expect_ntrks;
+		}
+	};
+
+	jmid::mthd_t mthd;
+	jmid::mthd_error_t mthd_err;
+	it = jmid::make_mthd2(it,end,&mthd,&mthd_err);
+	if (err!=nullptr) {
+		err->mthd_err_obj = mthd_err;
+	}
+	if (mthd_err.code != mthd_error_t::errc::no_error) {
+		set_error(smf_error_t::errc::mthd_error,0,0,0);
+		return it;
+	}
+
+	auto expect_ntrks = mthd.ntrks();
+	int n_mtrks_read = 0;
+	int n_uchks_read = 0;
+	while ((it!=end) && (n_mtrks_read<expect_ntrks)) {
+		jmid::chunk_header_t curr_chk_header;
+		jmid::chunk_header_error_t curr_chk_header_err;
+		it = jmid::read_chunk_header(it,end,&curr_chk_header,
+			&curr_chk_header_err);
+		if (curr_chk_header_err.code != jmid::chunk_header_error_t::errc::no_error) {
+			set_error(smf_error_t::errc::other,0,0,0);
+			return it;
+		}
+
+		if (jmid::has_mtrk_id(curr_chk_header) 
+				&& jmid::has_valid_length(curr_chk_header)) {
+			// As w/ make_mtrk_event_seq(), the length field is ignored and
+			// events are read until an EOT is encountered.  
+			unsigned char rs = 0x00u;
+			bool found_eot = false;
+			jmid::mtrk_event_view_t ev;
+			jmid::mtrk_event_error_t ev_err;
+			while ((it!=end) && (!found_eot)) {
+				it = jmid::read_mtrk_event_view(it,end,rs,&ev,&ev_err);
+				if (ev_err.code != jmid::mtrk_event_error_t::errc::no_error) {
+					break;
+				}
+				found_eot = jmid::is_eot(ev);
+				rs = ev.running_status();
+			}
+			if (!found_eot) {
+				if (err!=nullptr) {
+					err->mtrk_err_obj.rs = rs;
+					err->mtrk_err_obj.event_error = ev_err;
+					err->mtrk_err_obj.code = 
+						(ev_err.code != jmid::mtrk_event_error_t::errc::no_error)
+						? jmid::mtrk_error_t::errc::invalid_event
+						: jmid::mtrk_error_t::errc::no_eot_event;
+				}
+				set_error(smf_error_t::errc::mtrk_error,expect_ntrks,
+					n_mtrks_read,n_uchks_read);
+				return it;
+			}
+			++n_mtrks_read;
+		} else if (jmid::has_uchk_id(curr_chk_header) 
+				&& jmid::has_valid_length(curr_chk_header)) {
+			auto len = static_cast<std::ptrdiff_t>(curr_chk_header.length);
+			if (len > (end-it)) {
+				// Invalid UChk
+				set_error(smf_error_t::errc::overflow_reading_uchk,
+							expect_ntrks,n_mtrks_read,n_uchks_read);
+				return end;
+			}
+			it += len;
+			++n_uchks_read;
+		} else {  // Non-MTrk, non-UChk header field
+			set_error(smf_error_t::errc::other,expect_ntrks,n_mtrks_read,
+					n_uchks_read);
+			return it;
+		}
+	}  // To next chunk
+
+	if (n_mtrks_read != expect_ntrks) {
+		set_error(smf_error_t::errc::unexpected_num_mtrks,
+				expect_ntrks,n_mtrks_read,n_uchks_read);
+		return it;
+	}
+	
+	set_error(smf_error_t::errc::no_error,expect_ntrks,n_mtrks_read,
+				n_uchks_read);
+	return it;
+}
+
 std::string jmid::print(jmid::smf_error_t::errc ec) {
 	std::string s;
 	switch (ec) {
@@ -416,10 +721,37 @@ std::string jmid::explain(const jmid::smf_error_t& err) {
 }
 
 
-std::filesystem::path jmid::write_smf(const jmid::smf_t& smf, const std::filesystem::path& p) {
+unsigned char *jmid::write_smf(const jmid::smf_t& smf, unsigned char *dest) {
+	const auto& mthd = smf.mthd();
+	std::memcpy(dest,mthd.data(),mthd.nbytes());
+	dest += mthd.nbytes();
+	for (const auto& trk : smf) {
+		dest = jmid::write_mtrk(trk,dest);
+	}
+	return dest;
+}
+
+std::int64_t jmid::write_smf_nbytes(const jmid::smf_t& smf) {
+	std::int64_t n = smf.mthd().nbytes();
+	for (const auto& trk : smf) {
+		n += trk.nbytes();
+	}
+	return n;
+}
+
+std::filesystem::path jmid::write_smf(const jmid::smf_t& smf, 
+						const std::filesystem::path& p) {
+	std::vector<unsigned char> buf;
+	return jmid::write_smf(smf,p,&buf);
+}
+
+std::filesystem::path jmid::write_smf(const jmid::smf_t& smf, 
+						const std::filesystem::path& p,
+						std::vector<unsigned char> *buf) {
+	buf->resize(jmid::write_smf_nbytes(smf));
+	auto end = jmid::write_smf(smf,buf->data());
 	std::basic_ofstream<char> fsout(p,std::ios::out|std::ios::binary);
-	std::ostreambuf_iterator<char> it(fsout);
-	jmid::write_smf(smf,it);
+	fsout.write(reinterpret_cast<const char*>(buf->data()),end-buf->data());
 	fsout.close();
 	return p;
 }
@@ -443,19 +775,151 @@ bool jmid::has_midifile_extension(const std::filesystem::path& fp) {
 
 
 
+jmid::smf_chrono_iterator_t::smf_chrono_iterator_t(const jmid::smf_t& smf) {
+	this->heap_.reserve(smf.ntrks());
+	for (std::int32_t i=0; i<smf.ntrks(); ++i) {
+		const auto& trk = smf[i];
+		if (trk.size() > 0) {
+			this->heap_.push_back({trk.begin(),trk.end(),
+				trk.begin()->delta_time(),i});
+		}
+	}
+	std::make_heap(this->heap_.begin(),this->heap_.end(),
+		jmid::smf_chrono_iterator_t::gt);
+}
+jmid::smf_chrono_event_t jmid::smf_chrono_iterator_t::operator*() const noexcept {
+	const auto& p = this->heap_.front();
+	return {p.trackn,p.tkonset,*(p.it)};
+}
+jmid::smf_chrono_iterator_t& jmid::smf_chrono_iterator_t::operator++() {
+	// Remove the current position from the heap, advance it, and put it 
+	// back unless the track is exhausted.  
+	std::pop_heap(this->heap_.begin(),this->heap_.end(),
+		jmid::smf_chrono_iterator_t::gt);
+	auto& p = this->heap_.back();
+	++(p.it);
+	if (p.it == p.end) {
+		this->heap_.pop_back();
+	} else {
+		p.tkonset += p.it->delta_time();
+		std::push_heap(this->heap_.begin(),this->heap_.end(),
+			jmid::smf_chrono_iterator_t::gt);
+	}
+	return *this;
+}
+jmid::smf_chrono_iterator_t jmid::smf_chrono_iterator_t::operator++(int) {
+	auto result = *this;
+	++(*this);
+	return result;
+}
+std::int32_t jmid::smf_chrono_iterator_t::trackn() const noexcept {
+	return this->heap_.front().trackn;
+}
+std::int32_t jmid::smf_chrono_iterator_t::tkonset() const noexcept {
+	return this->heap_.front().tkonset;
+}
+const jmid::mtrk_event_t& jmid::smf_chrono_iterator_t::event() const noexcept {
+	return *(this->heap_.front().it);
+}
+bool jmid::smf_chrono_iterator_t::operator==(const jmid::smf_chrono_iterator_t& rhs) const noexcept {
+	if (this->heap_.empty() || rhs.heap_.empty()) {
+		return this->heap_.empty() && rhs.heap_.empty();
+	}
+	return this->heap_.front().it == rhs.heap_.front().it;
+}
+bool jmid::smf_chrono_iterator_t::operator!=(const jmid::smf_chrono_iterator_t& rhs) const noexcept {
+	return !(*this == rhs);
+}
+bool jmid::smf_chrono_iterator_t::gt(const jmid::smf_chrono_iterator_t::pos_t& lhs,
+						const jmid::smf_chrono_iterator_t::pos_t& rhs) noexcept {  // Private
+	if (lhs.tkonset == rhs.tkonset) {
+		return lhs.trackn > rhs.trackn;
+	}
+	return lhs.tkonset > rhs.tkonset;
+}
+jmid::smf_chrono_iterator_t jmid::chrono_begin(const jmid::smf_t& smf) {
+	return jmid::smf_chrono_iterator_t(smf);
+}
+jmid::smf_chrono_iterator_t jmid::chrono_end(const jmid::smf_t&) {
+	return jmid::smf_chrono_iterator_t();
+}
+jmid::mtrk_t jmid::flatten_mtrks(const jmid::smf_t& smf) {
+	jmid::mtrk_t result;
+	result.set_arena_enabled(smf.arena_enabled());
+	// Each input track normally ends in an EOT, all of which are replaced
+	// by the single EOT appended below.
+	jmid::mtrk_t::size_type n = 1;
+	for (const auto& trk : smf) {
+		n += trk.size();
+	}
+	n -= static_cast<jmid::mtrk_t::size_type>(smf.ntrks());
+	result.reserve(std::max(n,jmid::mtrk_t::size_type{1}));
+
+	std::int32_t tk_prev = 0;
+	std::int32_t tk_last = 0;
+	auto end = jmid::chrono_end(smf);
+	for (auto it=jmid::chrono_begin(smf); it!=end; ++it) {
+		tk_last = it.tkonset();
+		if (jmid::is_eot(it.event())) {
+			continue;
+		}
+		auto ev = it.event();
+		ev.set_delta_time(tk_last-tk_prev);
+		result.push_back(std::move(ev));
+		tk_prev = tk_last;
+	}
+	result.push_back(jmid::make_eot(tk_last-tk_prev));
+	return result;
+}
+jmid::smf_t jmid::flatten_to_format0(const jmid::smf_t& smf) {
+	jmid::smf_t result;
+	result.set_mthd(smf.mthd());
+	result.set_arena_enabled(smf.arena_enabled());
+	result.push_back(jmid::flatten_mtrks(smf));
+	result.mthd().set_format(0);
+	for (jmid::smf_t::size_type i=0; i<smf.nuchks(); ++i) {
+		result.push_back(smf.get_uchk(i));
+	}
+	return result;
+}
+
+
 std::vector<jmid::all_smf_events_dt_ordered_t> jmid::get_events_dt_ordered(const jmid::smf_t& smf) {
 	std::vector<jmid::all_smf_events_dt_ordered_t> result;
-	//result.reserve(smf.nchunks...
-	
+	std::size_t n = 0;
+	for (const auto& trk : smf) {
+		n += trk.size();
+	}
+	result.reserve(n);
+	// Each track is already in tick order; a k-way merge, rather than a 
+	// sort of all the events.  
+	auto end = jmid::chrono_end(smf);
+	for (auto it=jmid::chrono_begin(smf); it!=end; ++it) {
+		result.push_back({it.event(),static_cast<std::uint32_t>(it.tkonset()),
+			it.trackn()});
+	}
+	return result;
+}
+std::vector<jmid::all_smf_events_dt_ordered_t> jmid::get_events_dt_ordered(jmid::smf_t&& smf) {
+	std::vector<jmid::all_smf_events_dt_ordered_t> result;
+	std::size_t n = 0;
+	for (const auto& trk : static_cast<const jmid::smf_t&>(smf)) {
+		n += trk.size();
+	}
+	result.reserve(n);
+
 	for (int i=0; i<smf.ntrks(); ++i) {
-		const auto& curr_trk = smf[i];
+		auto& curr_trk = smf[i];
 		std::uint32_t cumtk = 0;
-		for (const auto& e : curr_trk) {
+		for (auto& e : curr_trk) {
 			cumtk += e.delta_time();
-			result.push_back({e,cumtk,i});
+			e.detach_arena();
+			result.push_back({std::move(e),cumtk,i});
 		}
 	}
 
+	// Same ordering as for get_events_dt_ordered(const smf_t&); the sort
+	// must be stable to keep events of the same track and tick in order.  
 	auto lt_ev = [](const jmid::all_smf_events_dt_ordered_t& lhs, 
 					const jmid::all_smf_events_dt_ordered_t& rhs)->bool {
 		if (lhs.cumtk == rhs.cumtk) {
@@ -464,7 +928,7 @@ std::vector<jmid::all_smf_events_dt_ordered_t> jmid::get_events_dt_ordered(const
 			return lhs.cumtk < rhs.cumtk;
 		}
 	};
-	std::sort(result.begin(),result.end(),lt_ev);
+	std::stable_sort(result.begin(),result.end(),lt_ev);
 
 	return result;
 }
@@ -0,0 +1,406 @@
+#include "smf_view_t.h"
+#include "mthd_t.h"
+#include "mtrk_event_t.h"
+#include "make_mtrk_event.h"
+#include "generic_chunk_low_level.h"
+#include "midi_delta_time.h"
+#include "midi_status_byte.h"
+#include "midi_vlq.h"
+#include "aux_types.h"
+#include <cstdint>
+#include <algorithm>  // std::min()
+
+
+const unsigned char *jmid::mtrk_event_view_t::begin() const noexcept {
+	return this->beg_;
+}
+const unsigned char *jmid::mtrk_event_view_t::end() const noexcept {
+	return this->end_;
+}
+const unsigned char *jmid::mtrk_event_view_t::event_begin() const noexcept {
+	return jmid::advance_to_dt_end(this->beg_,this->end_);
+}
+const unsigned char *jmid::mtrk_event_view_t::payload_begin() const noexcept {
+	return this->payload_;
+}
+jmid::mtrk_event_view_t::size_type jmid::mtrk_event_view_t::size() const noexcept {
+	return static_cast<size_type>(this->end_-this->beg_);
+}
+jmid::mtrk_event_view_t::size_type jmid::mtrk_event_view_t::data_size() const noexcept {
+	return static_cast<size_type>(this->end_-this->event_begin());
+}
+std::int32_t jmid::mtrk_event_view_t::delta_time() const noexcept {
+	return this->dt_;
+}
+unsigned char jmid::mtrk_event_view_t::status_byte() const noexcept {
+	return this->s_;
+}
+unsigned char jmid::mtrk_event_view_t::running_status() const noexcept {
+	return jmid::get_running_status_byte(this->s_,0x00u);
+}
+bool jmid::mtrk_event_view_t::is_in_running_status() const noexcept {
+	return this->in_rs_;
+}
+jmid::ch_event_data_t jmid::mtrk_event_view_t::get_channel_event_data() const noexcept {
+	jmid::ch_event_data_t result;
+	result.status_nybble = this->s_&0xF0u;
+	result.ch = this->s_&0x0Fu;
+	auto n = this->end_-this->payload_;
+	if (n > 0) {
+		result.p1 = *(this->payload_);
+	}
+	if (n > 1) {
+		result.p2 = *(this->payload_+1);
+	}
+	return result;
+}
+jmid::meta_header_data jmid::mtrk_event_view_t::get_meta() const noexcept {
+	jmid::meta_header_data result;
+	result.type = this->type_;
+	result.length = static_cast<std::int32_t>(this->end_-this->payload_);
+	return result;
+}
+jmid::sysex_header_data jmid::mtrk_event_view_t::get_sysex() const noexcept {
+	jmid::sysex_header_data result;
+	result.type = this->s_;
+	result.length = static_cast<std::int32_t>(this->end_-this->payload_);
+	return result;
+}
+jmid::mtrk_event_t jmid::mtrk_event_view_t::to_mtrk_event() const {
+	if (this->in_rs_) {
+		return jmid::mtrk_event_t(this->dt_,this->get_channel_event_data());
+	}
+	jmid::mtrk_event_t result;
+	jmid::make_mtrk_event3(this->beg_,this->end_,0x00u,&result,nullptr);
+	return result;
+}
+bool jmid::is_eot(const jmid::mtrk_event_view_t& ev) noexcept {
+	return ((ev.status_byte()==0xFFu) && (ev.get_meta().type==0x2Fu));
+}
+
+//
+// The logic (and the order of the checks) mirrors make_mtrk_event3()
+// exactly so that the two functions report the same errors and return
+// the same iterator for any input.
+//
+const unsigned char *jmid::read_mtrk_event_view(const unsigned char *it,
+					const unsigned char *end, unsigned char rs,
+					jmid::mtrk_event_view_t *result,
+					jmid::mtrk_event_error_t *err) {
+	auto set_error = [&result,&err](mtrk_event_error_t::errc ec,
+							unsigned char s, unsigned char rs) -> void {
+		*result = jmid::mtrk_event_view_t();
+		if (err!=nullptr) {
+			err->code = ec;
+			err->s = s;
+			err->rs = rs;
+		}
+	};
+	if (err!=nullptr) {
+		err->code = mtrk_event_error_t::errc::no_error;
+		err->s = 0;
+		err->rs = rs;
+	}
+	auto beg = it;
+
+	// The delta-time field
+	jmid::dt_field_interpreted dtf;
+	it = jmid::read_delta_time(it,end,dtf);
+	if (!dtf.is_valid) {
+		set_error(mtrk_event_error_t::errc::invalid_delta_time,0,rs);
+		return it;
+	}
+
+	// The status byte
+	if (it==end) {
+		set_error(mtrk_event_error_t::errc::no_data_following_delta_time,0,rs);
+		return it;
+	}
+	unsigned char last = *it++;
+	auto s = jmid::get_status_byte(last,rs);
+	const unsigned char *payload = it;
+	unsigned char type = 0x00u;
+	bool in_rs = false;
+
+	if (jmid::is_channel_status_byte(s)) {
+		auto n = jmid::channel_status_byte_n_data_bytes(s);
+		if (jmid::is_data_byte(last)) {  // In rs; last is data byte p1
+			in_rs = true;
+			payload = it-1;
+			if (n==2) {
+				if (it==end) {
+					set_error(mtrk_event_error_t::errc::channel_calcd_length_exceeds_input,s,rs);
+					return it;
+				}
+				if (!jmid::is_data_byte(*it++)) {
+					set_error(mtrk_event_error_t::errc::channel_invalid_data_byte,s,rs);
+					return it;
+				}
+			}  // In rs, n==2
+		} else {  // Not in rs; last was the status byte
+			if (it==end) {
+				set_error(mtrk_event_error_t::errc::channel_calcd_length_exceeds_input,s,rs);
+				return it;
+			}
+			if (!jmid::is_data_byte(*it++)) {
+				set_error(mtrk_event_error_t::errc::channel_invalid_data_byte,s,rs);
+				return it;
+			}
+			if (n==2) {
+				if (it==end) {
+					set_error(mtrk_event_error_t::errc::channel_calcd_length_exceeds_input,s,rs);
+					return it;
+				}
+				if (!jmid::is_data_byte(*it++)) {
+					set_error(mtrk_event_error_t::errc::channel_invalid_data_byte,s,rs);
+					return it;
+				}
+			}  // Not in rs, n==2
+		}  // In rs?
+	} else if (jmid::is_sysex_or_meta_status_byte(s)) {
+		if (jmid::is_meta_status_byte(s)) {
+			if (it==end) {
+				set_error(mtrk_event_error_t::errc::sysex_or_meta_overflow_in_header,s,rs);
+				return it;
+			}
+			type = *it++;
+			if (!jmid::is_meta_type_byte(type)) {
+				set_error(mtrk_event_error_t::errc::other,s,rs);
+				return it;
+			}
+		}
+		// The vlq length field
+		if (it==end) {
+			set_error(mtrk_event_error_t::errc::sysex_or_meta_overflow_in_header,s,rs);
+			return it;
+		}
+		jmid::vlq_field_interpreted lenf;
+		it = jmid::read_vlq(it,end,lenf);
+		if (!lenf.is_valid) {
+			set_error(mtrk_event_error_t::errc::sysex_or_meta_invalid_vlq_length,s,rs);
+			return it;
+		}
+		payload = it;
+		// make_mtrk_event3() copies at most 1Mb of payload; any event w/a
+		// longer payload is an error, w/ the iterator advanced by the number
+		// of bytes copied.
+		auto len = std::min(lenf.val,1000000);
+		auto n_avail = end-it;
+		if (n_avail < len) {
+			it = end;
+			set_error(mtrk_event_error_t::errc::sysex_or_meta_calcd_length_exceeds_input,s,rs);
+			return it;
+		}
+		it += len;
+		if (len != lenf.val) {
+			set_error(mtrk_event_error_t::errc::sysex_or_meta_calcd_length_exceeds_input,s,rs);
+			return it;
+		}
+	} else {  // is_unrecognized_status_byte(s) || !is_status_byte(s)
+		set_error(mtrk_event_error_t::errc::invalid_status_byte,s,rs);
+		return it;
+	}
+
+	result->beg_ = beg;
+	result->end_ = it;
+	result->payload_ = payload;
+	result->dt_ = dtf.val;
+	result->s_ = s;
+	result->type_ = type;
+	result->in_rs_ = in_rs;
+	return it;
+}
+
+
+jmid::mtrk_view_iterator_t::mtrk_view_iterator_t(const unsigned char *beg,
+						const unsigned char *end) noexcept
+						: p_(beg), end_(end) {
+	this->read_curr();
+}
+jmid::mtrk_view_iterator_t::reference
+			jmid::mtrk_view_iterator_t::operator*() const noexcept {
+	return this->ev_;
+}
+jmid::mtrk_view_iterator_t::pointer
+			jmid::mtrk_view_iterator_t::operator->() const noexcept {
+	return &(this->ev_);
+}
+jmid::mtrk_view_iterator_t& jmid::mtrk_view_iterator_t::operator++() noexcept {
+	if (jmid::is_eot(this->ev_)) {
+		this->p_ = this->end_;
+		return *this;
+	}
+	this->p_ = this->ev_.end();
+	this->read_curr();
+	return *this;
+}
+jmid::mtrk_view_iterator_t jmid::mtrk_view_iterator_t::operator++(int) noexcept {
+	auto result = *this;
+	++(*this);
+	return result;
+}
+jmid::mtrk_event_error_t::errc jmid::mtrk_view_iterator_t::error() const noexcept {
+	return this->err_;
+}
+void jmid::mtrk_view_iterator_t::read_curr() noexcept {
+	if (this->p_==this->end_) {
+		return;
+	}
+	jmid::mtrk_event_error_t curr_err;
+	jmid::read_mtrk_event_view(this->p_,this->end_,
+		this->ev_.running_status(),&(this->ev_),&curr_err);
+	if (curr_err.code != jmid::mtrk_event_error_t::errc::no_error) {
+		this->err_ = curr_err.code;
+		this->p_ = this->end_;
+	}
+}
+bool jmid::operator==(const jmid::mtrk_view_iterator_t& lhs,
+						const jmid::mtrk_view_iterator_t& rhs) noexcept {
+	return lhs.p_ == rhs.p_;
+}
+bool jmid::operator!=(const jmid::mtrk_view_iterator_t& lhs,
+						const jmid::mtrk_view_iterator_t& rhs) noexcept {
+	return lhs.p_ != rhs.p_;
+}
+
+
+jmid::mtrk_view_t::mtrk_view_t(const unsigned char *beg,
+						const unsigned char *end) noexcept
+						: beg_(beg), end_(end) {
+	//...
+}
+jmid::mtrk_view_t::const_iterator jmid::mtrk_view_t::begin() const noexcept {
+	return jmid::mtrk_view_iterator_t(this->beg_,this->end_);
+}
+jmid::mtrk_view_t::const_iterator jmid::mtrk_view_t::end() const noexcept {
+	return jmid::mtrk_view_iterator_t(this->end_,this->end_);
+}
+const unsigned char *jmid::mtrk_view_t::data_begin() const noexcept {
+	return this->beg_;
+}
+const unsigned char *jmid::mtrk_view_t::data_end() const noexcept {
+	return this->end_;
+}
+std::int32_t jmid::mtrk_view_t::data_nbytes() const noexcept {
+	return static_cast<std::int32_t>(this->end_-this->beg_);
+}
+
+
+jmid::smf_view_t::size_type jmid::smf_view_t::size() const noexcept {
+	return this->mtrks_.size();
+}
+jmid::smf_view_t::size_type jmid::smf_view_t::nchunks() const noexcept {
+	return this->mtrks_.size()+this->uchks_.size();
+}
+jmid::smf_view_t::size_type jmid::smf_view_t::ntrks() const noexcept {
+	return this->mtrks_.size();
+}
+jmid::smf_view_t::size_type jmid::smf_view_t::nuchks() const noexcept {
+	return this->uchks_.size();
+}
+jmid::smf_view_t::const_iterator jmid::smf_view_t::begin() const noexcept {
+	return this->mtrks_.begin();
+}
+jmid::smf_view_t::const_iterator jmid::smf_view_t::end() const noexcept {
+	return this->mtrks_.end();
+}
+const jmid::mtrk_view_t& jmid::smf_view_t::operator[](size_type i) const noexcept {
+	return this->mtrks_[i];
+}
+jmid::smf_view_t::uchk_view_t jmid::smf_view_t::get_uchk(size_type i) const noexcept {
+	return this->uchks_[i];
+}
+const jmid::mthd_t& jmid::smf_view_t::mthd() const noexcept {
+	return this->mthd_;
+}
+std::int32_t jmid::smf_view_t::format() const noexcept {
+	return this->mthd_.format();
+}
+jmid::time_division_t jmid::smf_view_t::division() const noexcept {
+	return this->mthd_.division();
+}
+
+
+const unsigned char *jmid::make_smf_view(const unsigned char *it,
+				const unsigned char *end, jmid::smf_view_t *result,
+				jmid::smf_error_t *err) {
+	auto set_error = [&result,&err](smf_error_t::errc ec, int expect_ntrks,
+						int n_mtrks_read, int n_uchks_read)->void {
+		result->mtrks_.resize(n_mtrks_read);
+		result->uchks_.resize(n_uchks_read);
+		if (err!=nullptr) {
+			err->code = ec;
+			err->num_mtrks_read = n_mtrks_read;
+			err->num_uchks_read = n_uchks_read;
+			err->expect_num_mtrks = expect_ntrks;
+		}
+	};
+
+	jmid::mthd_error_t mthd_err;
+	it = jmid::make_mthd2(it,end,&(result->mthd_),&mthd_err);
+	if (mthd_err.code != mthd_error_t::errc::no_error) {
+		set_error(smf_error_t::errc::mthd_error,0,0,0);
+		return it;
+	}
+
+	auto expect_ntrks = result->mthd_.ntrks();
+	int n_mtrks_read = 0;
+	int n_uchks_read = 0;
+	result->mtrks_.clear();
+	result->uchks_.clear();
+	result->mtrks_.reserve(expect_ntrks);
+	while ((it!=end) && (n_mtrks_read<expect_ntrks)) {
+		jmid::chunk_header_t curr_chk_header;
+		jmid::chunk_header_error_t curr_chk_header_err;
+		it = jmid::read_chunk_header(it,end,&curr_chk_header,
+			&curr_chk_header_err);
+		if (curr_chk_header_err.code != jmid::chunk_header_error_t::errc::no_error) {
+			set_error(smf_error_t::errc::other,0,0,0);
+			return it;
+		}
+		if (!jmid::has_valid_length(curr_chk_header)) {
+			set_error(smf_error_t::errc::other,expect_ntrks,n_mtrks_read,
+					n_uchks_read);
+			return it;
+		}
+		auto n_avail = end-it;
+		auto len = static_cast<std::ptrdiff_t>(curr_chk_header.length);
+
+		if (jmid::has_mtrk_id(curr_chk_header)) {
+			if (len > n_avail) {
+				set_error(smf_error_t::errc::mtrk_error,expect_ntrks,
+					n_mtrks_read,n_uchks_read);
+				if (err!=nullptr) {
+					err->mtrk_err_obj.code = jmid::mtrk_error_t::errc::other;
+				}
+				return end;
+			}
+			result->mtrks_.emplace_back(it,it+len);
+			++n_mtrks_read;
+		} else if (jmid::has_uchk_id(curr_chk_header)) {
+			if (len > n_avail) {
+				set_error(smf_error_t::errc::overflow_reading_uchk,
+							expect_ntrks,n_mtrks_read,n_uchks_read);
+				return end;
+			}
+			result->uchks_.push_back({it,it+len});
+			++n_uchks_read;
+		} else {  // Non-MTrk, non-UChk header field
+			set_error(smf_error_t::errc::other,expect_ntrks,n_mtrks_read,
+					n_uchks_read);
+			return it;
+		}
+		it += len;
+	}  // To next chunk
+
+	if (n_mtrks_read != expect_ntrks) {
+		set_error(smf_error_t::errc::unexpected_num_mtrks,
+				expect_ntrks,n_mtrks_read,n_uchks_read);
+		return it;
+	}
+
+	set_error(smf_error_t::errc::no_error,expect_ntrks,n_mtrks_read,
+				n_uchks_read);
+	return it;
+}
+
@@ -4,6 +4,18 @@
 #include <cstdio>
 #include <random>
 #include <string>
+#include <utility>  // std::exchange()
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 // TODO:  Test cases w/ inputs containing 0x1A, input w/ spaces preceeding an \n
@@ -34,3 +46,122 @@ std::string jmid::randstr(int n) {
 	}
 	return s;
 }
+
+
+jmid::read_only_mapped_file_t::read_only_mapped_file_t(
+				const std::filesystem::path& pth) {
+	this->open(pth);
+}
+jmid::read_only_mapped_file_t::read_only_mapped_file_t(
+				jmid::read_only_mapped_file_t&& rhs) noexcept {
+	this->p_ = std::exchange(rhs.p_,nullptr);
+	this->sz_ = std::exchange(rhs.sz_,0);
+	this->is_open_ = std::exchange(rhs.is_open_,false);
+}
+jmid::read_only_mapped_file_t& jmid::read_only_mapped_file_t::operator=(
+				jmid::read_only_mapped_file_t&& rhs) noexcept {
+	if (this != &rhs) {
+		this->close();
+		this->p_ = std::exchange(rhs.p_,nullptr);
+		this->sz_ = std::exchange(rhs.sz_,0);
+		this->is_open_ = std::exchange(rhs.is_open_,false);
+	}
+	return *this;
+}
+jmid::read_only_mapped_file_t::~read_only_mapped_file_t() noexcept {
+	this->close();
+}
+#ifdef _WIN32
+bool jmid::read_only_mapped_file_t::open(const std::filesystem::path& pth) {
+	this->close();
+	HANDLE hfile = CreateFileW(pth.c_str(),GENERIC_READ,FILE_SHARE_READ,
+		nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr);
+	if (hfile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER fsize;
+	if (!GetFileSizeEx(hfile,&fsize)) {
+		CloseHandle(hfile);
+		return false;
+	}
+	if (fsize.QuadPart == 0) {
+		// CreateFileMapping() fails for zero-length files
+		CloseHandle(hfile);
+		this->is_open_ = true;
+		return true;
+	}
+	HANDLE hmap = CreateFileMappingW(hfile,nullptr,PAGE_READONLY,0,0,nullptr);
+	CloseHandle(hfile);
+	if (hmap == nullptr) {
+		return false;
+	}
+	auto p = MapViewOfFile(hmap,FILE_MAP_READ,0,0,0);
+	CloseHandle(hmap);  // The view holds a reference to the mapping
+	if (p == nullptr) {
+		return false;
+	}
+	this->p_ = static_cast<const unsigned char*>(p);
+	this->sz_ = static_cast<std::size_t>(fsize.QuadPart);
+	this->is_open_ = true;
+	return true;
+}
+void jmid::read_only_mapped_file_t::close() noexcept {
+	if (this->p_) {
+		UnmapViewOfFile(this->p_);
+	}
+	this->p_ = nullptr;
+	this->sz_ = 0;
+	this->is_open_ = false;
+}
+#else
+bool jmid::read_only_mapped_file_t::open(const std::filesystem::path& pth) {
+	this->close();
+	int fd = ::open(pth.c_str(),O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat sb;
+	if (::fstat(fd,&sb) == -1) {
+		::close(fd);
+		return false;
+	}
+	if (sb.st_size == 0) {
+		// mmap() fails for zero-length files
+		::close(fd);
+		this->is_open_ = true;
+		return true;
+	}
+	auto sz = static_cast<std::size_t>(sb.st_size);
+	void *p = ::mmap(nullptr,sz,PROT_READ,MAP_PRIVATE,fd,0);
+	::close(fd);  // The mapping holds a reference to the file
+	if (p == MAP_FAILED) {
+		return false;
+	}
+	// The parser makes a single front-to-back pass
+	::madvise(p,sz,MADV_SEQUENTIAL);
+	this->p_ = static_cast<const unsigned char*>(p);
+	this->sz_ = sz;
+	this->is_open_ = true;
+	return true;
+}
+void jmid::read_only_mapped_file_t::close() noexcept {
+	if (this->p_) {
+		::munmap(const_cast<unsigned char*>(this->p_),this->sz_);
+	}
+	this->p_ = nullptr;
+	this->sz_ = 0;
+	this->is_open_ = false;
+}
+#endif
+bool jmid::read_only_mapped_file_t::is_open() const noexcept {
+	return this->is_open_;
+}
+std::size_t jmid::read_only_mapped_file_t::size() const noexcept {
+	return this->sz_;
+}
+const unsigned char *jmid::read_only_mapped_file_t::begin() const noexcept {
+	return this->p_;
+}
+const unsigned char *jmid::read_only_mapped_file_t::end() const noexcept {
+	return this->p_+this->sz_;
+}
@@ -0,0 +1,226 @@
+#include "gtest/gtest.h"
+#include "batch_read.h"
+#include "smf_t.h"
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <mutex>
+
+
+namespace batch_read_tests {
+std::vector<unsigned char> valid_smf {
+	0x4D, 0x54, 0x68, 0x64,  // MThd
+	0x00, 0x00, 0x00, 0x06,
+	0x00, 0x00,  // Format 0
+	0x00, 0x01,  // 1 track
+	0x00, 0x60,  // 96 tpq
+
+	0x4D, 0x54, 0x72, 0x6B,  // MTrk
+	0x00, 0x00, 0x00, 0x0C,  // 12 bytes
+	0x00, 0x90, 0x3C, 0x40,
+	0x60, 0x80, 0x3C, 0x40,
+	0x00, 0xFF, 0x2F, 0x00
+};
+// No EOT in the MTrk
+std::vector<unsigned char> invalid_smf {
+	0x4D, 0x54, 0x68, 0x64,  // MThd
+	0x00, 0x00, 0x00, 0x06,
+	0x00, 0x00,  // Format 0
+	0x00, 0x01,  // 1 track
+	0x00, 0x60,  // 96 tpq
+
+	0x4D, 0x54, 0x72, 0x6B,  // MTrk
+	0x00, 0x00, 0x00, 0x08,  // 8 bytes
+	0x00, 0x90, 0x3C, 0x40,
+	0x60, 0x80, 0x3C, 0x40
+};
+}  // namespace batch_read_tests
+
+
+//
+// Each file is reported exactly once to the callback, and the returned
+// errors are in the same order as the input paths, regardless of the
+// read method or the order in which the workers process the files.
+//
+TEST(batch_read_tests, AllMethodsResultsInInputOrder) {
+	auto tmpdir = std::filesystem::temp_directory_path();
+	std::vector<std::filesystem::path> paths;
+	std::vector<jmid::smf_error_t::errc> expect;
+	for (int i=0; i<12; ++i) {
+		auto fp = tmpdir/("jmid_batch_read_tests_" + std::to_string(i) + ".mid");
+		paths.push_back(fp);
+		if (i%4 == 3) {  // Does not exist
+			std::filesystem::remove(fp);
+			expect.push_back(jmid::smf_error_t::errc::file_read_error);
+			continue;
+		}
+		std::ofstream f(fp,std::ios_base::out|std::ios_base::binary);
+		const auto& d = (i%4 == 2) ? batch_read_tests::invalid_smf
+			: batch_read_tests::valid_smf;
+		// Vary the file sizes so that the size-ordering has some effect
+		for (int j=0; j<=(i%4==0 ? i : 0); ++j) {
+			f.write(reinterpret_cast<const char*>(d.data()),d.size());
+		}
+		f.close();
+		expect.push_back((i%4 == 2) ? jmid::smf_error_t::errc::mtrk_error
+			: jmid::smf_error_t::errc::no_error);
+	}
+
+	std::vector<jmid::batch_read_method> methods {
+		jmid::batch_read_method::bulk_ifstream,
+		jmid::batch_read_method::istreambuf_iterator,
+		jmid::batch_read_method::csio,
+		jmid::batch_read_method::mmap
+	};
+	for (const auto& m : methods) {
+		jmid::batch_read_opts_t opts;
+		opts.nthreads = 3;
+		opts.method = m;
+		std::mutex mtx;
+		std::vector<int> ncalls(paths.size(),0);
+		std::vector<int> ntrks(paths.size(),-1);
+		bool worker_in_range = true;
+		auto cb = [&](const jmid::batch_read_item_t& item)->void {
+			std::lock_guard<std::mutex> lock(mtx);
+			++ncalls[item.idx];
+			worker_in_range = worker_in_range
+				&& (item.worker>=0) && (item.worker<opts.nthreads);
+			EXPECT_EQ(item.path,paths[item.idx]);
+			if (item.error.code == jmid::smf_error_t::errc::no_error) {
+				ASSERT_NE(item.smf,nullptr);
+				ntrks[item.idx] = item.smf->ntrks();
+			}
+		};
+		auto errs = jmid::batch_read(paths,cb,opts);
+		ASSERT_EQ(errs.size(),paths.size());
+		EXPECT_TRUE(worker_in_range);
+		for (std::size_t i=0; i<paths.size(); ++i) {
+			EXPECT_EQ(ncalls[i],1);
+			EXPECT_EQ(errs[i].code,expect[i]);
+			if (expect[i] == jmid::smf_error_t::errc::no_error) {
+				EXPECT_EQ(ntrks[i],1);
+			}
+		}
+	}
+
+	// make_smf == false:  Raw file data is passed to the callback
+	jmid::batch_read_opts_t opts;
+	opts.nthreads = 2;
+	opts.make_smf = false;
+	std::mutex mtx;
+	std::vector<std::ptrdiff_t> nbytes(paths.size(),-1);
+	auto cb = [&](const jmid::batch_read_item_t& item)->void {
+		std::lock_guard<std::mutex> lock(mtx);
+		EXPECT_EQ(item.smf,nullptr);
+		nbytes[item.idx] = item.data_end-item.data_beg;
+	};
+	auto errs = jmid::batch_read(paths,cb,opts);
+	for (std::size_t i=0; i<paths.size(); ++i) {
+		if (expect[i] == jmid::smf_error_t::errc::file_read_error) {
+			EXPECT_EQ(errs[i].code,jmid::smf_error_t::errc::file_read_error);
+			EXPECT_EQ(nbytes[i],0);
+		} else {
+			EXPECT_EQ(errs[i].code,jmid::smf_error_t::errc::no_error);
+			EXPECT_EQ(nbytes[i],std::filesystem::file_size(paths[i]));
+		}
+	}
+
+	for (const auto& fp : paths) {
+		std::filesystem::remove(fp);
+	}
+}
+
+
+//
+// An exception thrown while a file is processed (here, by the callback) is
+// reported as an error for that file rather than terminating the program,
+// and the other files are still processed.  
+//
+TEST(batch_read_tests, ExceptionInWorkerIsPerFileError) {
+	auto tmpdir = std::filesystem::temp_directory_path();
+	std::vector<std::filesystem::path> paths;
+	for (int i=0; i<6; ++i) {
+		auto fp = tmpdir/("jmid_batch_read_exc_tests_" + std::to_string(i) + ".mid");
+		paths.push_back(fp);
+		std::ofstream f(fp,std::ios_base::out|std::ios_base::binary);
+		f.write(reinterpret_cast<const char*>(batch_read_tests::valid_smf.data()),
+			batch_read_tests::valid_smf.size());
+	}
+
+	jmid::batch_read_opts_t opts;
+	opts.nthreads = 2;
+	std::mutex mtx;
+	std::vector<int> ncalls(paths.size(),0);
+	auto cb = [&](const jmid::batch_read_item_t& item)->void {
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			++ncalls[item.idx];
+		}
+		if (item.idx%3 == 1) {
+			throw std::runtime_error("callback error");
+		}
+	};
+	auto errs = jmid::batch_read(paths,cb,opts);
+	ASSERT_EQ(errs.size(),paths.size());
+	for (std::size_t i=0; i<paths.size(); ++i) {
+		EXPECT_EQ(ncalls[i],1);
+		EXPECT_EQ(errs[i].code,(i%3 == 1) ? jmid::smf_error_t::errc::other
+			: jmid::smf_error_t::errc::no_error);
+		std::filesystem::remove(paths[i]);
+	}
+}
+
+//
+// batch_read_opts_t::intern_store is installed on each worker thread:  The
+// equal big meta events of all the files share a buffer in the store.  
+//
+TEST(batch_read_tests, InternStoreInstalledOnWorkers) {
+	std::vector<unsigned char> bytes {
+		0x4D, 0x54, 0x68, 0x64,  // MThd
+		0x00, 0x00, 0x00, 0x06,
+		0x00, 0x00,  // Format 0
+		0x00, 0x01,  // 1 track
+		0x00, 0x60,  // 96 tpq
+
+		0x4D, 0x54, 0x72, 0x6B,  // MTrk
+		0x00, 0x00, 0x00, 0x30,  // 48 bytes
+		0x00, 0xFF, 0x01, 0x28  // Text event, 40 bytes
+	};
+	bytes.insert(bytes.end(),40,0x41u);
+	bytes.insert(bytes.end(),{0x00, 0xFF, 0x2F, 0x00});
+
+	auto tmpdir = std::filesystem::temp_directory_path();
+	std::vector<std::filesystem::path> paths;
+	for (int i=0; i<6; ++i) {
+		auto fp = tmpdir/("jmid_batch_read_intern_tests_" + std::to_string(i) + ".mid");
+		paths.push_back(fp);
+		std::ofstream f(fp,std::ios_base::out|std::ios_base::binary);
+		f.write(reinterpret_cast<const char*>(bytes.data()),bytes.size());
+	}
+
+	jmid::internal::byte_intern_t store;
+	jmid::batch_read_opts_t opts;
+	opts.nthreads = 3;
+	opts.intern_store = &store;
+	std::mutex mtx;
+	std::vector<const unsigned char*> data;
+	auto cb = [&](const jmid::batch_read_item_t& item)->void {
+		ASSERT_NE(item.smf,nullptr);
+		ASSERT_EQ(item.smf->ntrks(),1);
+		std::lock_guard<std::mutex> lock(mtx);
+		data.push_back((*item.smf)[0][0].data());
+	};
+	auto errs = jmid::batch_read(paths,cb,opts);
+	for (std::size_t i=0; i<paths.size(); ++i) {
+		EXPECT_EQ(errs[i].code,jmid::smf_error_t::errc::no_error);
+		std::filesystem::remove(paths[i]);
+	}
+	ASSERT_EQ(data.size(),paths.size());
+	for (const auto& p : data) {
+		EXPECT_EQ(p,data[0]);
+	}
+	EXPECT_EQ(store.size(),1);
+	EXPECT_EQ(store.nhits(),5);
+}
@@ -0,0 +1,200 @@
+#include "gtest/gtest.h"
+#include "mtrk_test_data.h"
+#include "frozen_smf_t.h"
+#include "smf_t.h"
+#include "smf_view_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "mtrk_event_methods.h"
+#include "midi_status_byte.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>  // offsetof
+#include <cstring>
+#include <string>
+#include <random>
+#include <iterator>
+#include <algorithm>
+
+
+namespace frozen_smf_tests {
+// MThd, MTrk, an unknown chunk, MTrk (uses running status)
+std::vector<unsigned char> tsa_bytes {
+	0x4D, 0x54, 0x68, 0x64,  // MThd
+	0x00, 0x00, 0x00, 0x06,
+	0x00, 0x01,  // Format 1
+	0x00, 0x02,  // 2 tracks
+	0x00, 0x60,  // 96 tpq
+
+	0x4D, 0x54, 0x72, 0x6B,  // MTrk
+	0x00, 0x00, 0x00, 0x13,  // 19 bytes
+	0x00, 0xFF, 0x58, 0x04, 0x04, 0x02, 0x18, 0x08,
+	0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+	0x00, 0xFF, 0x2F, 0x00,
+
+	0x4A, 0x55, 0x4E, 0x4B,  // JUNK
+	0x00, 0x00, 0x00, 0x03,
+	0x01, 0x02, 0x03,
+
+	0x4D, 0x54, 0x72, 0x6B,  // MTrk
+	0x00, 0x00, 0x00, 0x18,  // 24 bytes
+	0x00, 0xFF, 0x03, 0x02, 0x41, 0x42,  // Seq/track name "AB"
+	0x00, 0x90, 0x3C, 0x40,
+	0x60, 0x3E, 0x40,  // running status
+	0x60, 0x80, 0x3C, 0x40,
+	0x00, 0x3E, 0x40,  // running status
+	0x00, 0xFF, 0x2F, 0x00
+};
+
+// tsa_bytes, plus a large random track and a second (empty) uchk
+jmid::smf_t make_test_smf() {
+	jmid::smf_t smf;
+	jmid::smf_error_t err;
+	jmid::make_smf2(tsa_bytes.data(),tsa_bytes.data()+tsa_bytes.size(),
+		&smf,&err);
+	std::mt19937 re(11);
+	smf.push_back(mtrk_tests::make_random_mtrk(re,500));
+	smf.push_back(jmid::smf_t::uchk_value_type());
+	return smf;
+}
+}  // namespace frozen_smf_tests
+
+
+//
+// The frozen object describes the same smf as the smf_t from which it was
+// built:  The smf data is the output of write_smf(), each event record
+// points at the bytes of the corresponding event, and to_smf() rebuilds an
+// equivalent smf_t, w/ the chunks in the original order.
+//
+TEST(frozen_smf_t_tests, MatchesSourceSmf) {
+	auto smf = frozen_smf_tests::make_test_smf();
+	jmid::frozen_smf_t frz(smf);
+	ASSERT_EQ(frz.ntrks(),smf.ntrks());
+	ASSERT_EQ(frz.nuchks(),smf.nuchks());
+	EXPECT_EQ(frz.size(),smf.size());
+	EXPECT_EQ(frz.nchunks(),smf.nchunks());
+	EXPECT_EQ(frz.format(),smf.format());
+	EXPECT_EQ(frz.division(),smf.division());
+	auto mthd = frz.mthd();
+	EXPECT_TRUE(std::equal(mthd.begin(),mthd.end(),
+		smf.mthd().begin(),smf.mthd().end()));
+
+	std::vector<unsigned char> expect_bytes;
+	jmid::write_smf(smf,std::back_inserter(expect_bytes));
+	EXPECT_TRUE(std::equal(frz.smf_begin(),frz.smf_end(),
+		expect_bytes.begin(),expect_bytes.end()));
+
+	std::int64_t nevents = 0;
+	for (int i=0; i<smf.ntrks(); ++i) {
+		const auto& trk = smf[i];
+		ASSERT_EQ(frz.event_end(i)-frz.event_begin(i),trk.size());
+		nevents += trk.size();
+		std::vector<unsigned char> trk_bytes;
+		jmid::write_mtrk(trk,std::back_inserter(trk_bytes));
+		EXPECT_TRUE(std::equal(frz.mtrk_begin(i),frz.mtrk_end(i),
+			trk_bytes.begin(),trk_bytes.end()));
+
+		auto view_it = frz.mtrk_view(i).begin();
+		std::int32_t tk = 0;
+		for (int j=0; j<trk.size(); ++j) {
+			const auto& e = *(frz.event_begin(i)+j);
+			const auto& ev = trk[j];
+			tk += ev.delta_time();
+			EXPECT_EQ(e.tkonset,tk);
+			EXPECT_EQ(e.status,ev.status_byte());
+			EXPECT_EQ(e.dt_nbytes,ev.event_begin()-ev.data());
+			ASSERT_EQ(e.nbytes,ev.size());
+			EXPECT_TRUE(std::equal(frz.event_data(e),frz.event_data(e)+e.nbytes,
+				ev.begin(),ev.end()));
+			EXPECT_EQ(frz.event(e),ev);
+			EXPECT_EQ(frz.event_view(e).delta_time(),ev.delta_time());
+			if (jmid::is_channel(ev)) {
+				auto md = jmid::get_channel_event(ev);
+				EXPECT_EQ(e.p1,md.p1);
+				if (jmid::channel_status_byte_n_data_bytes(e.status)==2) {
+					EXPECT_EQ(e.p2,md.p2);
+				}
+			} else if (jmid::is_meta(ev)) {
+				EXPECT_EQ(e.p1,*(ev.event_begin()+1));
+			}
+			ASSERT_NE(view_it,frz.mtrk_view(i).end());
+			EXPECT_EQ(view_it->begin(),frz.event_data(e));
+			++view_it;
+		}
+		EXPECT_EQ(view_it,frz.mtrk_view(i).end());
+	}
+	EXPECT_EQ(frz.nevents(),nevents);
+	for (int i=0; i<smf.nuchks(); ++i) {
+		EXPECT_TRUE(std::equal(frz.uchk_begin(i),frz.uchk_end(i),
+			smf.get_uchk(i).begin(),smf.get_uchk(i).end()));
+	}
+
+	auto smf2 = frz.to_smf();
+	ASSERT_EQ(smf2.ntrks(),smf.ntrks());
+	ASSERT_EQ(smf2.nuchks(),smf.nuchks());
+	EXPECT_TRUE(std::equal(smf2.mthd().begin(),smf2.mthd().end(),
+		smf.mthd().begin(),smf.mthd().end()));
+	for (int i=0; i<smf.ntrks(); ++i) {
+		ASSERT_EQ(smf2[i].size(),smf[i].size());
+		EXPECT_TRUE(std::equal(smf2[i].begin(),smf2[i].end(),smf[i].begin()));
+	}
+	for (int i=0; i<smf.nuchks(); ++i) {
+		EXPECT_EQ(smf2.get_uchk(i),smf.get_uchk(i));
+	}
+	// Chunk order is preserved; the refrozen blob is identical
+	jmid::frozen_smf_t frz2(smf2);
+	EXPECT_TRUE(std::equal(frz.blob_begin(),frz.blob_end(),
+		frz2.blob_begin(),frz2.blob_end()));
+}
+
+//
+// The blob can be copied out and read back in w/ make_frozen_smf(), which
+// rejects truncated and corrupted blobs.
+//
+TEST(frozen_smf_t_tests, BlobRoundTripAndCopies) {
+	auto smf = frozen_smf_tests::make_test_smf();
+	jmid::frozen_smf_t frz(smf);
+	std::vector<unsigned char> blob(frz.blob_begin(),frz.blob_end());
+	EXPECT_EQ(blob.size(),frz.blob_nbytes());
+
+	jmid::frozen_smf_t loaded;
+	EXPECT_EQ(loaded.nchunks(),0);
+	EXPECT_EQ(loaded.blob_nbytes(),0);
+	EXPECT_EQ(loaded.smf_begin(),loaded.smf_end());
+	ASSERT_TRUE(jmid::make_frozen_smf(blob.data(),blob.data()+blob.size(),&loaded));
+	EXPECT_NE(loaded.blob_begin(),frz.blob_begin());
+	EXPECT_TRUE(std::equal(loaded.blob_begin(),loaded.blob_end(),
+		blob.begin(),blob.end()));
+	EXPECT_EQ(loaded.nevents(),frz.nevents());
+	const auto& e = *(loaded.event_end(2)-2);
+	EXPECT_EQ(loaded.event(e),smf[2][smf[2].size()-2]);
+
+	// Truncated
+	jmid::frozen_smf_t bad;
+	EXPECT_FALSE(jmid::make_frozen_smf(blob.data(),blob.data()+blob.size()-1,&bad));
+	EXPECT_FALSE(jmid::make_frozen_smf(blob.data(),blob.data()+10,&bad));
+	// Bad magic number
+	auto cpy = blob;
+	cpy[0] = 0x00u;
+	EXPECT_FALSE(jmid::make_frozen_smf(cpy.data(),cpy.data()+cpy.size(),&bad));
+	// An event record pointing past the end of its track
+	cpy = blob;
+	auto ev_offset = reinterpret_cast<const unsigned char*>(frz.event_begin(0))
+		- frz.blob_begin();
+	std::int32_t big = 0x7FFFFFF0;
+	std::memcpy(cpy.data()+ev_offset+offsetof(jmid::frozen_smf_t::event_t,nbytes),
+		&big,sizeof(big));
+	EXPECT_FALSE(jmid::make_frozen_smf(cpy.data(),cpy.data()+cpy.size(),&bad));
+	EXPECT_EQ(bad.blob_nbytes(),0);
+
+	auto frz_cpy = frz;
+	EXPECT_NE(frz_cpy.blob_begin(),frz.blob_begin());
+	EXPECT_TRUE(std::equal(frz_cpy.blob_begin(),frz_cpy.blob_end(),
+		frz.blob_begin(),frz.blob_end()));
+	auto p = frz.blob_begin();
+	auto frz_mvd = std::move(frz);
+	EXPECT_EQ(frz_mvd.blob_begin(),p);
+	bad = frz_mvd;
+	EXPECT_EQ(bad.nevents(),frz_mvd.nevents());
+}
+
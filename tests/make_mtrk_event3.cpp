@@ -3,6 +3,7 @@
 #include "midi_raw_test_data.h"
 #include <vector>
 #include <cstdint>
+#include <random>
 
 
 //
@@ -581,3 +582,100 @@ TEST(make_mtrk_event3_tests, RandomMIDIEventsRSandNonRS) {
 	}
 }
 
+
+
+//
+// The overloads of make_mtrk_event3() for const unsigned char* and const 
+// char* must give results identical to the generic template:  the same 
+// event bytes, error code, status & running status in the error object, 
+// and returned iterator.  The generic template is instantiated here w/
+// std::vector<unsigned char>::const_iterator.  
+//
+// Events are randomly generated w/a bias toward valid events of all 
+// types and sizes, but w/ occasional invalid delta times, data bytes, 
+// meta type bytes, and length fields, and w/ random truncation and 
+// trailing data.  
+//
+TEST(make_mtrk_event3_tests, PointerOverloadsMatchGenericTemplate) {
+	std::mt19937 re(20190619);
+	std::uniform_int_distribution<int> rd_byte(0,0xFF);
+	std::uniform_int_distribution<int> rd_pct(0,99);
+	std::uniform_int_distribution<int> rd_dt(0,0x0FFFFFFF);
+	std::uniform_int_distribution<int> rd_len(0,40);
+	auto rd_data = [&]()->unsigned char {
+		auto b = static_cast<unsigned char>(rd_byte(re));
+		return rd_pct(re) < 2 ? b : (b&0x7Fu);
+	};
+	std::vector<unsigned char> rs_vals {0x00u,0x91u,0xC5u,0xE0u,0xF0u,0xFFu};
+	
+	for (int i=0; i<50000; ++i) {
+		std::vector<unsigned char> d;
+		auto dt = rd_dt(re) >> (7*(rd_pct(re)%4));
+		jmid::write_delta_time(dt,std::back_inserter(d));
+		if (rd_pct(re) < 1) {  // Invalid dt
+			d.assign(5,0x80u);
+		}
+		auto kind = rd_pct(re);
+		if (kind < 50) {  // Channel
+			auto s = static_cast<unsigned char>(0x80u + rd_byte(re)%0x70);
+			if (rd_pct(re) < 75) {  // Else in running status
+				d.push_back(s);
+			}
+			d.push_back(rd_data());
+			d.push_back(rd_data());
+		} else if (kind < 80) {  // Meta
+			d.push_back(0xFFu);
+			d.push_back(rd_data());
+			auto len = rd_len(re);
+			jmid::write_vlq(static_cast<std::uint32_t>(len),std::back_inserter(d));
+			for (int j=0; j<len; ++j) {
+				d.push_back(rd_data());
+			}
+		} else if (kind < 95) {  // Sysex
+			d.push_back(rd_pct(re)<50 ? 0xF0u : 0xF7u);
+			auto len = rd_len(re);
+			jmid::write_vlq(static_cast<std::uint32_t>(len),std::back_inserter(d));
+			for (int j=0; j<len; ++j) {
+				d.push_back(rd_data());
+			}
+		} else {  // Garbage
+			for (int j=0; j<rd_len(re); ++j) {
+				d.push_back(static_cast<unsigned char>(rd_byte(re)));
+			}
+		}
+		auto sel = rd_pct(re);
+		if ((sel < 10) && (d.size() > 0)) {  // Truncate
+			d.resize(rd_byte(re)%d.size());
+		} else if (sel < 50) {  // Trailing data
+			for (int j=0; j<rd_len(re)%8; ++j) {
+				d.push_back(static_cast<unsigned char>(rd_byte(re)));
+			}
+		}
+		auto rs = rs_vals[rd_byte(re)%rs_vals.size()];
+
+		jmid::mtrk_event_t expect_ev;
+		jmid::mtrk_event_error_t expect_err;
+		auto expect_it = jmid::make_mtrk_event3(d.cbegin(),d.cend(),rs,
+			&expect_ev,&expect_err);
+
+		const unsigned char *beg = d.data();
+		const unsigned char *end = d.data()+d.size();
+		jmid::mtrk_event_t ev;
+		jmid::mtrk_event_error_t err;
+		auto it = jmid::make_mtrk_event3(beg,end,rs,&ev,&err);
+		ASSERT_EQ(err.code,expect_err.code);
+		EXPECT_EQ(err.s,expect_err.s);
+		EXPECT_EQ(err.rs,expect_err.rs);
+		ASSERT_EQ(it-beg,expect_it-d.cbegin());
+		ASSERT_EQ(ev,expect_ev);
+
+		const char *cbeg = reinterpret_cast<const char*>(d.data());
+		const char *cend = cbeg+d.size();
+		jmid::mtrk_event_t cev;
+		jmid::mtrk_event_error_t cerr;
+		auto cit = jmid::make_mtrk_event3(cbeg,cend,rs,&cev,&cerr);
+		EXPECT_EQ(cerr.code,expect_err.code);
+		EXPECT_EQ(cit-cbeg,expect_it-d.cbegin());
+		EXPECT_EQ(cev,expect_ev);
+	}
+}
@@ -0,0 +1,138 @@
+#include "gtest/gtest.h"
+#include "mtrk_test_data.h"
+#include "mtrk_abstk_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "mtrk_event_methods.h"
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+
+namespace mtrk_abstk_tests {
+// Checks obj against the sequence of {onset tick, event} pairs in expect
+// via to_mtrk(), nticks(), nbytes(), and both overloads of write_mtrk().
+void expect_matches(const jmid::mtrk_abstk_t& obj,
+			const std::vector<std::pair<std::int32_t,jmid::mtrk_event_t>>& expect) {
+	jmid::mtrk_t expect_mtrk;
+	std::int32_t tk = 0;
+	for (const auto& e : expect) {
+		auto ev = e.second;
+		ev.set_delta_time(e.first-tk);
+		expect_mtrk.push_back(ev);
+		tk = e.first;
+	}
+	auto mtrk = obj.to_mtrk();
+	ASSERT_EQ(mtrk.size(),expect_mtrk.size());
+	EXPECT_TRUE(std::equal(mtrk.begin(),mtrk.end(),expect_mtrk.begin()));
+	EXPECT_EQ(obj.size(),expect_mtrk.size());
+	EXPECT_EQ(obj.nticks(),expect_mtrk.nticks());
+	EXPECT_EQ(obj.nbytes(),expect_mtrk.nbytes());
+	EXPECT_EQ(obj.data_nbytes(),expect_mtrk.data_nbytes());
+
+	std::vector<unsigned char> expect_bytes;
+	jmid::write_mtrk(expect_mtrk,std::back_inserter(expect_bytes));
+	std::vector<unsigned char> bytes;
+	jmid::write_mtrk(obj,std::back_inserter(bytes));
+	EXPECT_EQ(bytes,expect_bytes);
+	std::vector<unsigned char> bytes_ptr(obj.nbytes(),0x00u);
+	auto end = jmid::write_mtrk(obj,bytes_ptr.data());
+	EXPECT_EQ(end-bytes_ptr.data(),bytes_ptr.size());
+	EXPECT_EQ(bytes_ptr,expect_bytes);
+}
+}  // namespace mtrk_abstk_tests
+
+
+TEST(mtrk_abstk_tests, RoundTripFromMtrk) {
+	std::mt19937 re(5);
+	for (int n : {0,1,10,500}) {
+		auto mtrk = mtrk_tests::make_random_mtrk(re,n);
+
+		jmid::mtrk_abstk_t obj(mtrk);
+		auto mtrk2 = obj.to_mtrk();
+		ASSERT_EQ(mtrk2.size(),mtrk.size());
+		EXPECT_TRUE(std::equal(mtrk2.begin(),mtrk2.end(),mtrk.begin()));
+		EXPECT_EQ(obj.nticks(),mtrk.nticks());
+		EXPECT_EQ(obj.nbytes(),mtrk.nbytes());
+
+		std::vector<unsigned char> expect_bytes;
+		jmid::write_mtrk(mtrk,std::back_inserter(expect_bytes));
+		std::vector<unsigned char> bytes;
+		jmid::write_mtrk(obj,std::back_inserter(bytes));
+		EXPECT_EQ(bytes,expect_bytes);
+
+		for (int i=0; i<20; ++i) {
+			std::int32_t tk = re()%(mtrk.nticks()+2);
+			auto it = obj.at_tkonset(tk);
+			auto expect = mtrk.at_tkonset(tk);
+			EXPECT_EQ(std::distance(obj.begin(),it),expect.it-mtrk.begin());
+			if (it != obj.end()) {
+				EXPECT_EQ(it->first,expect.tk);
+				EXPECT_EQ(it->second.delta_time(),0);
+			}
+		}
+	}
+}
+
+//
+// Random inserts, erases, moves, and replacements checked against a
+// std::vector of {onset tick, event} kept in order of (onset tick, order of
+// insertion).
+//
+TEST(mtrk_abstk_tests, RandomEditsMatchReference) {
+	std::mt19937 re(17);
+	jmid::mtrk_abstk_t obj;
+	std::vector<std::pair<std::int32_t,jmid::mtrk_event_t>> expect;
+	auto expect_insert = [&expect](std::int32_t tk, jmid::mtrk_event_t ev)->void {
+		ev.set_delta_time(0);
+		auto it = std::upper_bound(expect.begin(),expect.end(),tk,
+			[](std::int32_t lhs, const auto& rhs)->bool { return lhs < rhs.first; });
+		expect.insert(it,{tk,ev});
+	};
+	for (int i=0; i<3000; ++i) {
+		auto sel = re()%8;
+		if ((sel < 4) || expect.empty()) {
+			std::int32_t cumtk = re()%2000;
+			std::int32_t dt = re()%3;
+			auto ev = mtrk_tests::make_random_event(re,dt);
+			auto it = obj.insert(cumtk,ev);
+			EXPECT_EQ(it->first,cumtk+dt);
+			expect_insert(cumtk+dt,ev);
+		} else if (sel < 6) {
+			auto idx = re()%expect.size();
+			auto it = std::next(obj.begin(),idx);
+			auto next = obj.erase(it);
+			expect.erase(expect.begin()+idx);
+			EXPECT_EQ(std::distance(obj.begin(),next),idx);
+		} else if (sel == 6) {
+			auto idx = re()%expect.size();
+			std::int32_t tk = re()%2000;
+			auto it = obj.set_tkonset(std::next(obj.begin(),idx),tk);
+			EXPECT_EQ(it->first,tk);
+			auto ev = expect[idx].second;
+			expect.erase(expect.begin()+idx);
+			expect_insert(tk,ev);
+		} else {
+			auto idx = re()%expect.size();
+			auto ev = mtrk_tests::make_random_event(re,re()%100);
+			auto it = obj.replace(std::next(obj.begin(),idx),ev);
+			EXPECT_EQ(it->first,expect[idx].first);
+			ev.set_delta_time(0);
+			expect[idx].second = ev;
+		}
+		if (i%250 == 0) {
+			mtrk_abstk_tests::expect_matches(obj,expect);
+		}
+	}
+	mtrk_abstk_tests::expect_matches(obj,expect);
+
+	obj.clear();
+	EXPECT_TRUE(obj.empty());
+	EXPECT_EQ(obj.nticks(),0);
+	EXPECT_EQ(obj.nbytes(),8);
+}
+
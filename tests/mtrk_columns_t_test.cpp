@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+#include "mtrk_test_data.h"
+#include "mtrk_columns_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "mtrk_event_methods.h"
+#include "make_mtrk_event.h"
+#include "midi_time.h"
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <random>
+#include <algorithm>
+
+
+namespace mtrk_columns_tests {
+void expect_columns_match_mtrk(const jmid::mtrk_columns_t& cols,
+							const jmid::mtrk_t& mtrk) {
+	ASSERT_EQ(cols.size(),mtrk.size());
+	ASSERT_EQ(cols.payload_offset().size(),mtrk.size()+1);
+	EXPECT_EQ(cols.nticks(),mtrk.nticks());
+	std::int32_t tk = 0;
+	for (int i=0; i<mtrk.size(); ++i) {
+		const auto& ev = mtrk[i];
+		tk += ev.delta_time();
+		EXPECT_EQ(cols.tkonset()[i],tk);
+		EXPECT_EQ(cols.delta_time(i),ev.delta_time());
+		EXPECT_EQ(cols.status()[i],ev.status_byte());
+		if (jmid::is_channel(ev)) {
+			auto p = ev.event_begin();
+			EXPECT_EQ(cols.p1()[i],*(p+1));
+			if (ev.data_size()==3) {
+				EXPECT_EQ(cols.p2()[i],*(p+2));
+			} else {
+				EXPECT_EQ(cols.p2()[i],0);
+			}
+			EXPECT_EQ(cols.payload_begin(i),cols.payload_end(i));
+		} else {
+			auto its = ev.payload_range();
+			EXPECT_TRUE(std::equal(its.begin,its.end,cols.payload_begin(i),
+				cols.payload_end(i)));
+		}
+		EXPECT_EQ(cols.event(i),ev);
+	}
+	auto mtrk2 = cols.to_mtrk();
+	ASSERT_EQ(mtrk2.size(),mtrk.size());
+	EXPECT_TRUE(std::equal(mtrk2.begin(),mtrk2.end(),mtrk.begin()));
+	EXPECT_EQ(mtrk2.nbytes(),mtrk.nbytes());
+}
+}  // namespace mtrk_columns_tests
+
+
+TEST(mtrk_columns_tests, TestSetARoundTrip) {
+	jmid::mtrk_t mtrk;
+	for (const auto& e : mtrk_tests::tsa) {
+		mtrk.push_back(jmid::make_mtrk_event3(e.d.data(),
+			e.d.data()+e.d.size(),0,nullptr));
+	}
+	jmid::mtrk_columns_t cols(mtrk);
+	mtrk_columns_tests::expect_columns_match_mtrk(cols,mtrk);
+	for (std::size_t i=0; i<mtrk_tests::tsa.size(); ++i) {
+		EXPECT_EQ(cols.tkonset()[i],mtrk_tests::tsa[i].cumtk+mtrk[i].delta_time());
+	}
+}
+
+//
+// The columns reproduce the event sequence exactly, and duration() and
+// at_tkonset() agree w/ their mtrk_t counterparts.  
+//
+TEST(mtrk_columns_tests, RandomMtrkRoundTripDurationAtTkonset) {
+	std::mt19937 re(31);
+	auto tdiv = jmid::time_division_t(96);
+	for (int n : {0,1,5,100,2000}) {
+		auto mtrk = mtrk_tests::make_random_mtrk(re,n);
+		jmid::mtrk_columns_t cols(mtrk);
+		mtrk_columns_tests::expect_columns_match_mtrk(cols,mtrk);
+		EXPECT_EQ(jmid::duration(cols,tdiv),jmid::duration(mtrk,tdiv));
+		EXPECT_EQ(jmid::duration(cols,tdiv,120000),
+			jmid::duration(mtrk,tdiv,120000));
+
+		for (int i=0; i<50; ++i) {
+			std::int32_t tk = mtrk.nticks()==0 ? 0 : re()%(mtrk.nticks()+2);
+			auto idx = cols.at_tkonset(tk);
+			auto expect = mtrk.at_tkonset(tk);
+			EXPECT_EQ(idx,expect.it-mtrk.begin());
+			if (idx < cols.size()) {
+				EXPECT_EQ(cols.tkonset()[idx],expect.tk);
+			}
+		}
+
+		// Rebuilding w/ push_back() gives the same columns
+		jmid::mtrk_columns_t cols2;
+		cols2.push_back(jmid::make_eot(1));
+		cols2.clear();
+		EXPECT_EQ(cols2.size(),0);
+		for (const auto& ev : mtrk) {
+			cols2.push_back(ev);
+		}
+		EXPECT_EQ(cols2.tkonset(),cols.tkonset());
+		EXPECT_EQ(cols2.status(),cols.status());
+		EXPECT_EQ(cols2.p1(),cols.p1());
+		EXPECT_EQ(cols2.p2(),cols.p2());
+		EXPECT_EQ(cols2.payload_offset(),cols.payload_offset());
+		EXPECT_EQ(cols2.payload(),cols.payload());
+	}
+}
+
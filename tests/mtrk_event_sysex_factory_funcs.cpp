@@ -3,9 +3,14 @@
 #include "midi_delta_time.h"
 #include "mtrk_event_t.h"
 #include "mtrk_event_methods.h"
+#include "small_bytevec_t.h"
+#include "byte_arena_t.h"
+#include "make_mtrk_event.h"
 #include "sysex_factory_test_data.h"
 #include <vector>
 #include <cstdint>
+#include <string>
+#include <algorithm>
 
 
 // 
@@ -191,3 +196,114 @@ TEST(mtrk_event_sysex_factories, makeSysexF7PayloadsWithTerminalF7) {
 }
 
 
+
+
+//
+// A sysex event w/ a payload too large for the small-object buffer is made
+// w/ exactly one allocation, of exactly the size of the event.  
+//
+TEST(mtrk_event_sysex_factories, makeLargeSysexAllocatesOnce) {
+	std::vector<unsigned char> payload(1000,0x41u);
+	jmid::internal::reset_small_bytevec_stats();
+	auto ev = jmid::make_sysex_f0(0,payload);
+	auto stats = jmid::internal::get_small_bytevec_stats();
+	EXPECT_EQ(stats.n_allocs,1);
+	EXPECT_EQ(stats.n_bytes_allocated,ev.size());
+	EXPECT_EQ(ev.capacity(),ev.size());
+
+	ev.reserve(2000);
+	ev.shrink_to_fit();
+	EXPECT_EQ(ev.capacity(),ev.size());
+	EXPECT_TRUE(jmid::is_sysex_f0(ev));
+	EXPECT_EQ(*(ev.end()-2),0x41u);
+}
+
+//
+// While an intern_scope_t is alive, equal large meta and sysex events, 
+// whether made by the factories or read by make_mtrk_event3(), share a 
+// single buffer; copies of such events do not allocate.  Modifying an 
+// event gives it a buffer of its own.  
+//
+TEST(mtrk_event_sysex_factories, internScopeSharesEqualEvents) {
+	std::vector<unsigned char> payload(200,0x42u);
+	std::string name(50,'n');
+	jmid::internal::byte_intern_t store;
+	std::vector<jmid::mtrk_event_t> evs;
+	{
+		jmid::internal::intern_scope_t scope(&store);
+		for (int i=0; i<10; ++i) {
+			evs.push_back(jmid::make_sysex_f0(0,payload));
+			evs.push_back(jmid::make_text(0,name));
+			evs.push_back(jmid::make_copyright(0,name));
+			// Too small to be interned
+			evs.push_back(jmid::make_text(0,"short"));
+		}
+		std::vector<unsigned char> bytes(evs[0].begin(),evs[0].end());
+		jmid::mtrk_event_error_t err;
+		jmid::mtrk_event_t ev;
+		jmid::make_mtrk_event3(bytes.data(),bytes.data()+bytes.size(),0x00u,
+			&ev,&err);
+		evs.push_back(ev);
+	}
+	EXPECT_EQ(jmid::internal::current_intern_store(),nullptr);
+	EXPECT_EQ(store.size(),3);
+	EXPECT_EQ(store.nhits(),28);
+	const auto& cevs = evs;
+	for (int i=1; i<10; ++i) {
+		EXPECT_EQ(cevs[4*i].data(),cevs[0].data());
+		EXPECT_EQ(cevs[4*i+1].data(),cevs[1].data());
+		EXPECT_EQ(cevs[4*i+2].data(),cevs[2].data());
+		EXPECT_NE(cevs[4*i+3].data(),cevs[3].data());
+		EXPECT_EQ(cevs[4*i+1],jmid::make_text(0,name));
+	}
+	EXPECT_EQ(cevs.back().data(),cevs[0].data());
+	EXPECT_EQ(cevs.back(),jmid::make_sysex_f0(0,payload));
+	EXPECT_NE(cevs[1].data(),cevs[2].data());
+
+	jmid::internal::reset_small_bytevec_stats();
+	auto cpy = evs[0];
+	EXPECT_EQ(jmid::internal::get_small_bytevec_stats().n_allocs,0);
+	EXPECT_EQ(cpy.data(),cevs[0].data());
+	EXPECT_EQ(cpy.delta_time(),0);
+	EXPECT_TRUE(jmid::is_sysex_f0(cpy));
+
+	// Non-const accessors do not detach; mutators do
+	EXPECT_EQ(evs[4].data(),cevs[0].data());
+	EXPECT_EQ(evs[4].payload_begin(),cevs[0].payload_begin());
+	evs[4].set_delta_time(1000);
+	EXPECT_NE(cevs[4].data(),cevs[0].data());
+	EXPECT_EQ(cevs[4].delta_time(),1000);
+	EXPECT_EQ(cevs[0].delta_time(),0);
+	EXPECT_TRUE(std::equal(cevs[4].payload_begin(),cevs[4].end(),
+		cevs[0].payload_begin(),cevs[0].end()));
+	cpy.clear();
+	EXPECT_TRUE(cpy.is_empty());
+	EXPECT_EQ(cevs[0],jmid::make_sysex_f0(0,payload));
+}
+
+//
+// make_mtrk_event3() interns an event only once its payload is complete:
+// A meta or sysex event truncated by the end of the input is reported as
+// an error and leaves nothing in the store.  
+//
+TEST(mtrk_event_sysex_factories, internScopeIgnoresTruncatedEvents) {
+	std::vector<unsigned char> payload(200,0x42u);
+	auto sx = jmid::make_sysex_f0(0,payload);
+	auto txt = jmid::make_text(0,std::string(50,'n'));
+	jmid::internal::byte_intern_t store;
+	jmid::internal::intern_scope_t scope(&store);
+	for (const auto& src : {sx,txt}) {
+		std::vector<unsigned char> bytes(src.begin(),src.end()-10);
+		jmid::mtrk_event_error_t err;
+		jmid::mtrk_event_t ev;
+		jmid::make_mtrk_event3(bytes.data(),bytes.data()+bytes.size(),0x00u,
+			&ev,&err);
+		EXPECT_EQ(err.code,
+			jmid::mtrk_event_error_t::errc::sysex_or_meta_calcd_length_exceeds_input);
+		jmid::make_mtrk_event3(bytes.cbegin(),bytes.cend(),0x00u,&ev,&err);
+		EXPECT_EQ(err.code,
+			jmid::mtrk_event_error_t::errc::sysex_or_meta_calcd_length_exceeds_input);
+	}
+	EXPECT_EQ(store.size(),0);
+	EXPECT_EQ(store.nbytes(),0);
+}
@@ -3,8 +3,10 @@
 #include "mtrk_event_t.h"
 #include "make_mtrk_event.h"
 #include "mtrk_event_methods.h"
+#include "midi_delta_time.h"
 #include <vector>
 #include <cstdint>
+#include <string>
 
 
 //
@@ -338,3 +340,63 @@ TEST(mtrk_event_t_tests, metaEventTypeHasText) {
 }
 
 
+
+//
+// The delta time, status byte and payload offset cached in the object 
+// must agree w/ the values decoded from the event data after each of the
+// operations that modify the event:  construction, set_delta_time(), 
+// reserve(), copy and move, including copies and moves between big and
+// small objects.  
+//
+TEST(mtrk_event_t_tests, CachedFieldsMatchEventData) {
+	auto check = [](const jmid::mtrk_event_t& ev)->void {
+		const unsigned char *beg = ev.data();
+		const unsigned char *end = ev.data()+ev.size();
+		auto dt = jmid::read_delta_time(beg,end);
+		EXPECT_EQ(ev.delta_time(),dt.val);
+		EXPECT_EQ(ev.event_begin()-ev.begin(),dt.N);
+		EXPECT_EQ(ev.status_byte(),*(beg+dt.N));
+		EXPECT_EQ(ev.data_size(),ev.size()-dt.N);
+	};
+	std::vector<std::int32_t> dts {0,1,0x7F,0x80,0x3FFF,0x4000,0x1FFFFF,
+		0x200000,0x0FFFFFFF};
+	std::vector<std::int32_t> meta_lens {0,3,10,18,19,20,40,200};
+	std::vector<jmid::mtrk_event_t> evs;
+	for (const auto& dt : dts) {
+		evs.emplace_back(dt,jmid::ch_event_data_t {0x90,0x01,0x3C,0x40});
+		evs.emplace_back(dt,jmid::ch_event_data_t {0xC0,0x02,0x05,0x00});
+		for (const auto& len : meta_lens) {
+			std::vector<unsigned char> pyld(len,0x41u);
+			evs.push_back(jmid::make_text(dt,std::string(pyld.begin(),pyld.end())));
+		}
+	}
+	for (auto& ev : evs) {
+		check(ev);
+	}
+	for (const auto& dt : dts) {
+		for (auto& ev : evs) {
+			ev.set_delta_time(dt);
+			check(ev);
+		}
+	}
+	for (std::size_t i=0; i<evs.size(); ++i) {
+		for (std::size_t j=0; j<evs.size(); j+=3) {
+			auto a = evs[i];
+			check(a);
+			a = evs[j];
+			check(a);
+			auto b = std::move(a);
+			check(b);
+			b = evs[i];
+			b.reserve(100);
+			check(b);
+			a = std::move(b);
+			check(a);
+		}
+	}
+	jmid::mtrk_event_t ev = evs.back();
+	ev.clear();
+	EXPECT_EQ(ev.size(),0);
+	EXPECT_EQ(ev.event_begin(),ev.end());
+}
+
@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+#include "mtrk_test_data.h"
+#include "mtrk_packed_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "mtrk_event_methods.h"
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <random>
+#include <iterator>
+#include <algorithm>
+
+
+//
+// Round trip through mtrk_packed_t for random tracks of channel events w/
+// both 1 and 2 data bytes, meta events, and sysex events (some too large
+// for the small-object buffer).
+//
+TEST(mtrk_packed_t_tests, RoundTripFromMtrk) {
+	EXPECT_EQ(3*sizeof(jmid::packed_ch_event_t),sizeof(jmid::mtrk_event_t));
+	std::mt19937 re(23);
+	mtrk_tests::random_mtrk_opts_t opts;
+	opts.max_dt = 0x20000;  // Up to 3-byte vlq delta times
+	for (int n : {0,1,10,2000}) {
+		auto mtrk = mtrk_tests::make_random_mtrk(re,n,opts);
+		auto n_side = std::count_if(mtrk.begin(),mtrk.end(),
+			[](const jmid::mtrk_event_t& ev)->bool { return !jmid::is_channel(ev); });
+
+		jmid::mtrk_packed_t pk(mtrk);
+		ASSERT_EQ(pk.size(),mtrk.size());
+		EXPECT_EQ(pk.side_size(),n_side);
+		EXPECT_EQ(pk.nticks(),mtrk.nticks());
+		EXPECT_EQ(pk.nbytes(),mtrk.nbytes());
+		EXPECT_EQ(pk.data_nbytes(),mtrk.data_nbytes());
+		for (int i=0; i<mtrk.size(); ++i) {
+			const auto& e = pk[i];
+			EXPECT_EQ(e.delta_time,mtrk[i].delta_time());
+			EXPECT_EQ(e.status,mtrk[i].status_byte());
+			EXPECT_EQ(pk.is_channel(e),jmid::is_channel(mtrk[i]));
+			if (!pk.is_channel(e)) {
+				EXPECT_EQ(pk.side_event(e).delta_time(),0);
+			}
+			EXPECT_EQ(pk.event(e),mtrk[i]);
+		}
+
+		auto mtrk2 = pk.to_mtrk();
+		ASSERT_EQ(mtrk2.size(),mtrk.size());
+		EXPECT_TRUE(std::equal(mtrk2.begin(),mtrk2.end(),mtrk.begin()));
+
+		std::vector<unsigned char> expect_bytes;
+		jmid::write_mtrk(mtrk,std::back_inserter(expect_bytes));
+		std::vector<unsigned char> bytes;
+		jmid::write_mtrk(pk,std::back_inserter(bytes));
+		EXPECT_EQ(bytes,expect_bytes);
+
+		pk.clear();
+		EXPECT_EQ(pk.size(),0);
+		EXPECT_EQ(pk.side_size(),0);
+		EXPECT_EQ(pk.nticks(),0);
+		EXPECT_EQ(pk.nbytes(),8);
+	}
+}
+
@@ -4,10 +4,15 @@
 #include "mtrk_event_t.h"
 #include "make_mtrk_event.h"
 #include "mtrk_event_methods.h"
+#include "midi_delta_time.h"
 #include <vector>
 #include <cstdint>
 #include <iterator>
 #include <iostream>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <random>
 
 using namespace mtrk_tests;
 
@@ -250,3 +255,188 @@ TEST(mtrk_t_tests, MergeMtrkTSBMetaEventsSplitProducts) {
 }
 
 
+
+//
+// split_move_if() and merge_move() produce the same sequences as 
+// split_copy_if() and merge(), w/o reallocating the data of big events.  
+// The rvalue push_back()/insert() and emplace_back() give the same events
+// as their copying counterparts.  
+//
+TEST(mtrk_t_tests, MoveVariantsMatchCopyingVariants) {
+	auto mtrk_b = make_mtrk_tsb(tsb);
+	// Sprinkle in some big events
+	std::string txt(60,'t');
+	for (int i=0; i<mtrk_b.size(); i+=5) {
+		mtrk_b.insert(mtrk_b.begin()+i,jmid::make_text(i%3,txt));
+	}
+	auto is_big_or_67 = [](const jmid::mtrk_event_t& ev)->bool {
+		if (ev.size() > 23) {
+			return true;
+		}
+		auto md = jmid::get_channel_event(ev);
+		return (jmid::is_channel_voice(ev) && (md.p1==67));
+	};
+
+	auto expect_rest = mtrk_b;
+	auto expect_split = jmid::split_copy_if(mtrk_b,is_big_or_67);
+	auto rest_it = jmid::split_if(expect_rest.begin(),expect_rest.end(),
+		[&](const jmid::mtrk_event_t& ev)->bool { return !is_big_or_67(ev); });
+	expect_rest = jmid::mtrk_t(expect_rest.begin(),rest_it);
+
+	// The data of a big event is only reallocated if its new delta time 
+	// needs a longer vlq field than the original
+	struct big_data_t {
+		const unsigned char *p;
+		std::int32_t dt_sz;
+	};
+	auto get_big_data = [](const jmid::mtrk_t& mtrk)->std::vector<big_data_t> {
+		std::vector<big_data_t> result;
+		for (const auto& ev : mtrk) {
+			if (ev.size() > 23) {
+				result.push_back({ev.data(),
+					jmid::delta_time_field_size(ev.delta_time())});
+			}
+		}
+		return result;
+	};
+	auto expect_not_reallocated = [](const std::vector<big_data_t>& before,
+								const std::vector<big_data_t>& after)->void {
+		ASSERT_EQ(before.size(),after.size());
+		for (std::size_t i=0; i<before.size(); ++i) {
+			if (after[i].dt_sz <= before[i].dt_sz) {
+				EXPECT_EQ(after[i].p,before[i].p);
+			}
+		}
+	};
+	auto src = mtrk_b;
+	auto big_data = get_big_data(src);
+	jmid::mtrk_t split;
+	jmid::split_move_if(src.begin(),src.end(),std::back_inserter(split),
+		is_big_or_67);
+	ASSERT_EQ(split.size(),expect_split.size());
+	EXPECT_TRUE(std::equal(split.begin(),split.end(),expect_split.begin()));
+	auto split_big_data = get_big_data(split);
+	expect_not_reallocated(big_data,split_big_data);
+	// The events not moved have their original delta times; the moved-from
+	// events are empty
+	jmid::mtrk_t rest;
+	for (const auto& ev : static_cast<const jmid::mtrk_t&>(src)) {
+		if (!ev.is_empty()) {
+			rest.push_back(ev);
+		}
+	}
+	ASSERT_EQ(rest.size(),mtrk_b.size()-split.size());
+
+	// merge_move() of the two halves; rest needs its delta times adjusted
+	// for the events that were removed, which expect_rest has.  
+	jmid::mtrk_t expect_merged;
+	jmid::merge(expect_rest.begin(),expect_rest.end(),
+		expect_split.begin(),expect_split.end(),
+		std::back_inserter(expect_merged));
+	jmid::mtrk_t merged;
+	jmid::merge_move(expect_rest.begin(),expect_rest.end(),
+		split.begin(),split.end(),std::back_inserter(merged));
+	ASSERT_EQ(merged.size(),expect_merged.size());
+	EXPECT_TRUE(std::equal(merged.begin(),merged.end(),expect_merged.begin()));
+	EXPECT_EQ(merged.nticks(),expect_merged.nticks());
+	EXPECT_EQ(merged.nbytes(),expect_merged.nbytes());
+	expect_not_reallocated(split_big_data,get_big_data(merged));
+	for (const auto& ev : static_cast<const jmid::mtrk_t&>(split)) {
+		EXPECT_TRUE(ev.is_empty());
+	}
+
+	// rvalue push_back()/insert(), emplace_back()
+	jmid::mtrk_t a;  jmid::mtrk_t b;
+	auto big = jmid::make_text(5,txt);
+	auto p = big.data();
+	a.push_back(big);
+	EXPECT_EQ(b.push_back(std::move(big)).data(),p);
+	a.insert(a.begin(),jmid::make_tempo(0,400000));
+	auto tempo = jmid::make_tempo(0,400000);
+	b.insert(b.begin(),std::move(tempo));
+	jmid::ch_event_data_t md {0x90u,0x01u,0x3Cu,0x40u};
+	a.push_back(jmid::mtrk_event_t(12,md));
+	b.emplace_back(12,md);
+	a.push_back(jmid::make_text(3,txt));
+	b.emplace_back(3,jmid::meta_header(0x01u,static_cast<std::int32_t>(txt.size())),
+		reinterpret_cast<const unsigned char*>(txt.data()),
+		reinterpret_cast<const unsigned char*>(txt.data()+txt.size()));
+	std::vector<unsigned char> sx {0x01u,0x02u,0xF7u};
+	a.push_back(jmid::make_sysex_f0(7,sx));
+	b.emplace_back(7,jmid::sysex_header(0xF0u,std::int32_t{3}),sx.data(),sx.data()+sx.size());
+	ASSERT_EQ(a.size(),b.size());
+	EXPECT_TRUE(std::equal(a.begin(),a.end(),b.begin()));
+	EXPECT_EQ(a.nbytes(),b.nbytes());
+	EXPECT_EQ(a.nticks(),b.nticks());
+}
+
+//
+// The N-ary merge(), merge_move(), and merge_parallel() give the same 
+// sequence as merging the tracks one at a time w/ the 2-range merge().  
+// Many events fall on the same ticks, so blocks w/ the same onset in 
+// different tracks are common.  
+//
+TEST(mtrk_t_tests, MergeNTracksMatchesPairwiseMerge) {
+	std::mt19937 re(17);
+	std::vector<jmid::mtrk_t> trks;
+	mtrk_tests::random_mtrk_opts_t opts;
+	opts.max_dt = 30;
+	opts.dt_step = 10;
+	opts.w_sysex = 0;
+	opts.eot = false;
+	for (int i=0; i<23; ++i) {
+		opts.ch = i%16;
+		int n = (i%7==3) ? 0 : re()%200;  // Some empty tracks
+		trks.push_back(mtrk_tests::make_random_mtrk(re,n,opts));
+	}
+
+	jmid::mtrk_t expect;
+	for (const auto& trk : trks) {
+		const auto& prev = expect;
+		jmid::mtrk_t curr;
+		jmid::merge(prev.begin(),prev.end(),trk.begin(),trk.end(),
+			std::back_inserter(curr));
+		expect = std::move(curr);
+	}
+	std::int32_t nticks = 0;
+	for (const auto& trk : trks) {
+		nticks = std::max(nticks,trk.nticks());
+	}
+	EXPECT_EQ(expect.nticks(),nticks);
+
+	const auto& ctrks = trks;
+	jmid::mtrk_t merged;
+	jmid::merge(ctrks.begin(),ctrks.end(),std::back_inserter(merged));
+	ASSERT_EQ(merged.size(),expect.size());
+	EXPECT_TRUE(std::equal(merged.begin(),merged.end(),expect.begin()));
+
+	for (int nthreads : {0,1,2,3,8,50}) {
+		jmid::mtrk_t par;
+		jmid::merge_parallel(ctrks.begin(),ctrks.end(),std::back_inserter(par),
+			nthreads);
+		ASSERT_EQ(par.size(),expect.size());
+		EXPECT_TRUE(std::equal(par.begin(),par.end(),expect.begin()));
+	}
+
+	// Fewer tracks than threads; no tracks
+	jmid::mtrk_t par3;
+	jmid::merge_parallel(ctrks.begin(),ctrks.begin()+3,std::back_inserter(par3),8);
+	jmid::mtrk_t expect3;
+	jmid::merge(ctrks.begin(),ctrks.begin()+3,std::back_inserter(expect3));
+	ASSERT_EQ(par3.size(),expect3.size());
+	EXPECT_TRUE(std::equal(par3.begin(),par3.end(),expect3.begin()));
+	jmid::mtrk_t none;
+	jmid::merge_parallel(ctrks.begin(),ctrks.begin(),std::back_inserter(none),4);
+	EXPECT_EQ(none.size(),0);
+
+	auto src = trks;
+	jmid::mtrk_t moved;
+	jmid::merge_move(src.begin(),src.end(),std::back_inserter(moved));
+	ASSERT_EQ(moved.size(),expect.size());
+	EXPECT_TRUE(std::equal(moved.begin(),moved.end(),expect.begin()));
+	for (const auto& trk : src) {
+		EXPECT_TRUE(std::all_of(trk.begin(),trk.end(),
+			[](const jmid::mtrk_event_t& ev)->bool { return ev.is_empty(); }));
+	}
+}
+
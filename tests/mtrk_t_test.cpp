@@ -4,8 +4,14 @@
 #include "mtrk_event_t.h"
 #include "make_mtrk_event.h"
 #include "aux_types.h"
+#include "mtrk_event_methods.h"
 #include <vector>
 #include <cstdint>
+#include <random>
+#include <utility>
+#include <algorithm>
+#include <string>
+#include <iterator>  // std::back_inserter
 
 using namespace mtrk_tests;
 
@@ -373,3 +379,794 @@ TEST(mtrk_t_tests, InsertWithNzeroDtIntoTSAMethodInsertNoTkShift) {
 }
 
 
+
+//
+// count_mtrk_events(), make_mtrk_event_seq()
+//
+TEST(mtrk_t_tests, CountMtrkEventsTestSetA) {
+	std::vector<unsigned char> bytes;
+	for (const auto& e : tsa) {
+		bytes.insert(bytes.end(),e.d.begin(),e.d.end());
+	}
+	const unsigned char *beg = bytes.data();
+	auto n = jmid::count_mtrk_events(beg,beg+bytes.size(),0x00u);
+	EXPECT_EQ(n,tsa.size());
+
+	// Data following the EOT is not counted
+	bytes.insert(bytes.end(),{0x00u,0x90u,0x3Cu,0x40u});
+	beg = bytes.data();
+	n = jmid::count_mtrk_events(beg,beg+bytes.size(),0x00u);
+	EXPECT_EQ(n,tsa.size());
+
+	jmid::mtrk_t mtrk;
+	jmid::mtrk_error_t err;
+	auto it = jmid::make_mtrk_event_seq(beg,beg+bytes.size(),0x00u,
+		&mtrk,&err);
+	EXPECT_EQ(err.code,jmid::mtrk_error_t::errc::no_error);
+	EXPECT_EQ(it,beg+bytes.size()-4);
+	EXPECT_EQ(mtrk.size(),tsa.size());
+	EXPECT_EQ(mtrk.capacity(),mtrk.size());  // Exactly one allocation
+	for (int i=0; i<tsa.size(); ++i) {
+		auto curr_ev = jmid::make_mtrk_event3(tsa[i].d.data(),
+			tsa[i].d.data()+tsa[i].d.size(),0,nullptr);
+		EXPECT_EQ(mtrk[i],curr_ev);
+	}
+}
+
+TEST(mtrk_t_tests, CountMtrkEventsRunningStatusAndTruncation) {
+	std::vector<unsigned char> bytes {
+		0x00, 0xFF, 0x03, 0x02, 0x41, 0x42,  // Seq/track name "AB"
+		0x00, 0xF0, 0x03, 0x7E, 0x7F, 0xF7,  // Sysex
+		0x00, 0x90, 0x3C, 0x40,
+		0x60, 0x3E, 0x40,  // running status
+		0x00, 0xC0, 0x06,  // Program change
+		0x10, 0x07,  // running status
+		0x60, 0x80, 0x3C, 0x40,
+		0x00, 0x3E, 0x40,  // running status
+		0x00, 0xFF, 0x2F, 0x00
+	};
+	const unsigned char *beg = bytes.data();
+	EXPECT_EQ(jmid::count_mtrk_events(beg,beg+bytes.size(),0x00u),9);
+	
+	// For each truncation of the sequence, the count is an upper bound on
+	// the number of events that make_mtrk_event_seq() reads, and a reused 
+	// mtrk_t is resized to the number of events read.  
+	jmid::mtrk_t mtrk;
+	for (int i=0; i<=bytes.size(); ++i) {
+		auto n = jmid::count_mtrk_events(beg,beg+i,0x00u);
+		jmid::mtrk_error_t err;
+		jmid::make_mtrk_event_seq(beg,beg+i,0x00u,&mtrk,&err);
+		EXPECT_GE(n,mtrk.size());
+		EXPECT_LE(n-mtrk.size(),1);
+	}
+	EXPECT_EQ(mtrk.size(),9);
+}
+
+TEST(mtrk_t_tests, EstimateNMtrkEvents) {
+	EXPECT_EQ(jmid::estimate_n_mtrk_events(0),0);
+	EXPECT_EQ(jmid::estimate_n_mtrk_events(-1),0);
+	EXPECT_GE(jmid::estimate_n_mtrk_events(4),1);
+	EXPECT_GE(jmid::estimate_n_mtrk_events(3000),1000);
+	EXPECT_EQ(jmid::estimate_n_mtrk_events(jmid::mtrk_t::length_max),
+		jmid::estimate_n_mtrk_events_max);
+}
+
+//
+// nbytes(), data_nbytes(), and nticks() agree w/ a direct summation over
+// the events after an arbitrary sequence of modifications, including 
+// modifications made through references and iterators obtained after the
+// totals were last recomputed, and changes of delta time that change the
+// size of an event.  
+//
+TEST(mtrk_t_tests, NbytesAndNticksMatchSummation) {
+	auto check = [](const jmid::mtrk_t& trk)->void {
+		std::int32_t nbytes = 8;
+		std::int32_t nticks = 0;
+		for (const auto& ev : trk) {
+			nbytes += ev.size();
+			nticks += ev.delta_time();
+		}
+		ASSERT_EQ(trk.nbytes(),nbytes);
+		ASSERT_EQ(trk.data_nbytes(),nbytes-8);
+		ASSERT_EQ(trk.nticks(),nticks);
+	};
+
+	auto trk = make_tsa();
+	check(trk);
+	std::mt19937 re(9);
+	std::uniform_int_distribution<int> rd_op(0,13);
+	std::uniform_int_distribution<int> rd_dt(0,0x3FFF);
+	for (int i=0; i<2000; ++i) {
+		auto op = rd_op(re);
+		std::int32_t idx = trk.size()==0 ? 0 : re()%trk.size();
+		auto dt = rd_dt(re) >> (re()%14);
+		if (op==0) {
+			trk.push_back(make_tsa()[re()%make_tsa().size()]);
+		} else if ((op==1) && (trk.size()>0)) {
+			trk.pop_back();
+		} else if (op==2) {
+			auto ev = make_tsa()[0];
+			ev.set_delta_time(dt);
+			trk.insert(trk.begin()+idx,ev);
+		} else if (op==3) {
+			trk.insert_no_tkshift(trk.begin()+idx,jmid::make_eot(dt));
+		} else if (op==4) {
+			trk.insert(dt,jmid::make_tempo(dt,500000));
+		} else if ((op==5) && (trk.size()>0)) {
+			if (re()%2) {
+				trk.erase(trk.begin()+idx);
+			} else {
+				trk.erase(std::as_const(trk).begin()+idx);
+			}
+		} else if ((op==6) && (trk.size()>0)) {
+			trk.erase_no_tkshift(trk.begin()+idx);
+		} else if ((op==7) && (trk.size()>0)) {
+			trk.set_delta_time(trk.begin()+idx,dt);
+		} else if ((op==8) && (trk.size()>0)) {
+			ASSERT_EQ(trk.nbytes(),std::as_const(trk).nbytes());  // Recomputes
+			auto it = trk.begin()+idx;
+			check(trk);
+			it->set_delta_time(dt);  // Through an iterator
+			check(trk);
+			trk[idx].set_delta_time(dt>>1);  // Through a reference
+		} else if (op==9) {
+			trk.resize(trk.size() > 3 ? trk.size()-3 : trk.size()+2);
+		} else if (op==10) {
+			auto cpy = trk;
+			check(cpy);
+			auto mvd = std::move(cpy);
+			check(mvd);
+		} else if (op==11) {
+			// Through the reference returned by push_back()
+			auto& ev = trk.push_back(jmid::make_tempo(0,500000));
+			check(trk);
+			ev.set_delta_time(dt);
+			check(trk);
+			ASSERT_EQ(trk.nbytes(),std::as_const(trk).nbytes());
+		} else if (op==12) {
+			// Through the iterators returned by the modifiers
+			auto it = trk.insert(dt,jmid::make_tempo(0,500000));
+			it->set_delta_time(dt>>1);
+			check(trk);
+			it = trk.set_delta_time(it,dt);
+			it->set_delta_time(dt>>2);
+			check(trk);
+			it = trk.erase(it);
+			if (jmid::mtrk_t::const_iterator(it) != std::as_const(trk).end()) {
+				it->set_delta_time(dt);
+			}
+		} else if (op==13) {
+			// Through the iterator returned by a lookup
+			auto r = trk.at_cumtk(dt);
+			if (jmid::mtrk_t::const_iterator(r.it) != std::as_const(trk).end()) {
+				r.it->set_delta_time(dt>>1);
+			}
+		}
+		check(trk);
+	}
+	trk.clear();
+	check(trk);
+}
+
+//
+// An event modified through the reference or iterator returned by a 
+// modifier is reflected in nticks(), nbytes(), the tick index, and the 
+// length field written by write_mtrk().  
+//
+TEST(mtrk_t_tests, ModificationThroughHandleReturnedByModifier) {
+	jmid::mtrk_t trk;
+	for (int i=0; i<50; ++i) {
+		trk.push_back(jmid::make_note_on(1,0,60,100));
+	}
+	trk.set_tk_index_enabled(true);
+	const auto& ctrk = trk;
+	ASSERT_EQ(trk.nticks(),50);
+
+	auto it = trk.insert(25,jmid::make_tempo(5,500000));
+	it->set_delta_time(1000);
+	EXPECT_EQ(ctrk.nticks(),1050);
+	EXPECT_EQ(trk.nticks(),1050);
+	auto& ev = trk.push_back(jmid::make_eot(0));
+	ev.set_delta_time(200);  // 2-byte vlq
+	EXPECT_EQ(ctrk.nticks(),1250);
+	EXPECT_EQ(ctrk.at_tkonset(1250).it-ctrk.begin(),51);
+	EXPECT_EQ(trk.at_cumtk(1050).tk,1050);
+	EXPECT_EQ(trk.nticks(),1250);
+
+	std::int32_t nbytes = 8;
+	std::int32_t nticks = 0;
+	for (const auto& e : ctrk) {
+		nbytes += e.size();
+		nticks += e.delta_time();
+	}
+	EXPECT_EQ(nticks,1250);
+	EXPECT_EQ(ctrk.nbytes(),nbytes);
+	std::vector<unsigned char> expect;
+	jmid::write_mtrk(ctrk,std::back_inserter(expect));
+	ASSERT_EQ(expect.size(),nbytes);
+	std::vector<unsigned char> buf(trk.nbytes());
+	EXPECT_EQ(jmid::write_mtrk(ctrk,buf.data()),buf.data()+buf.size());
+	EXPECT_EQ(buf,expect);
+}
+
+//
+// write_mtrk(const mtrk_t&, unsigned char*) writes exactly nbytes() 
+// bytes after a delta time was lengthened through an iterator.  The const
+// size queries do not clear the stale totals; the first non-const query
+// does.  
+//
+TEST(mtrk_t_tests, WriteMtrkPtrAfterModificationThroughIterator) {
+	auto trk = make_tsa();
+	auto nbytes_before = trk.nbytes();
+	auto nticks_before = trk.nticks();
+	auto it = trk.begin();
+	auto dt_before = it->delta_time();
+	it->set_delta_time(100000);  // 1-byte vlq -> 3-byte vlq
+	const auto& ctrk = trk;
+	ASSERT_EQ(ctrk.nbytes(),nbytes_before+2);
+	ASSERT_EQ(ctrk.nticks(),nticks_before+100000-dt_before);
+	ASSERT_EQ(trk.nbytes(),nbytes_before+2);
+	ASSERT_EQ(ctrk.nbytes(),nbytes_before+2);
+	ASSERT_EQ(trk.nticks(),nticks_before+100000-dt_before);
+	auto cpy = trk;
+	EXPECT_EQ(cpy.nbytes(),trk.nbytes());
+	EXPECT_EQ(cpy.nticks(),trk.nticks());
+
+	std::vector<unsigned char> buf(trk.nbytes());
+	auto end = jmid::write_mtrk(trk,buf.data());
+	EXPECT_EQ(end-buf.data(),trk.nbytes());
+	std::vector<unsigned char> expect;
+	jmid::write_mtrk(trk,std::back_inserter(expect));
+	EXPECT_EQ(buf,expect);
+}
+
+//
+// With the arena enabled, the events read by make_mtrk_event_seq() are 
+// identical to those read w/o an arena, but the buffers of the 'big' 
+// events are drawn from the arena.  Reading into the same container 
+// again reuses the arena memory.  Copies do not refer to the arena.  
+//
+TEST(mtrk_t_tests, ArenaEnabledMakeMtrkEventSeqMatchesHeap) {
+	auto is_eq = [](const jmid::mtrk_t& lhs, const jmid::mtrk_t& rhs)->bool {
+		return (lhs.size()==rhs.size()) 
+			&& std::equal(lhs.begin(),lhs.end(),rhs.begin());
+	};
+
+	jmid::mtrk_t src;
+	for (int i=0; i<300; ++i) {
+		src.push_back(jmid::make_lyric(i%7,std::string(i%61,'a'+(i%26))));
+		src.push_back(jmid::make_note_on(0,i%16,i%128,64));
+	}
+	src.push_back(jmid::make_eot(0));
+	std::vector<unsigned char> bytes(src.nbytes());
+	jmid::write_mtrk(src,bytes.data());
+	const unsigned char *beg = bytes.data()+8;
+	const unsigned char *end = bytes.data()+bytes.size();
+
+	jmid::mtrk_t expect;
+	jmid::mtrk_error_t err;
+	jmid::make_mtrk_event_seq(beg,end,0x00u,&expect,&err);
+	ASSERT_EQ(err.code,jmid::mtrk_error_t::errc::no_error);
+	ASSERT_TRUE(is_eq(expect,src));
+	EXPECT_FALSE(expect.arena_enabled());
+	EXPECT_EQ(expect.arena(),nullptr);
+
+	std::int64_t nbytes_big = 0;
+	for (const auto& ev : expect) {
+		if (ev.size() > jmid::internal::small_bytevec_t::capacity_small) {
+			nbytes_big += ev.size();
+		}
+	}
+	ASSERT_GT(nbytes_big,0);
+
+	jmid::mtrk_t trk;
+	trk.set_arena_enabled(true);
+	ASSERT_NE(trk.arena(),nullptr);
+	for (int i=0; i<3; ++i) {
+		auto it = jmid::make_mtrk_event_seq(beg,end,0x00u,&trk,&err);
+		ASSERT_EQ(err.code,jmid::mtrk_error_t::errc::no_error);
+		EXPECT_EQ(it,end);
+		EXPECT_TRUE(is_eq(trk,expect));
+		EXPECT_EQ(trk.nbytes(),expect.nbytes());
+		EXPECT_EQ(trk.arena()->nbytes_allocated(),nbytes_big);
+		EXPECT_EQ(trk.arena()->nblocks(),1);
+	}
+
+	// Copies hold ordinary events, and are unaffected when the original
+	// is cleared
+	auto cpy = trk;
+	EXPECT_FALSE(cpy.arena_enabled());
+	trk.clear();
+	EXPECT_EQ(trk.arena()->nbytes_allocated(),0);
+	EXPECT_TRUE(is_eq(cpy,expect));
+
+	// Moving the container moves the arena
+	jmid::make_mtrk_event_seq(beg,end,0x00u,&trk,&err);
+	auto mvd = std::move(trk);
+	EXPECT_TRUE(mvd.arena_enabled());
+	EXPECT_TRUE(is_eq(mvd,expect));
+	
+	// Modifying an event in the arena in place, and replacing one w/ a
+	// larger event
+	auto idx = mvd.size()-3;
+	ASSERT_GT(mvd[idx].size(),jmid::internal::small_bytevec_t::capacity_small);
+	mvd[idx] = jmid::make_lyric(0,std::string(2000,'z'));
+	EXPECT_EQ(mvd[idx],jmid::make_lyric(0,std::string(2000,'z')));
+	mvd[idx] = expect[idx];
+	EXPECT_TRUE(is_eq(mvd,expect));
+
+	// Events are moved out of the arena before it is freed
+	mvd.set_arena_enabled(false);
+	EXPECT_EQ(mvd.arena(),nullptr);
+	EXPECT_TRUE(is_eq(mvd,expect));
+}
+
+//
+// Events moved out of a track w/ arena_enabled() by push_back(), insert()
+// and merge_move(), or moved out and then detach_arena()ed, get a copy of
+// their data and remain valid after the track is destroyed; moves within 
+// the track made by its own modifiers do not reallocate.  
+//
+TEST(mtrk_t_tests, ArenaEnabledEventsMovedOutOutliveTrack) {
+	jmid::mtrk_t src;
+	for (int i=0; i<40; ++i) {
+		src.push_back(jmid::make_text(i,std::string(30+i,'a'+(i%26))));
+		src.push_back(jmid::make_note_on(0,i%16,i%128,64));
+	}
+	src.push_back(jmid::make_eot(0));
+	std::vector<unsigned char> bytes(src.nbytes());
+	jmid::write_mtrk(src,bytes.data());
+
+	jmid::mtrk_t dest;
+	std::vector<jmid::mtrk_event_t> merged;
+	jmid::mtrk_event_t ev;
+	{
+		jmid::mtrk_t trk;
+		trk.set_arena_enabled(true);
+		jmid::mtrk_error_t err;
+		jmid::make_mtrk_event_seq(bytes.data()+8,bytes.data()+bytes.size(),
+			0x00u,&trk,&err);
+		ASSERT_EQ(err.code,jmid::mtrk_error_t::errc::no_error);
+		ASSERT_EQ(trk.size(),src.size());
+
+		auto nallocs = jmid::internal::get_small_bytevec_stats().n_allocs;
+		trk.insert(trk.begin(),jmid::make_note_on(0,0,60,64));
+		trk.erase(trk.begin());
+		trk.reserve(4*trk.size());
+		EXPECT_EQ(jmid::internal::get_small_bytevec_stats().n_allocs,nallocs);
+
+		dest.push_back(std::move(trk[0]));
+		dest.insert(dest.begin(),std::move(trk[2]));
+		ev = std::move(trk[4]);
+		EXPECT_EQ(ev,src[4]);
+		ev.detach_arena();
+		auto trk2 = trk;
+		jmid::merge_move(trk.begin()+6,trk.end(),trk2.begin()+6,trk2.end(),
+			std::back_inserter(merged));
+	}
+	ASSERT_EQ(dest.size(),2);
+	EXPECT_EQ(dest[0],src[2]);
+	EXPECT_EQ(dest[1],src[0]);
+	EXPECT_EQ(ev,src[4]);
+	ASSERT_EQ(merged.size(),2*(src.size()-6));
+	for (const auto& e : merged) {
+		auto is_same_payload = [&e](const jmid::mtrk_event_t& s)->bool {
+			return std::equal(e.payload_begin(),e.end(),
+				s.payload_begin(),s.end());
+		};
+		EXPECT_TRUE(std::any_of(src.begin()+6,src.end(),is_same_payload));
+	}
+}
+
+//
+// w/ the tick index enabled, at_cumtk(), at_tkonset(), insert(int32_t,...),
+// and get_simultaneous_events() give the same results as w/o, including
+// after modifications that patch the index in place (push_back(), 
+// pop_back(), set_delta_time(), erase(), insert(), ...) and that rebuild
+// it (resize(), set_tk_index_enabled(true) after a change made through a
+// reference).  
+//
+TEST(mtrk_t_tests, TkIndexMatchesLinearSearch) {
+	std::mt19937 re(7);
+	jmid::mtrk_t lin;
+	for (int i=0; i<300; ++i) {
+		std::int32_t dt = (re()%3==0) ? 0 : re()%200;
+		lin.push_back(jmid::make_note_on(dt,re()%16,re()%128,re()%128));
+	}
+	jmid::mtrk_t idx = lin;
+	EXPECT_FALSE(idx.tk_index_enabled());
+	idx.set_tk_index_enabled(true);
+	EXPECT_TRUE(idx.tk_index_enabled());
+
+	auto expect_same = [&re](jmid::mtrk_t& lin, jmid::mtrk_t& idx)->void {
+		ASSERT_EQ(lin.size(),idx.size());
+		const auto& clin = lin;
+		const auto& cidx = idx;
+		for (int i=0; i<40; ++i) {
+			std::int32_t tk = static_cast<std::int32_t>(re()%(lin.nticks()+3))-1;
+			auto a = clin.at_cumtk(tk);
+			auto b = cidx.at_cumtk(tk);
+			EXPECT_EQ(a.it-clin.begin(),b.it-cidx.begin());
+			EXPECT_EQ(a.tk,b.tk);
+			a = clin.at_tkonset(tk);
+			b = cidx.at_tkonset(tk);
+			EXPECT_EQ(a.it-clin.begin(),b.it-cidx.begin());
+			EXPECT_EQ(a.tk,b.tk);
+			auto c = lin.at_tkonset(tk);
+			auto d = idx.at_tkonset(tk);
+			EXPECT_EQ(c.it-lin.begin(),d.it-idx.begin());
+			EXPECT_EQ(c.tk,d.tk);
+			c = lin.at_cumtk(tk);
+			d = idx.at_cumtk(tk);
+			EXPECT_EQ(c.it-lin.begin(),d.it-idx.begin());
+			EXPECT_EQ(c.tk,d.tk);
+		}
+		for (int i=0; i<=cidx.size(); ++i) {
+			auto a = jmid::get_simultaneous_events(clin.begin()+i,clin.end());
+			auto b = jmid::get_simultaneous_events(cidx,cidx.begin()+i);
+			EXPECT_EQ(a-clin.begin(),b-cidx.begin());
+		}
+	};
+
+	expect_same(lin,idx);
+	for (int i=0; i<200; ++i) {
+		auto sel = re()%8;
+		if (sel == 0) {
+			auto ev = jmid::make_note_off(re()%50,re()%16,re()%128,re()%128);
+			lin.push_back(ev);
+			idx.push_back(ev);
+		} else if (sel == 1 && lin.size() > 0) {
+			lin.pop_back();
+			idx.pop_back();
+		} else if (sel == 2 && lin.size() > 0) {
+			auto j = re()%lin.size();
+			std::int32_t dt = re()%100;
+			lin.set_delta_time(lin.begin()+j,dt);
+			idx.set_delta_time(idx.begin()+j,dt);
+		} else if (sel == 3 && lin.size() > 0) {
+			auto j = re()%lin.size();
+			lin.erase(lin.begin()+j);
+			idx.erase(idx.begin()+j);
+		} else if (sel == 4 && lin.size() > 0) {
+			auto j = re()%lin.size();
+			if (re()%2) {
+				lin.erase_no_tkshift(lin.begin()+j);
+				idx.erase_no_tkshift(idx.begin()+j);
+			} else {
+				auto ev = jmid::make_note_on(re()%60,re()%16,re()%128,re()%128);
+				lin.insert_no_tkshift(lin.begin()+j,ev);
+				idx.insert_no_tkshift(idx.begin()+j,ev);
+			}
+		} else if (sel == 5 && lin.size() > 0) {
+			auto j = re()%lin.size();
+			auto ev = jmid::make_note_on(re()%60,re()%16,re()%128,re()%128);
+			lin.insert(lin.begin()+j,ev);
+			idx.insert(idx.begin()+j,ev);
+		} else if (sel == 6 && lin.size() > 0) {
+			// Through a reference; the index must be rebuilt
+			auto j = re()%lin.size();
+			std::int32_t dt = re()%100;
+			lin[j].set_delta_time(dt);
+			idx[j].set_delta_time(dt);
+			idx.set_tk_index_enabled(true);
+		} else {
+			std::int32_t tk = re()%(lin.nticks()+10);
+			auto ev = jmid::make_note_on(re()%3,re()%16,re()%128,re()%128);
+			auto a = lin.insert(tk,ev);
+			auto b = idx.insert(tk,ev);
+			EXPECT_EQ(a-lin.begin(),b-idx.begin());
+		}
+		expect_same(lin,idx);
+	}
+	EXPECT_EQ(idx.nticks(),lin.nticks());
+
+	lin.resize(lin.size()/2);
+	idx.resize(idx.size()/2);
+	expect_same(lin,idx);
+
+	auto moved = std::move(idx);
+	EXPECT_TRUE(moved.tk_index_enabled());
+	EXPECT_FALSE(idx.tk_index_enabled());
+	expect_same(lin,moved);
+	jmid::mtrk_t cpy = moved;
+	EXPECT_FALSE(cpy.tk_index_enabled());
+}
+
+
+//
+// A delta time changed through a reference or an iterator, w/o going 
+// through the container, invalidates the tick index:  at_cumtk(), 
+// at_tkonset(), and get_simultaneous_events() reflect the change; the 
+// const lookups walk the events until the index is rebuilt.  
+//
+TEST(mtrk_t_tests, TkIndexStaleAfterModificationThroughReference) {
+	jmid::mtrk_t trk;
+	for (int i=0; i<10; ++i) {
+		trk.push_back(jmid::make_note_on(10,0,60+i,100));
+	}
+	trk.set_tk_index_enabled(true);
+	const auto& ctrk = trk;
+	ASSERT_EQ(ctrk.at_cumtk(50).it-ctrk.begin(),5);
+
+	trk[2].set_delta_time(100);  // Event i>=3 now has cumtk 100+10*(i-1)
+	auto r = ctrk.at_cumtk(50);
+	EXPECT_EQ(r.it-ctrk.begin(),3);
+	EXPECT_EQ(r.tk,120);
+	r = ctrk.at_tkonset(120);
+	EXPECT_EQ(r.it-ctrk.begin(),2);
+	EXPECT_EQ(r.tk,120);
+	auto s = trk.at_cumtk(130);
+	EXPECT_EQ(s.it-trk.begin(),4);
+	EXPECT_EQ(s.tk,130);
+
+	auto it = trk.begin()+3;
+	it->set_delta_time(0);  // Events 2 and 3 are now simultaneous
+	EXPECT_EQ(jmid::get_simultaneous_events(ctrk,ctrk.begin()+2)-ctrk.begin(),4);
+	r = ctrk.at_cumtk(121);
+	EXPECT_EQ(r.it-ctrk.begin(),5);
+	EXPECT_EQ(r.tk,130);
+
+	// Rebuilt by the non-const at_cumtk(); the binary search gives the 
+	// same results
+	EXPECT_EQ(trk.at_cumtk(0).tk,0);
+	EXPECT_TRUE(trk.tk_index_current());
+	EXPECT_EQ(trk.nticks(),180);
+	EXPECT_EQ(ctrk.at_cumtk(121).it-ctrk.begin(),5);
+	EXPECT_EQ(ctrk.at_cumtk(50).it-ctrk.begin(),3);
+	EXPECT_EQ(jmid::get_simultaneous_events(ctrk,ctrk.begin()+2)-ctrk.begin(),4);
+}
+
+//
+// The non-const at_cumtk() and at_tkonset() rebuild a stale tick index 
+// and leave it current, so that repeated lookups on a non-const track are
+// binary searches.  A change to the delta time of the event pointed at by
+// the iterator returned is applied to the index by the next lookup.  
+//
+TEST(mtrk_t_tests, TkIndexCurrentAcrossNonConstLookups) {
+	jmid::mtrk_t trk;
+	for (int i=0; i<100; ++i) {
+		trk.push_back(jmid::make_note_on(10,0,60,100));
+	}
+	trk.set_tk_index_enabled(true);
+	EXPECT_TRUE(trk.tk_index_current());
+	trk.begin();
+	EXPECT_FALSE(trk.tk_index_current());
+
+	// The cumtk of event i is 10*i, the onset tk is 10*(i+1)
+	const auto& ctrk = trk;
+	for (int tk=0; tk<990; tk+=7) {
+		auto r = trk.at_cumtk(tk);
+		EXPECT_TRUE(trk.tk_index_current());
+		auto idx = (tk+9)/10;
+		EXPECT_EQ(jmid::mtrk_t::const_iterator(r.it)-ctrk.begin(),idx);
+		EXPECT_EQ(r.tk,10*idx);
+		auto s = trk.at_tkonset(tk);
+		EXPECT_TRUE(trk.tk_index_current());
+		idx = std::max((tk+9)/10-1,0);
+		EXPECT_EQ(jmid::mtrk_t::const_iterator(s.it)-ctrk.begin(),idx);
+		EXPECT_EQ(s.tk,10*(idx+1));
+	}
+
+	auto r = trk.at_cumtk(500);
+	r.it->set_delta_time(110);  // The cumtk of event i>50 is now 10*i+100
+	EXPECT_FALSE(trk.tk_index_current());
+	EXPECT_EQ(ctrk.at_cumtk(510).it-ctrk.begin(),51);
+	r = trk.at_cumtk(510);
+	EXPECT_TRUE(trk.tk_index_current());
+	EXPECT_EQ(jmid::mtrk_t::const_iterator(r.it)-ctrk.begin(),51);
+	EXPECT_EQ(r.tk,610);
+	EXPECT_EQ(ctrk.at_tkonset(1000).it-ctrk.begin(),89);
+	EXPECT_EQ(trk.nticks(),1100);
+	EXPECT_TRUE(trk.tk_index_current());
+}
+
+//
+// get_linked_onoff_pairs_and_orphans() links the n'th off event for a given
+// (ch,note) to the n'th on event still sounding, and reports the unmatched
+// on and off events.  Checked against a direct simulation on a random 
+// track w/ many overlapping notes.  
+//
+TEST(mtrk_t_tests, LinkedOnoffPairsAndOrphans) {
+	jmid::mtrk_t mtrk;
+	mtrk.push_back(jmid::make_note_off(0,0,60,0));  // orphan off
+	mtrk.push_back(jmid::make_note_on(10,0,60,100));  // 0
+	mtrk.push_back(jmid::make_note_on(10,0,60,90));  // 1
+	mtrk.push_back(jmid::make_note_on(0,1,60,90));  // orphan on
+	mtrk.push_back(jmid::make_text(5,"text"));
+	mtrk.push_back(jmid::make_ch_event(5,0x90,0,60,0));  // off for 0
+	mtrk.push_back(jmid::make_note_off(10,0,60,0));  // off for 1
+	mtrk.push_back(jmid::make_note_off(10,0,60,0));  // orphan off
+	mtrk.push_back(jmid::make_eot(0));
+	auto r = jmid::get_linked_onoff_pairs_and_orphans(mtrk.begin(),mtrk.end());
+	ASSERT_EQ(r.linked.size(),2);
+	EXPECT_EQ(r.linked[0].on.it,mtrk.begin()+1);
+	EXPECT_EQ(r.linked[0].on.tk,0);
+	EXPECT_EQ(r.linked[0].off.it,mtrk.begin()+5);
+	EXPECT_EQ(r.linked[0].off.tk,25);
+	EXPECT_EQ(r.linked[1].on.it,mtrk.begin()+2);
+	EXPECT_EQ(r.linked[1].on.tk,10);
+	EXPECT_EQ(r.linked[1].off.it,mtrk.begin()+6);
+	EXPECT_EQ(r.linked[1].off.tk,30);
+	ASSERT_EQ(r.orphan_on.size(),1);
+	EXPECT_EQ(r.orphan_on[0].it,mtrk.begin()+3);
+	EXPECT_EQ(r.orphan_on[0].tk,20);
+	ASSERT_EQ(r.orphan_off.size(),2);
+	EXPECT_EQ(r.orphan_off[0].it,mtrk.begin());
+	EXPECT_EQ(r.orphan_off[1].it,mtrk.begin()+7);
+	EXPECT_EQ(r.orphan_off[1].tk,40);
+	auto pairs = jmid::get_linked_onoff_pairs(mtrk.begin(),mtrk.end());
+	ASSERT_EQ(pairs.size(),2);
+	EXPECT_EQ(pairs[1].off.it,r.linked[1].off.it);
+
+	std::mt19937 re(7);
+	mtrk.clear();
+	for (int i=0; i<200'000; ++i) {
+		std::int32_t dt = re()%3;
+		auto ch = re()%2;
+		auto note = 60+re()%4;
+		auto sel = re()%10;
+		if (sel < 5) {
+			mtrk.push_back(jmid::make_note_on(dt,ch,note,1+re()%127));
+		} else if (sel < 9) {
+			mtrk.push_back(jmid::make_note_off(dt,ch,note,re()%128));
+		} else {
+			mtrk.push_back(jmid::make_program_change(dt,ch,re()%128));
+		}
+	}
+	r = jmid::get_linked_onoff_pairs_and_orphans(mtrk.begin(),mtrk.end());
+	EXPECT_EQ(r.linked.size()+r.orphan_on.size(),
+		std::count_if(mtrk.begin(),mtrk.end(),
+			[](const jmid::mtrk_event_t& ev){ return jmid::is_note_on(ev); }));
+	EXPECT_EQ(r.linked.size()+r.orphan_off.size(),
+		std::count_if(mtrk.begin(),mtrk.end(),
+			[](const jmid::mtrk_event_t& ev){ return jmid::is_note_off(ev); }));
+	// Replay:  Each off closes the earliest sounding on w/ the same ch, note
+	std::vector<std::vector<std::int32_t>> sounding(16*128);
+	std::vector<std::size_t> pos(16*128,0);
+	std::int32_t tk = 0;
+	std::size_t n_linked = 0;
+	bool ok = true;
+	for (auto it=mtrk.begin(); it!=mtrk.end(); ++it) {
+		tk += it->delta_time();
+		auto md = jmid::get_channel_event(*it);
+		auto k = 128*md.ch + md.p1;
+		if (jmid::is_note_on(*it)) {
+			sounding[k].push_back(static_cast<std::int32_t>(it-mtrk.begin()));
+		} else if (jmid::is_note_off(*it) && pos[k]<sounding[k].size()) {
+			auto on_idx = sounding[k][pos[k]++];
+			// r.linked is in order of the on events
+			auto p = std::lower_bound(r.linked.begin(),r.linked.end(),
+				mtrk.begin()+on_idx,
+				[](const jmid::linked_onoff_pair_t& lp, jmid::mtrk_t::const_iterator on){
+					return lp.on.it < on; });
+			ok = ok && (p!=r.linked.end()) && (p->on.it==mtrk.begin()+on_idx)
+				&& (p->off.it==it) 
+				&& (p->off.tk+it->delta_time()==tk);
+			++n_linked;
+			if (!ok) { break; }
+		}
+	}
+	EXPECT_TRUE(ok);
+	EXPECT_EQ(n_linked,r.linked.size());
+	EXPECT_TRUE(std::is_sorted(r.linked.begin(),r.linked.end(),
+		[](const jmid::linked_onoff_pair_t& a, const jmid::linked_onoff_pair_t& b){
+			return a.on.it < b.on.it; }));
+}
+
+
+//
+// validate() records one diagnostic per problem, w/ the index, cumtk,
+// and note of the offending event; warnings do not invalidate the 
+// sequence.  The text is produced by error(), warning().  
+//
+TEST(mtrk_t_tests, ValidateDiagnostics) {
+	using errc = jmid::mtrk_diagnostic_t::errc;
+	// The last three note-ons in tsa are never turned off
+	auto r = make_tsa().validate();
+	EXPECT_FALSE(r);
+	ASSERT_EQ(r.diagnostics.size(),3);
+	for (int i=0; i<3; ++i) {
+		EXPECT_EQ(r.diagnostics[i].code,errc::orphan_note_on);
+		EXPECT_EQ(r.diagnostics[i].idx,27+i);
+		EXPECT_EQ(r.diagnostics[i].cumtk,tsa[27+i].cumtk);
+	}
+
+	jmid::mtrk_t mtrk;
+	mtrk.push_back(jmid::make_note_off(0,2,60,0));  // orphan off
+	mtrk.push_back(jmid::make_note_on(10,0,60,100));
+	mtrk.push_back(jmid::make_note_on(10,0,60,90));  // multiple on
+	mtrk.push_back(jmid::make_note_on(0,1,61,90));  // orphan on
+	mtrk.push_back(jmid::make_note_off(5,0,60,0));
+	mtrk.push_back(jmid::make_note_on(5,3,62,90));  // orphan on
+	mtrk.push_back(jmid::make_eot(0));
+	r = mtrk.validate();
+	EXPECT_FALSE(r);
+	EXPECT_FALSE(r.truncated);
+	ASSERT_EQ(r.diagnostics.size(),5);
+	EXPECT_EQ(r.diagnostics[0].code,errc::orphan_note_off);
+	EXPECT_EQ(r.diagnostics[0].idx,0);
+	EXPECT_EQ(r.diagnostics[0].ch,2);
+	EXPECT_EQ(r.diagnostics[1].code,errc::multiple_note_on);
+	EXPECT_EQ(r.diagnostics[1].idx,2);
+	EXPECT_EQ(r.diagnostics[1].cumtk,10);
+	EXPECT_EQ(r.diagnostics[1].note,60);
+	// The off at idx 4 closes the on at idx 1; the on at idx 2 remains 
+	// sounding
+	EXPECT_EQ(r.diagnostics[2].code,errc::orphan_note_on);
+	EXPECT_EQ(r.diagnostics[2].idx,2);
+	EXPECT_EQ(r.diagnostics[2].cumtk,10);
+	EXPECT_EQ(r.diagnostics[3].idx,3);
+	EXPECT_EQ(r.diagnostics[3].ch,1);
+	EXPECT_EQ(r.diagnostics[3].note,61);
+	EXPECT_EQ(r.diagnostics[4].idx,5);
+	EXPECT_EQ(r.diagnostics[4].cumtk,25);
+	EXPECT_EQ(r.diagnostics[4].ch,3);
+	auto err = r.error();
+	auto warn = r.warning();
+	EXPECT_EQ(std::count(err.begin(),err.end(),'\n'),3);
+	EXPECT_EQ(std::count(warn.begin(),warn.end(),'\n'),2);
+
+	// Stopping after n diagnostics
+	r = mtrk.validate(1);
+	EXPECT_FALSE(r);
+	EXPECT_TRUE(r.truncated);
+	ASSERT_EQ(r.diagnostics.size(),1);
+	EXPECT_EQ(r.diagnostics[0].code,errc::orphan_note_off);
+	r = mtrk.validate(3);
+	EXPECT_TRUE(r.truncated);
+	ASSERT_EQ(r.diagnostics.size(),3);
+	EXPECT_EQ(r.diagnostics[2].code,errc::orphan_note_on);
+
+	// Warnings only
+	mtrk.clear();
+	mtrk.push_back(jmid::make_note_on(0,0,60,100));
+	mtrk.push_back(jmid::make_note_off(10,0,60,0));
+	mtrk.push_back(jmid::make_note_off(10,0,60,0));
+	mtrk.push_back(jmid::make_eot(0));
+	r = mtrk.validate();
+	EXPECT_TRUE(r);
+	ASSERT_EQ(r.diagnostics.size(),1);
+	EXPECT_EQ(r.diagnostics[0].code,errc::orphan_note_off);
+	EXPECT_EQ(r.diagnostics[0].cumtk,10);
+	EXPECT_TRUE(r.error().empty());
+
+	// Errors stop the scan
+	mtrk.clear();
+	mtrk.push_back(jmid::make_note_on(0,0,60,100));
+	mtrk.push_back(jmid::make_eot(10));
+	mtrk.push_back(jmid::make_note_off(10,0,60,0));
+	mtrk.push_back(jmid::make_note_off(10,0,60,0));
+	mtrk.push_back(jmid::make_eot(0));
+	r = mtrk.validate();
+	EXPECT_FALSE(r);
+	ASSERT_EQ(r.diagnostics.size(),1);
+	EXPECT_EQ(r.diagnostics[0].code,errc::eot_not_last);
+	EXPECT_EQ(r.diagnostics[0].idx,1);
+	mtrk.pop_back();
+	r = mtrk.validate();
+	EXPECT_FALSE(r);
+	EXPECT_EQ(r.diagnostics.back().code,errc::eot_not_last);
+	mtrk.clear();
+	mtrk.push_back(jmid::make_note_on(0,0,60,100));
+	mtrk.push_back(jmid::make_note_off(10,0,60,0));
+	r = mtrk.validate();
+	EXPECT_FALSE(r);
+	ASSERT_EQ(r.diagnostics.size(),1);
+	EXPECT_EQ(r.diagnostics[0].code,errc::no_terminal_eot);
+	EXPECT_EQ(r.diagnostics[0].cumtk,10);
+	EXPECT_EQ(r.diagnostics[0].idx,2);
+
+	// A seqn event at cumtk==0 but onset tick > 0
+	mtrk.clear();
+	mtrk.push_back(jmid::make_seqn(5,1));
+	mtrk.push_back(jmid::make_eot(0));
+	r = mtrk.validate();
+	EXPECT_FALSE(r);
+	ASSERT_EQ(r.diagnostics.size(),1);
+	EXPECT_EQ(r.diagnostics[0].code,errc::seqn_after_start);
+	EXPECT_EQ(r.diagnostics[0].cumtk,0);
+	mtrk.front().set_delta_time(0);
+	EXPECT_TRUE(mtrk.validate());
+	EXPECT_TRUE(jmid::is_error(errc::no_terminal_eot));
+	EXPECT_FALSE(jmid::is_error(errc::multiple_note_on));
+}
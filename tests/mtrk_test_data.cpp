@@ -1,6 +1,11 @@
 #include "mtrk_test_data.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "mtrk_event_methods.h"
 #include <vector>
 #include <cstdint>
+#include <string>
+#include <random>
 
 
 namespace mtrk_tests {
@@ -178,5 +183,58 @@ std::vector<tsb_t> tsb_non_meta_events {
 	{{0x1Cu,0x80u,0x4Au,0x23u}, 1223, 1251}
 };  // std::vector<> tsb
 
+
+std::int32_t make_random_dt(std::mt19937& re, const random_mtrk_opts_t& opts) {
+	auto nsteps = opts.max_dt/opts.dt_step;
+	if ((nsteps <= 0) || (re()%4 == 0)) {
+		return 0;
+	}
+	// Shifting by a random number of bits spreads the values over the 
+	// 1-, 2-, ... byte vlq lengths
+	int nbits = 0;
+	while ((nsteps>>nbits) > 0) {
+		++nbits;
+	}
+	auto k = static_cast<std::int32_t>(re()%(nsteps+1));
+	return opts.dt_step*(k >> (re()%nbits));
+}
+jmid::mtrk_event_t make_random_event(std::mt19937& re, std::int32_t dt,
+									const random_mtrk_opts_t& opts) {
+	auto w = opts.w_ch + opts.w_meta + opts.w_sysex;
+	auto sel = static_cast<int>(re()%w);
+	if (sel < opts.w_ch) {
+		int ch = (opts.ch >= 0) ? opts.ch : re()%16;
+		switch (re()%4) {
+		case 0:
+		case 1:
+			return jmid::make_note_on(dt,ch,re()%128,1+re()%127);
+		case 2:
+			return jmid::make_note_off(dt,ch,re()%128,re()%128);
+		default:
+			return jmid::make_program_change(dt,ch,re()%128);
+		}
+	} else if (sel < (opts.w_ch+opts.w_meta)) {
+		if (re()%2 == 0) {
+			return jmid::make_tempo(dt,250000+1000*(re()%128));
+		}
+		return jmid::make_text(dt,std::string(re()%40,'a'+re()%26));
+	}
+	std::vector<unsigned char> pyld(re()%100,0x11u);
+	pyld.push_back(0xF7u);
+	return jmid::make_sysex_f0(dt,pyld);
+}
+jmid::mtrk_t make_random_mtrk(std::mt19937& re, int n, 
+									const random_mtrk_opts_t& opts) {
+	jmid::mtrk_t result;
+	for (int i=0; i<n; ++i) {
+		auto dt = make_random_dt(re,opts);
+		result.push_back(make_random_event(re,dt,opts));
+	}
+	if (opts.eot) {
+		result.push_back(jmid::make_eot(0));
+	}
+	return result;
+}
+
 };  // namespace mtrk_tests
 
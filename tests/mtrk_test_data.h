@@ -1,7 +1,9 @@
 #pragma once
 #include "mtrk_event_t.h"
+#include "mtrk_t.h"
 #include <vector>
 #include <cstdint>
+#include <random>
 
 
 namespace mtrk_tests {
@@ -33,5 +35,27 @@ extern std::vector<tsb_t> tsb_non_note_67_events;
 extern std::vector<tsb_t> tsb_meta_events;
 extern std::vector<tsb_t> tsb_non_meta_events;
 
+// Random events and tracks
+// Event types are chosen in proportion to the weights:  channel events 
+// are note-on, note-off, and program change (2 and 1 data bytes); meta 
+// events are tempo and text of varying lengths; sysex events are 
+// sometimes too large for the small-object buffer of mtrk_event_t.  
+// About 1/4 of the delta times are 0; the rest are multiples of dt_step 
+// in [0,max_dt], spread over the vlq lengths.  
+struct random_mtrk_opts_t {
+	std::int32_t max_dt {0x3FFF};
+	std::int32_t dt_step {1};
+	int w_ch {8};
+	int w_meta {1};
+	int w_sysex {1};
+	int ch {-1};  // If >= 0, all ch events are on this ch
+	bool eot {true};  // Terminate the track w/ an EOT event
+};
+std::int32_t make_random_dt(std::mt19937&, const random_mtrk_opts_t& = {});
+jmid::mtrk_event_t make_random_event(std::mt19937&, std::int32_t, 
+										const random_mtrk_opts_t& = {});
+jmid::mtrk_t make_random_mtrk(std::mt19937&, int, 
+										const random_mtrk_opts_t& = {});
+
 };  // namespace mtrk_tests
 
@@ -1,7 +1,10 @@
 #include "gtest/gtest.h"
 #include "small_bytevec_t.h"
+#include "byte_arena_t.h"
 #include <vector>
 #include <cstdint>
+#include <algorithm>
+#include <utility>
 
 
 std::vector<unsigned char> small_sizes {
@@ -449,5 +452,247 @@ TEST(small_bytevec, repeatedPushBackBigDataSrc) {
 }
 
 
+//
+// While an arena_scope_t is alive, big objects draw their buffers from the
+// arena; objects made outside the scope (including copies of arena-backed
+// objects) use the heap.  Moves transfer the arena-owned buffer w/o 
+// allocating, in or out of the scope; detach_arena() copies it.  
+//
+TEST(small_bytevec_tests, ArenaScopeAllocatesBigObjectsFromArena) {
+	jmid::internal::byte_arena_t arena(1024);
+	jmid::internal::small_bytevec_t x;
+	jmid::internal::small_bytevec_t y;
+	{
+		jmid::internal::arena_scope_t scope(&arena);
+		EXPECT_EQ(jmid::internal::current_arena(),&arena);
+		x.resize(static_cast<std::int32_t>(d24.size()));
+		std::copy(d24.begin(),d24.end(),x.begin());
+		EXPECT_TRUE(x.debug_is_big());
+		EXPECT_EQ(arena.nbytes_allocated(),d24.size());
+
+		// Large requests get a block of their own
+		y.reserve(900);
+		EXPECT_EQ(arena.nbytes_allocated(),d24.size()+900);
+		EXPECT_EQ(arena.nblocks(),2);
+		{
+			jmid::internal::arena_scope_t heap_scope(nullptr);
+			EXPECT_EQ(jmid::internal::current_arena(),nullptr);
+			jmid::internal::small_bytevec_t z(x);
+			EXPECT_EQ(arena.nbytes_allocated(),d24.size()+900);
+		}
+		EXPECT_EQ(jmid::internal::current_arena(),&arena);
+
+		auto nallocs = jmid::internal::get_small_bytevec_stats().n_allocs;
+		auto p = std::as_const(x).begin();
+		jmid::internal::small_bytevec_t w(std::move(x));
+		EXPECT_EQ(std::as_const(w).begin(),p);
+		x = std::move(w);
+		EXPECT_EQ(std::as_const(x).begin(),p);
+		EXPECT_EQ(jmid::internal::get_small_bytevec_stats().n_allocs,nallocs);
+	}
+	EXPECT_EQ(jmid::internal::current_arena(),nullptr);
+
+	auto cpy = x;
+	EXPECT_EQ(arena.nbytes_allocated(),d24.size()+900);
+	EXPECT_TRUE(std::equal(cpy.begin(),cpy.end(),d24.begin(),d24.end()));
+
+	auto nallocs = jmid::internal::get_small_bytevec_stats().n_allocs;
+	auto p = std::as_const(x).begin();
+	auto mvd = std::move(x);
+	EXPECT_EQ(jmid::internal::get_small_bytevec_stats().n_allocs,nallocs);
+	EXPECT_EQ(std::as_const(mvd).begin(),p);
+	EXPECT_TRUE(mvd.is_arena_owned());
+	EXPECT_TRUE(std::equal(mvd.begin(),mvd.end(),d24.begin(),d24.end()));
+	// Outside the scope, growing an arena-backed object moves it to the heap
+	mvd.resize(static_cast<std::int32_t>(f100.size()));
+	std::copy(f100.begin(),f100.end(),mvd.begin());
+	EXPECT_EQ(arena.nbytes_allocated(),d24.size()+900);
+	mvd = std::move(y);
+	EXPECT_TRUE(mvd.is_arena_owned());
+	nallocs = jmid::internal::get_small_bytevec_stats().n_allocs;
+	mvd.detach_arena();
+	EXPECT_EQ(jmid::internal::get_small_bytevec_stats().n_allocs,nallocs+1);
+	EXPECT_FALSE(mvd.is_arena_owned());
+	EXPECT_EQ(mvd.capacity(),900);
+
+	arena.release();
+	EXPECT_EQ(arena.nbytes_allocated(),0);
+	EXPECT_EQ(arena.nblocks(),1);
+	EXPECT_EQ(arena.nbytes_reserved(),1024);
+	// Still valid after the arena has been released
+	EXPECT_TRUE(std::equal(cpy.begin(),cpy.end(),d24.begin(),d24.end()));
+}
+
 
 
+//
+// Growing a big object one byte at a time, by either push_back() or 
+// resize(size()+1), does a number of allocations logarithmic in the final
+// size and copies fewer than 2 bytes per byte of data.  
+//
+TEST(small_bytevec_tests, ByteByByteGrowthIsGeometric) {
+	const std::int32_t n = 100'000;
+	for (int method=0; method<2; ++method) {
+		jmid::internal::reset_small_bytevec_stats();
+		jmid::internal::small_bytevec_t x;
+		for (std::int32_t i=0; i<n; ++i) {
+			auto c = static_cast<unsigned char>(i%251);
+			if (method == 0) {
+				x.push_back(c);
+			} else {
+				auto p = x.resize(i+1);
+				*(p+i) = c;
+			}
+		}
+		auto stats = jmid::internal::get_small_bytevec_stats();
+		EXPECT_TRUE(stats.n_allocs <= 14);
+		EXPECT_TRUE(stats.n_bytes_copied < 2*n);
+		EXPECT_EQ(x.size(),n);
+		bool ok = true;
+		for (std::int32_t i=0; i<n; ++i) {
+			ok = ok && (*(x.begin()+i) == static_cast<unsigned char>(i%251));
+		}
+		EXPECT_TRUE(ok);
+	}
+}
+
+//
+// reserve_exact() sets the capacity of a big object exactly, in either 
+// direction, but never below size(); shrink_to_fit() makes a big object 
+// small if the data fits.  resize_nocopy() and the small->big transition 
+// allocate exactly the size requested.  
+//
+TEST(small_bytevec_tests, ReserveExactAndShrinkToFit) {
+	jmid::internal::reset_small_bytevec_stats();
+	jmid::internal::small_bytevec_t x;
+	x.resize(static_cast<std::int32_t>(f100.size()));
+	std::copy(f100.begin(),f100.end(),x.begin());
+	EXPECT_EQ(x.capacity(),f100.size());
+	auto stats = jmid::internal::get_small_bytevec_stats();
+	EXPECT_EQ(stats.n_allocs,1);
+	EXPECT_EQ(stats.n_bytes_allocated,f100.size());
+	EXPECT_EQ(stats.n_bytes_copied,0);
+
+	// Growth by resize() is geometric
+	x.resize(101);
+	EXPECT_EQ(x.capacity(),200);
+	EXPECT_TRUE(std::equal(f100.begin(),f100.end(),x.begin()));
+	stats = jmid::internal::get_small_bytevec_stats();
+	EXPECT_EQ(stats.n_allocs,2);
+	EXPECT_EQ(stats.n_bytes_copied,100);
+	x.resize(100);
+
+	EXPECT_EQ(x.reserve_exact(150),150);
+	EXPECT_EQ(x.reserve_exact(10),100);
+	EXPECT_EQ(x.capacity(),100);
+	EXPECT_EQ(x.reserve_exact(100),100);  // No reallocation
+	EXPECT_EQ(jmid::internal::get_small_bytevec_stats().n_allocs,4);
+	EXPECT_TRUE(std::equal(f100.begin(),f100.end(),x.begin(),x.end()));
+	x.shrink_to_fit();  // Already fits
+	EXPECT_EQ(jmid::internal::get_small_bytevec_stats().n_allocs,4);
+
+	x.resize(40);
+	x.shrink_to_fit();
+	EXPECT_TRUE(x.debug_is_big());
+	EXPECT_EQ(x.capacity(),40);
+	EXPECT_TRUE(std::equal(x.begin(),x.end(),f100.begin()));
+	x.resize(20);
+	x.shrink_to_fit();
+	EXPECT_TRUE(x.debug_is_small());
+	EXPECT_EQ(x.size(),20);
+	EXPECT_TRUE(std::equal(x.begin(),x.end(),f100.begin()));
+
+	// Small objects
+	EXPECT_EQ(x.reserve_exact(10),jmid::internal::small_bytevec_t::capacity_small);
+	EXPECT_TRUE(x.debug_is_small());
+	EXPECT_EQ(x.reserve_exact(30),30);
+	EXPECT_TRUE(x.debug_is_big());
+	EXPECT_TRUE(std::equal(x.begin(),x.end(),f100.begin(),f100.begin()+20));
+
+	auto nallocs = jmid::internal::get_small_bytevec_stats().n_allocs;
+	x.resize_nocopy(1000);
+	EXPECT_EQ(x.capacity(),1000);
+	EXPECT_EQ(jmid::internal::get_small_bytevec_stats().n_allocs,nallocs+1);
+
+	// Arena-owned buffers are not reallocated
+	jmid::internal::byte_arena_t arena(1024);
+	jmid::internal::small_bytevec_t y;
+	{
+		jmid::internal::arena_scope_t scope(&arena);
+		y.reserve(200);
+	}
+	y.resize(10);
+	y.shrink_to_fit();
+	EXPECT_TRUE(y.debug_is_big());
+	EXPECT_EQ(y.capacity(),200);
+}
+
+//
+// intern() replaces the buffer of a big object w/ the copy held by the 
+// store; equal objects share a single copy.  Copies of a shared object 
+// share the buffer w/o allocating; any write through a non-const accessor
+// first gives the object a buffer of its own.  
+//
+TEST(small_bytevec_tests, InternSharesBuffersCopyOnWrite) {
+	jmid::internal::byte_intern_t store;
+	jmid::internal::small_bytevec_t x;
+	x.resize(static_cast<std::int32_t>(f100.size()));
+	std::copy(f100.begin(),f100.end(),x.begin());
+	auto y = x;
+	x.intern(store);
+	y.intern(store);
+	EXPECT_TRUE(x.is_shared());
+	EXPECT_TRUE(y.is_shared());
+	EXPECT_EQ(std::as_const(x).begin(),std::as_const(y).begin());
+	EXPECT_EQ(store.size(),1);
+	EXPECT_EQ(store.nbytes(),f100.size());
+	EXPECT_EQ(store.nhits(),1);
+	EXPECT_EQ(store.nbytes_saved(),f100.size());
+	EXPECT_EQ(x.capacity(),x.size());
+
+	// Small objects and big objects whose data would fit in a small object
+	// are not interned
+	jmid::internal::small_bytevec_t s(7);
+	s.intern(store);
+	EXPECT_FALSE(s.is_shared());
+	EXPECT_EQ(store.size(),1);
+
+	jmid::internal::reset_small_bytevec_stats();
+	auto z = x;
+	jmid::internal::small_bytevec_t w;
+	w = y;
+	EXPECT_EQ(jmid::internal::get_small_bytevec_stats().n_allocs,0);
+	EXPECT_TRUE(z.is_shared());
+	EXPECT_TRUE(w.is_shared());
+	EXPECT_EQ(std::as_const(z).begin(),std::as_const(x).begin());
+	auto mvd = std::move(w);
+	EXPECT_TRUE(mvd.is_shared());
+	EXPECT_EQ(std::as_const(mvd).begin(),std::as_const(x).begin());
+	mvd.shrink_to_fit();  // Does nothing
+	EXPECT_TRUE(mvd.is_shared());
+
+	// Writing to z detaches it; x, y are unaffected
+	*(z.begin()) = 0x00u;
+	EXPECT_FALSE(z.is_shared());
+	EXPECT_EQ(jmid::internal::get_small_bytevec_stats().n_allocs,1);
+	EXPECT_NE(std::as_const(z).begin(),std::as_const(x).begin());
+	EXPECT_TRUE(std::equal(std::as_const(x).begin(),std::as_const(x).end(),
+		f100.begin(),f100.end()));
+	EXPECT_EQ(*(std::as_const(z).begin()),0x00u);
+	EXPECT_TRUE(std::equal(std::as_const(z).begin()+1,std::as_const(z).end(),
+		f100.begin()+1,f100.end()));
+	// Growing, shrinking, and resize_nocopy() also detach
+	y.resize(101);
+	EXPECT_FALSE(y.is_shared());
+	EXPECT_TRUE(std::equal(f100.begin(),f100.end(),std::as_const(y).begin()));
+	mvd.resize(50);
+	EXPECT_FALSE(mvd.is_shared());
+	EXPECT_TRUE(std::equal(std::as_const(mvd).begin(),std::as_const(mvd).end(),
+		f100.begin(),f100.begin()+50));
+	auto v = x;
+	v.resize_nocopy(40);
+	EXPECT_FALSE(v.is_shared());
+	EXPECT_TRUE(x.is_shared());
+	EXPECT_TRUE(std::equal(std::as_const(x).begin(),std::as_const(x).end(),
+		f100.begin(),f100.end()));
+}
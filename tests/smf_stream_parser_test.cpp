@@ -0,0 +1,229 @@
+#include "gtest/gtest.h"
+#include "smf_stream_parser.h"
+#include "smf_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <algorithm>
+
+
+namespace smf_stream_parser_tests {
+std::vector<unsigned char> make_test_smf() {
+	std::vector<unsigned char> result {
+		0x4D, 0x54, 0x68, 0x64,  // MThd
+		0x00, 0x00, 0x00, 0x06,
+		0x00, 0x01,  // Format 1
+		0x00, 0x02,  // 2 tracks
+		0x00, 0x60,  // 96 tpq
+
+		0x4D, 0x54, 0x72, 0x6B,  // MTrk
+		0x00, 0x00, 0x00, 0x0B,  // 11 bytes
+		0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+		0x00, 0xFF, 0x2F, 0x00,
+
+		0x4A, 0x55, 0x4E, 0x4B,  // JUNK
+		0x00, 0x00, 0x00, 0x05,
+		0x01, 0x02, 0x03, 0x04, 0x05,
+
+		0x4D, 0x54, 0x72, 0x6B,  // MTrk
+		0x00, 0x00, 0x01, 0x1E,  // 286 bytes
+		0x00, 0x90, 0x3C, 0x40,
+		0x81, 0x40, 0x3E, 0x40,  // running status, 2-byte dt
+		0x00, 0xF0, 0x81, 0x7F  // sysex w/ a 255 byte payload
+	};
+	for (int i=0; i<254; ++i) {
+		result.push_back(static_cast<unsigned char>(i&0x7F));
+	}
+	result.push_back(0xF7u);
+	std::vector<unsigned char> tail {
+		0x60, 0x80, 0x3C, 0x40,
+		0x00, 0xC3, 0x05,  // Program change:  1 data byte
+		0x83, 0x80, 0x00, 0xFF, 0x01, 0x03, 0x61, 0x62, 0x63,  // 3-byte dt
+		0x00, 0xFF, 0x2F, 0x00,
+
+		0x4A, 0x55, 0x4E, 0x4B,  // Trailing JUNK; never read
+		0x00, 0x00, 0x00, 0x00
+	};
+	result.insert(result.end(),tail.begin(),tail.end());
+	return result;
+}
+
+struct collected_t {
+	std::vector<std::vector<jmid::mtrk_event_t>> mtrks;
+	std::vector<std::vector<unsigned char>> uchks;
+	int n_mthd {0};
+	int n_chunk_end {0};
+	jmid::smf_stream_callbacks_t callbacks() {
+		jmid::smf_stream_callbacks_t cbs;
+		cbs.on_mthd = [this](const jmid::mthd_t&)->void { ++(this->n_mthd); };
+		cbs.on_chunk_begin = [this](const jmid::chunk_header_t& h)->void {
+			if (jmid::has_mtrk_id(h)) {
+				this->mtrks.emplace_back();
+			} else {
+				this->uchks.emplace_back();
+			}
+		};
+		cbs.on_mtrk_event = [this](const jmid::mtrk_event_t& ev)->void {
+			this->mtrks.back().push_back(ev);
+		};
+		cbs.on_uchk_data = [this](const unsigned char *beg, 
+									const unsigned char *end)->void {
+			this->uchks.back().insert(this->uchks.back().end(),beg,end);
+		};
+		cbs.on_chunk_end = [this](const jmid::chunk_header_t&)->void {
+			++(this->n_chunk_end);
+		};
+		return cbs;
+	}
+};
+
+// Feeds [beg,end) to p in fragments of the sizes given by fragsz, cycling
+// through fragsz as needed, then calls finish().  
+bool feed_fragments(jmid::smf_stream_parser_t& p, const unsigned char *beg,
+				const unsigned char *end, const std::vector<std::size_t>& fragsz) {
+	std::size_t i=0;
+	while (beg!=end) {
+		auto n = std::min(fragsz[i%fragsz.size()],
+			static_cast<std::size_t>(end-beg));
+		p.feed(beg,n);
+		beg += n;
+		++i;
+	}
+	return p.finish();
+}
+}  // namespace smf_stream_parser_tests
+
+
+//
+// For any fragmentation of the input, the events, uchk data, and number of
+// bytes consumed are identical to those of make_smf2().  
+//
+TEST(smf_stream_parser_tests, AnyFragmentationMatchesMakeSmf2) {
+	auto bytes = smf_stream_parser_tests::make_test_smf();
+	const unsigned char *beg = bytes.data();
+	const unsigned char *end = bytes.data()+bytes.size();
+	jmid::smf_t expect;
+	jmid::smf_error_t expect_err;
+	auto expect_it = jmid::make_smf2(beg,end,&expect,&expect_err);
+	ASSERT_EQ(expect_err.code,jmid::smf_error_t::errc::no_error);
+	ASSERT_EQ(expect.ntrks(),2);
+	ASSERT_EQ(expect.nuchks(),1);
+
+	std::vector<std::vector<std::size_t>> fragmentations;
+	for (std::size_t n=1; n<=bytes.size(); ++n) {
+		fragmentations.push_back({n});
+	}
+	std::mt19937 re(5);
+	std::uniform_int_distribution<std::size_t> rd(0,12);
+	for (int i=0; i<200; ++i) {
+		std::vector<std::size_t> f;
+		for (int j=0; j<50; ++j) {
+			f.push_back(rd(re));  // Includes 0-length fragments
+		}
+		f.push_back(1);
+		fragmentations.push_back(f);
+	}
+
+	for (const auto& f : fragmentations) {
+		smf_stream_parser_tests::collected_t c;
+		jmid::smf_stream_parser_t p(c.callbacks());
+		EXPECT_TRUE(smf_stream_parser_tests::feed_fragments(p,beg,end,f));
+		EXPECT_TRUE(p.is_done());
+		EXPECT_EQ(p.error().code,jmid::smf_error_t::errc::no_error);
+		EXPECT_EQ(p.nbytes_read(),expect_it-beg);
+		EXPECT_EQ(p.nmtrks_read(),expect.ntrks());
+		EXPECT_EQ(p.nuchks_read(),expect.nuchks());
+		EXPECT_EQ(c.n_mthd,1);
+		EXPECT_EQ(c.n_chunk_end,3);
+		ASSERT_EQ(c.mtrks.size(),expect.ntrks());
+		for (int i=0; i<expect.ntrks(); ++i) {
+			ASSERT_EQ(c.mtrks[i].size(),expect[i].size());
+			for (int j=0; j<expect[i].size(); ++j) {
+				EXPECT_EQ(c.mtrks[i][j],expect[i][j]);
+			}
+		}
+		ASSERT_EQ(c.uchks.size(),expect.nuchks());
+		EXPECT_EQ(c.uchks[0],expect.get_uchk(0));
+	}
+}
+
+//
+// For truncated and corrupted input, the error code and counts reported 
+// after finish() are those reported by make_smf2() for the same input.  
+//
+TEST(smf_stream_parser_tests, TruncatedAndCorruptInputMatchesMakeSmf2) {
+	auto bytes = smf_stream_parser_tests::make_test_smf();
+	auto check = [](const std::vector<unsigned char>& d, std::size_t fragsz)->void {
+		const unsigned char *beg = d.data();
+		const unsigned char *end = d.data()+d.size();
+		jmid::smf_t expect;
+		jmid::smf_error_t expect_err;
+		jmid::make_smf2(beg,end,&expect,&expect_err);
+
+		smf_stream_parser_tests::collected_t c;
+		jmid::smf_stream_parser_t p(c.callbacks());
+		auto is_done = smf_stream_parser_tests::feed_fragments(p,beg,end,{fragsz});
+		EXPECT_EQ(is_done,expect_err.code==jmid::smf_error_t::errc::no_error);
+		ASSERT_EQ(p.error().code,expect_err.code);
+		if (expect_err.code != jmid::smf_error_t::errc::mthd_error) {
+			EXPECT_EQ(p.error().expect_num_mtrks,expect_err.expect_num_mtrks);
+			EXPECT_EQ(p.error().num_mtrks_read,expect_err.num_mtrks_read);
+			EXPECT_EQ(p.error().num_uchks_read,expect_err.num_uchks_read);
+		}
+	};
+
+	for (std::size_t n=0; n<bytes.size(); ++n) {
+		auto d = bytes;
+		d.resize(n);
+		check(d,1);
+		check(d,7);
+	}
+	std::vector<unsigned char> corrupt_vals {0x00u,0x7Fu,0x80u,0xF0u,0xF9u,0xFFu};
+	for (std::size_t i=0; i<bytes.size(); ++i) {
+		for (const auto& v : corrupt_vals) {
+			auto d = bytes;
+			d[i] = v;
+			check(d,1);
+			check(d,13);
+		}
+	}
+}
+
+//
+// After reset(), the parser can be reused for another file.  Input after
+// the last MTrk is ignored, and feed() has no effect after an error.  
+//
+TEST(smf_stream_parser_tests, ResetAndInputAfterCompletionOrError) {
+	auto bytes = smf_stream_parser_tests::make_test_smf();
+	smf_stream_parser_tests::collected_t c;
+	jmid::smf_stream_parser_t p(c.callbacks());
+	EXPECT_TRUE(p.feed(bytes.data(),bytes.size()));
+	EXPECT_TRUE(p.is_done());
+	auto nbytes = p.nbytes_read();
+	EXPECT_LT(nbytes,bytes.size());
+	EXPECT_TRUE(p.feed(bytes.data(),bytes.size()));
+	EXPECT_EQ(p.nbytes_read(),nbytes);
+	EXPECT_TRUE(p.finish());
+	EXPECT_EQ(c.mtrks.size(),2);
+
+	p.reset();
+	c = smf_stream_parser_tests::collected_t();
+	std::vector<unsigned char> bad {0x4D, 0x54, 0x68, 0x65, 0x00, 0x00, 0x00, 0x06};  // 'MThe'
+	EXPECT_FALSE(p.feed(bad.data(),bad.size()));
+	EXPECT_TRUE(p.is_error());
+	EXPECT_EQ(p.error().code,jmid::smf_error_t::errc::mthd_error);
+	EXPECT_EQ(p.error().mthd_err_obj.code,jmid::mthd_error_t::errc::non_mthd_id);
+	EXPECT_FALSE(p.feed(bytes.data(),bytes.size()));
+	EXPECT_FALSE(p.finish());
+	EXPECT_EQ(c.n_mthd,0);
+
+	p.reset();
+	EXPECT_TRUE(p.feed(reinterpret_cast<const char*>(bytes.data()),bytes.size()));
+	EXPECT_TRUE(p.finish());
+	EXPECT_EQ(c.mtrks.size(),2);
+	EXPECT_EQ(c.uchks.size(),1);
+}
+
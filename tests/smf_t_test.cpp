@@ -0,0 +1,479 @@
+#include "gtest/gtest.h"
+#include "smf_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "mtrk_event_methods.h"
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <iterator>
+#include <algorithm>
+#include <random>
+#include <utility>  // std::as_const()
+
+
+namespace smf_tests {
+// A small format-1 file:  MThd, MTrk (tempo track), an unknown chunk,
+// MTrk (2 notes, uses running status).
+std::vector<unsigned char> tsa_bytes {
+	0x4D, 0x54, 0x68, 0x64,  // MThd
+	0x00, 0x00, 0x00, 0x06,
+	0x00, 0x01,  // Format 1
+	0x00, 0x02,  // 2 tracks
+	0x00, 0x60,  // 96 tpq
+
+	0x4D, 0x54, 0x72, 0x6B,  // MTrk
+	0x00, 0x00, 0x00, 0x13,  // 19 bytes
+	0x00, 0xFF, 0x58, 0x04, 0x04, 0x02, 0x18, 0x08,
+	0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+	0x00, 0xFF, 0x2F, 0x00,
+
+	0x4A, 0x55, 0x4E, 0x4B,  // JUNK
+	0x00, 0x00, 0x00, 0x03,
+	0x01, 0x02, 0x03,
+
+	0x4D, 0x54, 0x72, 0x6B,  // MTrk
+	0x00, 0x00, 0x00, 0x18,  // 24 bytes
+	0x00, 0xFF, 0x03, 0x02, 0x41, 0x42,  // Seq/track name "AB"
+	0x00, 0x90, 0x3C, 0x40,
+	0x60, 0x3E, 0x40,  // running status
+	0x60, 0x80, 0x3C, 0x40,
+	0x00, 0x3E, 0x40,  // running status
+	0x00, 0xFF, 0x2F, 0x00
+};
+
+std::filesystem::path write_tmp_file(const std::vector<unsigned char>& data,
+						const std::string& name) {
+	auto fp = std::filesystem::temp_directory_path()/name;
+	std::ofstream f(fp,std::ios_base::out|std::ios_base::binary);
+	f.write(reinterpret_cast<const char*>(data.data()),data.size());
+	f.close();
+	return fp;
+}
+
+void expect_smf_eq(const jmid::smf_t& a, const jmid::smf_t& b) {
+	EXPECT_EQ(a.format(),b.format());
+	EXPECT_EQ(a.division(),b.division());
+	EXPECT_EQ(a.ntrks(),b.ntrks());
+	EXPECT_EQ(a.nuchks(),b.nuchks());
+	if ((a.ntrks()!=b.ntrks()) || (a.nuchks()!=b.nuchks())) {
+		return;
+	}
+	for (int i=0; i<a.ntrks(); ++i) {
+		ASSERT_EQ(a[i].size(),b[i].size());
+		for (int j=0; j<a[i].size(); ++j) {
+			EXPECT_EQ(a[i][j],b[i][j]);
+		}
+	}
+	for (int i=0; i<a.nuchks(); ++i) {
+		EXPECT_EQ(a.get_uchk(i),b.get_uchk(i));
+	}
+}
+}  // namespace smf_tests
+
+
+//
+// read_smf_mmap() should produce the same smf_t as make_smf2() on an
+// in-memory copy of the file
+//
+TEST(smf_t_tests, ReadSmfMmapMatchesMakeSmf2) {
+	auto fp = smf_tests::write_tmp_file(smf_tests::tsa_bytes,
+		"jmid_smf_t_tests_tsa.mid");
+
+	jmid::smf_t expect;
+	jmid::smf_error_t expect_err;
+	jmid::make_smf2(smf_tests::tsa_bytes.data(),
+		smf_tests::tsa_bytes.data()+smf_tests::tsa_bytes.size(),
+		&expect,&expect_err);
+	ASSERT_EQ(expect_err.code,jmid::smf_error_t::errc::no_error);
+
+	jmid::smf_error_t err;
+	auto maybe_smf = jmid::read_smf_mmap(fp,&err);
+	std::filesystem::remove(fp);
+	EXPECT_TRUE(maybe_smf);
+	EXPECT_EQ(err.code,jmid::smf_error_t::errc::no_error);
+	EXPECT_EQ(maybe_smf.nbytes_read,smf_tests::tsa_bytes.size());
+	EXPECT_EQ(maybe_smf.smf.ntrks(),2);
+	EXPECT_EQ(maybe_smf.smf.nuchks(),1);
+	smf_tests::expect_smf_eq(maybe_smf.smf,expect);
+}
+
+TEST(smf_t_tests, ReadSmfMmapNonexistentFile) {
+	auto fp = std::filesystem::temp_directory_path()
+		/"jmid_smf_t_tests_does_not_exist.mid";
+	std::filesystem::remove(fp);
+	jmid::smf_error_t err;
+	auto maybe_smf = jmid::read_smf_mmap(fp,&err);
+	EXPECT_FALSE(maybe_smf);
+	EXPECT_EQ(err.code,jmid::smf_error_t::errc::file_read_error);
+}
+
+TEST(smf_t_tests, ReadSmfMmapEmptyFile) {
+	auto fp = smf_tests::write_tmp_file({},"jmid_smf_t_tests_empty.mid");
+	jmid::smf_error_t err;
+	auto maybe_smf = jmid::read_smf_mmap(fp,&err);
+	std::filesystem::remove(fp);
+	EXPECT_FALSE(maybe_smf);
+	EXPECT_EQ(err.code,jmid::smf_error_t::errc::mthd_error);
+}
+
+
+//
+// make_smf2_parallel() must produce exactly the same smf_t, error, and
+// returned iterator as make_smf2() for both valid and invalid input.  
+// Every prefix of a valid file is tested, as are inputs w/ corrupted 
+// MTrk length fields.  
+//
+TEST(smf_t_tests, MakeSmf2ParallelMatchesMakeSmf2) {
+	auto check = [](const std::vector<unsigned char>& bytes)->void {
+		const unsigned char *beg = bytes.data();
+		const unsigned char *end = bytes.data()+bytes.size();
+		jmid::smf_t expect;
+		jmid::smf_error_t expect_err;
+		auto expect_it = jmid::make_smf2(beg,end,&expect,&expect_err);
+		
+		jmid::smf_t smf;
+		jmid::smf_error_t err;
+		auto it = jmid::make_smf2_parallel(beg,end,&smf,&err,4);
+		EXPECT_EQ(it-beg,expect_it-beg);
+		EXPECT_EQ(err.code,expect_err.code);
+		EXPECT_EQ(err.num_mtrks_read,expect_err.num_mtrks_read);
+		EXPECT_EQ(err.num_uchks_read,expect_err.num_uchks_read);
+		if (expect_err.code != jmid::smf_error_t::errc::mthd_error) {
+			EXPECT_EQ(err.expect_num_mtrks,expect_err.expect_num_mtrks);
+			smf_tests::expect_smf_eq(smf,expect);
+		}
+	};
+
+	auto bytes = smf_tests::tsa_bytes;
+	for (int i=0; i<=bytes.size(); ++i) {
+		check(std::vector<unsigned char>(bytes.begin(),bytes.begin()+i));
+	}
+
+	// Length field of the first MTrk too large, then too small
+	bytes[21] = 0x14;
+	check(bytes);
+	bytes[21] = 0x12;
+	check(bytes);
+	// Length field of the last MTrk too large
+	bytes = smf_tests::tsa_bytes;
+	bytes[59] = 0x19;
+	check(bytes);
+	// Invalid event in the second MTrk
+	bytes = smf_tests::tsa_bytes;
+	bytes[61] = 0xF9;
+	check(bytes);
+}
+
+//
+// smf_t::set_intern_store() applies on every thread that parses an MTrk:
+// The equal big text events of all the tracks read by make_smf2() and 
+// make_smf2_parallel() share a single buffer in the store.  
+//
+TEST(smf_t_tests, InternStoreAppliesToParallelWorkers) {
+	std::string name(60,'n');
+	jmid::smf_t src;
+	for (int i=0; i<8; ++i) {
+		jmid::mtrk_t trk;
+		trk.push_back(jmid::make_text(0,name));
+		trk.push_back(jmid::make_note_on(10,0,60+i,100));
+		trk.push_back(jmid::make_eot(0));
+		src.push_back(std::move(trk));
+	}
+	std::vector<unsigned char> bytes;
+	jmid::write_smf(src,std::back_inserter(bytes));
+	const unsigned char *beg = bytes.data();
+	const unsigned char *end = bytes.data()+bytes.size();
+
+	for (bool parallel : {false,true}) {
+		jmid::internal::byte_intern_t store;
+		jmid::smf_t smf;
+		smf.set_intern_store(&store);
+		EXPECT_EQ(smf.intern_store(),&store);
+		jmid::smf_error_t err;
+		if (parallel) {
+			jmid::make_smf2_parallel(beg,end,&smf,&err,4);
+		} else {
+			jmid::make_smf2(beg,end,&smf,&err);
+		}
+		ASSERT_EQ(err.code,jmid::smf_error_t::errc::no_error);
+		smf_tests::expect_smf_eq(smf,src);
+		EXPECT_EQ(store.size(),1);
+		EXPECT_EQ(store.nhits(),7);
+		const auto& csmf = smf;
+		for (int i=1; i<csmf.ntrks(); ++i) {
+			EXPECT_EQ(csmf[i][0].data(),csmf[0][0].data());
+		}
+	}
+}
+
+//
+// The contiguous-buffer overloads of write_smf() and write_mtrk() produce 
+// the same bytes as the generic (output-iterator) versions, and 
+// write_smf_nbytes() is the exact size of the output.  The file overload
+// writes the same bytes.  
+//
+TEST(smf_t_tests, WriteSmfBufferMatchesGenericWriteSmf) {
+	jmid::smf_t smf;
+	jmid::smf_error_t err;
+	jmid::make_smf2(smf_tests::tsa_bytes.data(),
+		smf_tests::tsa_bytes.data()+smf_tests::tsa_bytes.size(),&smf,&err);
+	ASSERT_EQ(err.code,jmid::smf_error_t::errc::no_error);
+	// An event too large for the small-object buffer of mtrk_event_t, and 
+	// an empty MTrk
+	smf[1].insert(smf[1].begin(),jmid::make_lyric(0,std::string(300,'x')));
+	smf.push_back(jmid::mtrk_t());
+
+	std::vector<unsigned char> expect;
+	jmid::write_smf(smf,std::back_inserter(expect));
+	ASSERT_EQ(jmid::write_smf_nbytes(smf),expect.size());
+	EXPECT_EQ(jmid::write_smf_nbytes(smf),smf.nbytes()-3);  // 3 bytes of JUNK
+
+	std::vector<unsigned char> buf(expect.size()+4,0xEEu);
+	auto end = jmid::write_smf(smf,buf.data());
+	EXPECT_EQ(end-buf.data(),expect.size());
+	EXPECT_TRUE(std::equal(expect.begin(),expect.end(),buf.begin()));
+	EXPECT_EQ(buf.back(),0xEEu);
+
+	std::vector<unsigned char> expect_trk;
+	jmid::write_mtrk(smf[1],std::back_inserter(expect_trk));
+	std::vector<unsigned char> trk(smf[1].nbytes());
+	EXPECT_EQ(jmid::write_mtrk(smf[1],trk.data()),trk.data()+trk.size());
+	EXPECT_EQ(trk,expect_trk);
+
+	auto fp = std::filesystem::temp_directory_path()/"jmid_smf_t_tests_write.mid";
+	std::vector<unsigned char> reused_buf;
+	for (int i=0; i<2; ++i) {
+		if (i==0) {
+			jmid::write_smf(smf,fp);
+		} else {
+			jmid::write_smf(smf,fp,&reused_buf);
+		}
+		std::ifstream f(fp,std::ios_base::in|std::ios_base::binary);
+		std::vector<unsigned char> fdata((std::istreambuf_iterator<char>(f)),
+			std::istreambuf_iterator<char>());
+		f.close();
+		EXPECT_EQ(fdata,expect);
+	}
+	std::filesystem::remove(fp);
+}
+
+//
+// The totals of a track made w/ the range ctor (directly, or by split_if())
+// are correct, so the buffer sized by write_smf_nbytes() for the file 
+// overload of write_smf() holds the whole smf.  
+//
+TEST(smf_t_tests, WriteSmfBufferRangeCtorAndSplitIfTracks) {
+	jmid::mtrk_t src;
+	for (int i=0; i<200; ++i) {
+		if (i%10 == 0) {
+			src.push_back(jmid::make_text(i%3,std::string(20+i%30,'t')));
+		} else {
+			src.push_back(jmid::make_note_on(i%7,i%16,i%128,64));
+		}
+	}
+	src.push_back(jmid::make_eot(0));
+	const auto& csrc = src;
+
+	jmid::smf_t smf;
+	smf.push_back(jmid::mtrk_t(csrc.begin(),csrc.end()));
+	EXPECT_EQ(std::as_const(smf[0]).nbytes(),csrc.nbytes());
+	EXPECT_EQ(std::as_const(smf[0]).nticks(),csrc.nticks());
+	auto trk = src;
+	auto texts = jmid::split_if(trk,[](const jmid::mtrk_event_t& ev)->bool {
+		return jmid::is_text(ev);
+	});
+	EXPECT_EQ(std::as_const(texts).size(),20);
+	smf.push_back(texts);
+	smf.push_back(trk);
+	std::int64_t expect_nbytes = 14;
+	for (const auto& t : std::as_const(smf)) {
+		std::vector<unsigned char> bytes;
+		jmid::write_mtrk(t,std::back_inserter(bytes));
+		EXPECT_EQ(t.nbytes(),bytes.size());
+		expect_nbytes += static_cast<std::int64_t>(bytes.size());
+	}
+	ASSERT_EQ(jmid::write_smf_nbytes(smf),expect_nbytes);
+
+	std::vector<unsigned char> expect;
+	jmid::write_smf(smf,std::back_inserter(expect));
+	auto fp = std::filesystem::temp_directory_path()/"jmid_smf_t_tests_split.mid";
+	std::vector<unsigned char> buf;
+	jmid::write_smf(smf,fp,&buf);
+	std::ifstream f(fp,std::ios_base::in|std::ios_base::binary);
+	std::vector<unsigned char> fdata((std::istreambuf_iterator<char>(f)),
+		std::istreambuf_iterator<char>());
+	f.close();
+	EXPECT_EQ(fdata,expect);
+	std::filesystem::remove(fp);
+}
+
+//
+// validate_smf() must report the same error, counts, and returned iterator 
+// as make_smf2() for any input.  Every prefix of a valid file is tested,
+// as is every single-byte corruption of the file w/ a handful of values.
+//
+TEST(smf_t_tests, ValidateSmfMatchesMakeSmf2) {
+	auto check = [](const std::vector<unsigned char>& bytes)->void {
+		const unsigned char *beg = bytes.data();
+		const unsigned char *end = bytes.data()+bytes.size();
+		jmid::smf_t expect;
+		jmid::smf_error_t expect_err;
+		auto expect_it = jmid::make_smf2(beg,end,&expect,&expect_err);
+
+		jmid::smf_error_t err;
+		auto it = jmid::validate_smf(beg,end,&err);
+		ASSERT_EQ(err.code,expect_err.code);
+		EXPECT_EQ(it-beg,expect_it-beg);
+		EXPECT_EQ(err.num_mtrks_read,expect_err.num_mtrks_read);
+		EXPECT_EQ(err.num_uchks_read,expect_err.num_uchks_read);
+		EXPECT_EQ(err.expect_num_mtrks,expect_err.expect_num_mtrks);
+	};
+
+	auto bytes = smf_tests::tsa_bytes;
+	for (int i=0; i<=bytes.size(); ++i) {
+		check(std::vector<unsigned char>(bytes.begin(),bytes.begin()+i));
+	}
+
+	std::vector<unsigned char> vals {0x00u,0x01u,0x2Fu,0x7Fu,0x80u,0xF0u,0xF9u,0xFFu};
+	for (int i=0; i<bytes.size(); ++i) {
+		for (const auto& v : vals) {
+			bytes = smf_tests::tsa_bytes;
+			bytes[i] = v;
+			check(bytes);
+		}
+	}
+
+	// A valid file needs no error object
+	bytes = smf_tests::tsa_bytes;
+	auto it = jmid::validate_smf(bytes.data(),bytes.data()+bytes.size(),nullptr);
+	EXPECT_EQ(it,bytes.data()+bytes.size());
+}
+
+
+//
+// The rvalue/emplace overloads of smf_t::push_back() and insert(), and
+// get_events_dt_ordered(smf_t&&), give the same results as their copying
+// counterparts.  
+//
+TEST(smf_t_tests, MoveOverloadsMatchCopyingOverloads) {
+	jmid::smf_t smf;
+	jmid::smf_error_t err;
+	jmid::make_smf2(smf_tests::tsa_bytes.data(),
+		smf_tests::tsa_bytes.data()+smf_tests::tsa_bytes.size(),&smf,&err);
+	ASSERT_EQ(err.code,jmid::smf_error_t::errc::no_error);
+	smf[1].insert(smf[1].begin(),jmid::make_lyric(0,std::string(300,'x')));
+
+	jmid::smf_t a = smf;
+	jmid::smf_t b = smf;
+	auto trk = smf[1];
+	a.insert(a.begin(),trk);
+	auto p = trk.front().data();
+	auto it = b.insert(b.begin(),std::move(trk));
+	EXPECT_EQ(it,b.begin());
+	EXPECT_EQ(it->front().data(),p);
+	a.push_back(jmid::mtrk_t());
+	EXPECT_EQ(b.emplace_back().size(),0);
+	std::vector<unsigned char> uchk {0x01u,0x02u};
+	a.push_back(uchk);
+	b.push_back(std::vector<unsigned char>(uchk));
+	smf_tests::expect_smf_eq(a,b);
+	EXPECT_EQ(a.mthd().ntrks(),b.mthd().ntrks());
+	EXPECT_EQ(b.mthd().ntrks(),4);
+
+	auto expect = jmid::get_events_dt_ordered(a);
+	auto evs = jmid::get_events_dt_ordered(std::move(b));
+	ASSERT_EQ(evs.size(),expect.size());
+	for (int i=0; i<evs.size(); ++i) {
+		EXPECT_EQ(evs[i].ev,expect[i].ev);
+		EXPECT_EQ(evs[i].cumtk,expect[i].cumtk);
+		EXPECT_EQ(evs[i].trackn,expect[i].trackn);
+	}
+}
+
+//
+// flatten_to_format0() merges the tracks into a single MTrk w/ the events
+// in the order of get_events_dt_ordered(), less the EOTs, followed by one
+// EOT at the last tick.  
+//
+TEST(smf_t_tests, FlattenToFormat0) {
+	jmid::smf_t smf;
+	jmid::smf_error_t err;
+	jmid::make_smf2(smf_tests::tsa_bytes.data(),
+		smf_tests::tsa_bytes.data()+smf_tests::tsa_bytes.size(),&smf,&err);
+	ASSERT_EQ(err.code,jmid::smf_error_t::errc::no_error);
+
+	auto f0 = jmid::flatten_to_format0(smf);
+	EXPECT_EQ(f0.format(),0);
+	EXPECT_EQ(f0.division(),smf.division());
+	EXPECT_EQ(f0.mthd().ntrks(),1);
+	ASSERT_EQ(f0.ntrks(),1);
+	ASSERT_EQ(f0.nuchks(),1);
+	EXPECT_EQ(f0.get_uchk(0),smf.get_uchk(0));
+	const auto& trk = f0[0];
+	ASSERT_EQ(trk.size(),8);
+	std::vector<std::int32_t> expect_dt {0,0,0,0,0x60,0x60,0,0};
+	for (int i=0; i<trk.size(); ++i) {
+		EXPECT_EQ(trk[i].delta_time(),expect_dt[i]);
+	}
+	EXPECT_EQ(trk[0],smf[0][0]);
+	EXPECT_EQ(trk[1],smf[0][1]);
+	EXPECT_EQ(trk[2],smf[1][0]);
+	EXPECT_TRUE(jmid::is_eot(trk.back()));
+	EXPECT_EQ(trk.nticks(),smf[1].nticks());
+	
+	// The result is a valid smf (write_smf() does not write the uchks)
+	std::vector<unsigned char> bytes;
+	jmid::write_smf(f0,std::back_inserter(bytes));
+	jmid::smf_t f0_read;
+	jmid::make_smf2(bytes.data(),bytes.data()+bytes.size(),&f0_read,&err);
+	ASSERT_EQ(err.code,jmid::smf_error_t::errc::no_error);
+	EXPECT_EQ(f0_read.format(),0);
+	ASSERT_EQ(f0_read.ntrks(),1);
+	EXPECT_TRUE(std::equal(f0_read[0].begin(),f0_read[0].end(),
+		trk.begin(),trk.end()));
+
+	// Tracks of different lengths, w/ simultaneous events across tracks
+	std::mt19937 re(5);
+	jmid::smf_t rnd;
+	rnd.push_back(jmid::mtrk_t());  // Empty track
+	for (int n : {0,40,300,7}) {
+		jmid::mtrk_t mtrk;
+		for (int i=0; i<n; ++i) {
+			std::int32_t dt = (re()%3==0) ? 0 : re()%50;
+			mtrk.push_back(jmid::make_note_on(dt,re()%16,re()%128,re()%128));
+		}
+		mtrk.push_back(jmid::make_eot(re()%200));
+		rnd.push_back(std::move(mtrk));
+	}
+	auto expect = jmid::get_events_dt_ordered(rnd);
+	expect.erase(std::remove_if(expect.begin(),expect.end(),
+		[](const jmid::all_smf_events_dt_ordered_t& e)->bool {
+			return jmid::is_eot(e.ev);
+		}),expect.end());
+	std::int32_t nticks = 0;
+	for (const auto& t : rnd) {
+		nticks = std::max(nticks,t.nticks());
+	}
+	auto flat = jmid::flatten_mtrks(rnd);
+	ASSERT_EQ(flat.size(),expect.size()+1);
+	std::int32_t tk = 0;
+	for (int i=0; i<expect.size(); ++i) {
+		tk += flat[i].delta_time();
+		EXPECT_EQ(tk,expect[i].cumtk);
+		auto ev = expect[i].ev;
+		ev.set_delta_time(flat[i].delta_time());
+		EXPECT_EQ(flat[i],ev);
+	}
+	EXPECT_TRUE(jmid::is_eot(flat.back()));
+	EXPECT_EQ(flat.nticks(),nticks);
+
+	// No tracks
+	auto empty = jmid::flatten_mtrks(jmid::smf_t());
+	ASSERT_EQ(empty.size(),1);
+	EXPECT_TRUE(jmid::is_eot(empty[0]));
+	EXPECT_EQ(empty.nticks(),0);
+}
+
@@ -0,0 +1,207 @@
+#include "gtest/gtest.h"
+#include "smf_view_t.h"
+#include "smf_t.h"
+#include "mtrk_t.h"
+#include "mtrk_event_t.h"
+#include "make_mtrk_event.h"
+#include "mtrk_test_data.h"
+#include <vector>
+#include <cstdint>
+#include <random>
+
+
+namespace smf_view_tests {
+// Builds a byte sequence that is usually, but not always, a valid mtrk
+// event.  Bytes are drawn from a set weighted toward status bytes and
+// short vlq fields so that all branches of the event parser are taken.
+std::vector<unsigned char> random_event_bytes(std::mt19937& re) {
+	std::uniform_int_distribution<int> rd_sz(0,12);
+	std::uniform_int_distribution<int> rd_byte(0,0xFF);
+	std::uniform_int_distribution<int> rd_sel(0,9);
+	std::vector<unsigned char> result;
+	auto sz = rd_sz(re);
+	for (int i=0; i<sz; ++i) {
+		auto sel = rd_sel(re);
+		if (i==1 && sel<3) {
+			result.push_back(0xFFu);
+		} else if (i==1 && sel<4) {
+			result.push_back(0xF0u);
+		} else if (sel<6) {
+			result.push_back(rd_byte(re)&0x07u);
+		} else {
+			result.push_back(rd_byte(re));
+		}
+	}
+	return result;
+}
+}  // namespace smf_view_tests
+
+
+//
+// read_mtrk_event_view() must report the same error and return the same
+// iterator as make_mtrk_event3() for any input.
+//
+TEST(smf_view_t_tests, ReadMtrkEventViewMatchesMakeMtrkEvent3Random) {
+	std::mt19937 re(1234);
+	std::vector<unsigned char> rs_vals {0x00u,0x90u,0xC3u,0xFFu,0x3Cu};
+	for (int i=0; i<20000; ++i) {
+		auto bytes = smf_view_tests::random_event_bytes(re);
+		for (const auto& rs : rs_vals) {
+			const unsigned char *beg = bytes.data();
+			const unsigned char *end = bytes.data()+bytes.size();
+
+			jmid::mtrk_event_t expect_ev;
+			jmid::mtrk_event_error_t expect_err;
+			auto expect_it = jmid::make_mtrk_event3(beg,end,rs,
+				&expect_ev,&expect_err);
+
+			jmid::mtrk_event_view_t ev;
+			jmid::mtrk_event_error_t err;
+			auto it = jmid::read_mtrk_event_view(beg,end,rs,&ev,&err);
+
+			ASSERT_EQ(err.code,expect_err.code);
+			ASSERT_EQ(it-beg,expect_it-beg);
+			if (err.code == jmid::mtrk_event_error_t::errc::no_error) {
+				EXPECT_EQ(ev.to_mtrk_event(),expect_ev);
+				EXPECT_EQ(ev.delta_time(),expect_ev.delta_time());
+				EXPECT_EQ(ev.status_byte(),expect_ev.status_byte());
+				EXPECT_EQ(ev.running_status(),expect_ev.running_status());
+				EXPECT_EQ(ev.end(),it);
+			} else {
+				EXPECT_EQ(ev.size(),0);
+			}
+		}
+	}
+}
+
+TEST(smf_view_t_tests, ReadMtrkEventViewTestSetA) {
+	for (const auto& e : mtrk_tests::tsa) {
+		const unsigned char *beg = e.d.data();
+		const unsigned char *end = e.d.data()+e.d.size();
+		auto expect = jmid::make_mtrk_event3(beg,end,0x00u,nullptr);
+		jmid::mtrk_event_view_t ev;
+		jmid::mtrk_event_error_t err;
+		auto it = jmid::read_mtrk_event_view(beg,end,0x00u,&ev,&err);
+		EXPECT_EQ(err.code,jmid::mtrk_event_error_t::errc::no_error);
+		EXPECT_EQ(it,end);
+		EXPECT_EQ(ev.size(),expect.size());
+		EXPECT_EQ(ev.data_size(),expect.data_size());
+		EXPECT_FALSE(ev.is_in_running_status());
+		EXPECT_EQ(ev.to_mtrk_event(),expect);
+		if (jmid::is_meta_status_byte(ev.status_byte())) {
+			EXPECT_EQ(ev.get_meta(),expect.get_meta());
+		} else if (jmid::is_channel_status_byte(ev.status_byte())) {
+			auto md = ev.get_channel_event_data();
+			auto expect_md = expect.get_channel_event_data();
+			EXPECT_EQ(md.status_nybble,expect_md.status_nybble);
+			EXPECT_EQ(md.ch,expect_md.ch);
+			EXPECT_EQ(md.p1,expect_md.p1);
+			EXPECT_EQ(md.p2,expect_md.p2);
+		}
+	}
+}
+
+//
+// Iterating over the views of each MTrk yields the same sequence of events
+// as make_smf2(); running status is carried from one event to the next.
+//
+TEST(smf_view_t_tests, SmfViewMatchesMakeSmf2) {
+	std::vector<unsigned char> bytes {
+		0x4D, 0x54, 0x68, 0x64,  // MThd
+		0x00, 0x00, 0x00, 0x06,
+		0x00, 0x01,  // Format 1
+		0x00, 0x02,  // 2 tracks
+		0x00, 0x60,  // 96 tpq
+
+		0x4D, 0x54, 0x72, 0x6B,  // MTrk
+		0x00, 0x00, 0x00, 0x0B,  // 11 bytes
+		0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+		0x00, 0xFF, 0x2F, 0x00,
+
+		0x4A, 0x55, 0x4E, 0x4B,  // JUNK
+		0x00, 0x00, 0x00, 0x02,
+		0x01, 0x02,
+
+		0x4D, 0x54, 0x72, 0x6B,  // MTrk
+		0x00, 0x00, 0x00, 0x12,  // 18 bytes
+		0x00, 0x90, 0x3C, 0x40,
+		0x60, 0x3E, 0x40,  // running status
+		0x60, 0x80, 0x3C, 0x40,
+		0x00, 0x3E, 0x40,  // running status
+		0x00, 0xFF, 0x2F, 0x00
+	};
+	const unsigned char *beg = bytes.data();
+	const unsigned char *end = bytes.data()+bytes.size();
+
+	jmid::smf_t expect;
+	jmid::smf_error_t expect_err;
+	jmid::make_smf2(beg,end,&expect,&expect_err);
+	ASSERT_EQ(expect_err.code,jmid::smf_error_t::errc::no_error);
+
+	jmid::smf_view_t smfv;
+	jmid::smf_error_t err;
+	auto it = jmid::make_smf_view(beg,end,&smfv,&err);
+	ASSERT_EQ(err.code,jmid::smf_error_t::errc::no_error);
+	EXPECT_EQ(it,end);
+	EXPECT_EQ(smfv.format(),expect.format());
+	EXPECT_EQ(smfv.division(),expect.division());
+	ASSERT_EQ(smfv.ntrks(),expect.ntrks());
+	ASSERT_EQ(smfv.nuchks(),1);
+	auto uchk = smfv.get_uchk(0);
+	EXPECT_EQ(std::vector<unsigned char>(uchk.beg,uchk.end),expect.get_uchk(0));
+
+	for (int i=0; i<smfv.ntrks(); ++i) {
+		int j=0;
+		auto trk_it = smfv[i].begin();
+		for (; trk_it!=smfv[i].end(); ++trk_it) {
+			ASSERT_LT(j,expect[i].size());
+			EXPECT_EQ(trk_it->to_mtrk_event(),expect[i][j]);
+			++j;
+		}
+		EXPECT_EQ(trk_it.error(),jmid::mtrk_event_error_t::errc::no_error);
+		EXPECT_EQ(j,expect[i].size());
+	}
+	int n_rs = 0;
+	for (const auto& ev : smfv[1]) {
+		n_rs += ev.is_in_running_status();
+	}
+	EXPECT_EQ(n_rs,2);
+}
+
+TEST(smf_view_t_tests, SmfViewInvalidEventAndOverflow) {
+	std::vector<unsigned char> bytes {
+		0x4D, 0x54, 0x68, 0x64,  // MThd
+		0x00, 0x00, 0x00, 0x06,
+		0x00, 0x00,  // Format 0
+		0x00, 0x01,  // 1 track
+		0x00, 0x60,  // 96 tpq
+
+		0x4D, 0x54, 0x72, 0x6B,  // MTrk
+		0x00, 0x00, 0x00, 0x0B,  // 11 bytes
+		0x00, 0x90, 0x3C, 0x40,
+		0x00, 0xF9, 0x00,  // 0xF9 => invalid status byte
+		0x00, 0xFF, 0x2F, 0x00
+	};
+	const unsigned char *beg = bytes.data();
+	const unsigned char *end = bytes.data()+bytes.size();
+	jmid::smf_view_t smfv;
+	jmid::smf_error_t err;
+	jmid::make_smf_view(beg,end,&smfv,&err);
+	ASSERT_EQ(err.code,jmid::smf_error_t::errc::no_error);
+	ASSERT_EQ(smfv.ntrks(),1);
+	int n = 0;
+	auto it = smfv[0].begin();
+	for (; it!=smfv[0].end(); ++it) {
+		++n;
+	}
+	EXPECT_EQ(n,1);
+	EXPECT_EQ(it.error(),jmid::mtrk_event_error_t::errc::invalid_status_byte);
+
+	// Chunk length field runs past the end of the input
+	bytes.resize(bytes.size()-2);
+	end = bytes.data()+bytes.size();
+	jmid::make_smf_view(bytes.data(),end,&smfv,&err);
+	EXPECT_EQ(err.code,jmid::smf_error_t::errc::mtrk_error);
+	EXPECT_EQ(smfv.ntrks(),0);
+}
+